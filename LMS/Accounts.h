@@ -0,0 +1,322 @@
+// Accounts, Login Throttling and Sessions
+// Staff log in with their own account instead of a shared password per role.
+//
+// AccountTable: user name -> role and a salted PBKDF2-HMAC-SHA256 hash of the
+// password (see Sha256.h), loaded once from accounts.txt. Checking a password
+// costs the account's iteration count in hashing whether or not the user
+// exists, and the hashes are compared in constant time, so neither the time
+// taken nor the answer tells a guesser which part was wrong.
+//
+// LoginThrottle: a token bucket per user name and per terminal. Every attempt
+// takes a token from both up front (a success gives them back), so a user
+// name can be guessed at USER.burst times and then once a minute, and one
+// terminal cannot spread guesses over many names. A bucket is stored as the
+// single time at which it will be full again (the generic cell rate
+// algorithm), keyed on a 64-bit hash of the name; full buckets are not stored
+// at all, so the table only holds names that failed recently.
+//
+// SessionTable: a successful login opens a session with a random 128-bit
+// token. The token is the credential: whoever presents it, on this or a later
+// connection, continues the session without the password. It expires after
+// IDLE_SECONDS without use.
+//
+// None of these lock; the LMS holds accountLock around them.
+
+#ifndef LMS_ACCOUNTS_H
+#define LMS_ACCOUNTS_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Sha256.h"
+
+enum class AccountRole : uint8_t
+{
+    Librarian,
+    Counter
+};
+
+inline const char *roleName(AccountRole role)
+{
+    return role == AccountRole::Librarian ? "librarian" : "counter";
+}
+
+// Parses "librarian" or "counter"; false for anything else
+inline bool parseRole(std::string_view text, AccountRole &role)
+{
+    if (text == "librarian")
+        role = AccountRole::Librarian;
+    else if (text == "counter")
+        role = AccountRole::Counter;
+    else
+        return false;
+    return true;
+}
+
+// Fills out with bytes from the system's random source
+inline void randomBytes(uint8_t *out, size_t size)
+{
+    std::random_device source;
+    for (size_t i = 0; i < size; i += 4)
+    {
+        uint32_t word = source();
+        memcpy(out + i, &word, std::min<size_t>(4, size - i));
+    }
+}
+
+class AccountTable
+{
+public:
+    static const size_t SALT_BYTES = 16;
+    static const uint32_t DEFAULT_ITERATIONS = 20000; // About 15 ms per check on one core
+
+    struct Account
+    {
+        AccountRole role;
+        uint32_t iterations;
+        uint8_t salt[SALT_BYTES];
+        Sha256::Digest hash;
+    };
+
+private:
+    std::unordered_map<std::string, Account> accounts;
+
+public:
+    // A new account record for password with a fresh salt
+    static Account make(AccountRole role, std::string_view password, uint32_t iterations = DEFAULT_ITERATIONS)
+    {
+        Account account;
+        account.role = role;
+        account.iterations = iterations;
+        randomBytes(account.salt, SALT_BYTES);
+        account.hash = pbkdf2Sha256(password, std::string_view((const char *)account.salt, SALT_BYTES), iterations);
+        return account;
+    }
+
+    // Whether password is the account's. With no account it hashes against a
+    // dummy one anyway and returns false, taking as long as a real check.
+    static bool verify(const Account *account, std::string_view password)
+    {
+        static const uint8_t dummySalt[SALT_BYTES] = {};
+        const uint8_t *salt = account ? account->salt : dummySalt;
+        Sha256::Digest hash = pbkdf2Sha256(password, std::string_view((const char *)salt, SALT_BYTES),
+                                           account ? account->iterations : DEFAULT_ITERATIONS);
+        if (!account)
+            return false;
+        return constantTimeEqual(hash.data(), account->hash.data(), hash.size());
+    }
+
+    // User names are 1 to 32 letters, digits, '.', '_' or '-'
+    static bool validName(std::string_view user)
+    {
+        if (user.empty() || user.size() > 32)
+            return false;
+        for (char c : user)
+            if (!isalnum((unsigned char)c) && c != '.' && c != '_' && c != '-')
+                return false;
+        return true;
+    }
+
+    // Passwords are 6 to 64 characters with no spaces, as they are read as one word
+    static bool validPassword(std::string_view password)
+    {
+        if (password.size() < 6 || password.size() > 64)
+            return false;
+        for (char c : password)
+            if (isspace((unsigned char)c) || iscntrl((unsigned char)c))
+                return false;
+        return true;
+    }
+
+    const Account *find(const std::string &user) const
+    {
+        auto it = accounts.find(user);
+        return it == accounts.end() ? nullptr : &it->second;
+    }
+
+    void set(const std::string &user, const Account &account)
+    {
+        accounts[user] = account;
+    }
+
+    size_t size() const
+    {
+        return accounts.size();
+    }
+
+    void forEach(const std::function<void(const std::string &, const Account &)> &fn) const
+    {
+        for (const auto &entry : accounts)
+            fn(entry.first, entry.second);
+    }
+};
+
+class LoginThrottle
+{
+public:
+    struct Limit
+    {
+        long long burst;   // Attempts allowed in a row
+        long long seconds; // Time for one more attempt to be allowed
+    };
+    static constexpr Limit USER = {5, 60};
+    static constexpr Limit TERMINAL = {20, 15};
+
+private:
+    std::unordered_map<uint64_t, long long> fullAt; // Key -> time its bucket is full again
+    uint64_t changes = 0;
+
+public:
+    // The bucket key of a user name (kind 'u') or terminal (kind 't'): FNV-1a of both
+    static uint64_t key(char kind, std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hash = (hash ^ (unsigned char)kind) * 1099511628211ull;
+        for (char c : name)
+            hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+        return hash;
+    }
+
+    // Seconds until the bucket has a token; 0 if it has one now
+    long long wait(uint64_t key, Limit limit, time_t now) const
+    {
+        auto it = fullAt.find(key);
+        if (it == fullAt.end())
+            return 0;
+        return std::max(0LL, it->second - (long long)now - (limit.burst - 1) * limit.seconds);
+    }
+
+    void take(uint64_t key, Limit limit, time_t now)
+    {
+        long long &at = fullAt[key];
+        at = std::max(at, (long long)now) + limit.seconds;
+        changes++;
+    }
+
+    // Returns a token taken by take()
+    void give(uint64_t key, Limit limit, time_t now)
+    {
+        auto it = fullAt.find(key);
+        if (it == fullAt.end())
+            return;
+        it->second -= limit.seconds;
+        if (it->second <= now)
+            fullAt.erase(it);
+        changes++;
+    }
+
+    // Refills the bucket
+    void reset(uint64_t key)
+    {
+        if (fullAt.erase(key))
+            changes++;
+    }
+
+    // Drops buckets that have refilled by now
+    void prune(time_t now)
+    {
+        for (auto it = fullAt.begin(); it != fullAt.end();)
+            it = it->second <= now ? fullAt.erase(it) : std::next(it);
+    }
+
+    // Restores a saved bucket
+    void set(uint64_t key, long long full)
+    {
+        fullAt[key] = full;
+    }
+
+    // Changes whenever a bucket does, so a checkpoint can skip saving them
+    uint64_t version() const
+    {
+        return changes;
+    }
+
+    size_t size() const
+    {
+        return fullAt.size();
+    }
+
+    void forEach(const std::function<void(uint64_t, long long)> &fn) const
+    {
+        for (const auto &entry : fullAt)
+            fn(entry.first, entry.second);
+    }
+};
+
+class SessionTable
+{
+public:
+    static const time_t IDLE_SECONDS = 30 * 60;
+
+    struct Session
+    {
+        std::string user;
+        AccountRole role;
+        std::string terminal; // Where it was opened
+        time_t expiresAt;
+    };
+
+private:
+    std::unordered_map<std::string, Session> sessions; // Token (32 hex digits) -> session
+    size_t pruneAt = 64;
+
+public:
+    // Opens a session and returns its token
+    std::string open(const std::string &user, AccountRole role, const std::string &terminal, time_t now)
+    {
+        if (sessions.size() >= pruneAt)
+        {
+            for (auto it = sessions.begin(); it != sessions.end();)
+                it = it->second.expiresAt <= now ? sessions.erase(it) : std::next(it);
+            pruneAt = std::max<size_t>(64, 2 * sessions.size());
+        }
+        uint8_t bytes[16];
+        randomBytes(bytes, sizeof(bytes));
+        std::string token = toHex(bytes, sizeof(bytes));
+        sessions[token] = {user, role, terminal, now + IDLE_SECONDS};
+        return token;
+    }
+
+    // The live session for token, with its idle time restarted; nullptr if it
+    // is unknown or expired
+    const Session *touch(const std::string &token, time_t now)
+    {
+        auto it = sessions.find(token);
+        if (it == sessions.end())
+            return nullptr;
+        if (it->second.expiresAt <= now)
+        {
+            sessions.erase(it);
+            return nullptr;
+        }
+        it->second.expiresAt = now + IDLE_SECONDS;
+        return &it->second;
+    }
+
+    bool close(const std::string &token)
+    {
+        return sessions.erase(token) > 0;
+    }
+
+    // Ends every session of user, e.g. after a password change
+    void closeUser(const std::string &user)
+    {
+        for (auto it = sessions.begin(); it != sessions.end();)
+            it = it->second.user == user ? sessions.erase(it) : std::next(it);
+    }
+
+    size_t size() const
+    {
+        return sessions.size();
+    }
+};
+
+#endif
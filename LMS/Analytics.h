@@ -0,0 +1,670 @@
+// Circulation Analytics
+// Running aggregates over issues and returns for the librarian's circulation
+// report, updated by issueBook/returnBook:
+//   - most borrowed titles and most active borrowers: Space-Saving heavy
+//     hitter counters (Metwally et al.), CAPACITY per shard. A counter may
+//     overstate its key's count by at most its error, and any key with more
+//     than 1/CAPACITY of its shard's events always has a counter, so the top
+//     lists cost fixed memory and are read without scanning every title,
+//   - per title: issues, returns and the sums of their times, from which the
+//     time its copies spent on loan (utilization) follows,
+//   - issues and returns per hour for the last HOUR_SLOTS hours, and issues
+//     by hour of the week over the whole period.
+//
+// Time on loan needs no pairing of issues with returns. Each loan is an
+// interval clipped to the period [since, now], so for one title
+//     busy = sum(return times) + open * now - sum(issue times) - earlier * since
+// where open is its loans still out and earlier = returns + open - issues the
+// loans that began before the period. Every aggregate is a sum, so rebuild()
+// can split years of circulation_log.txt into chunks and count them on all
+// cores in any order.
+//
+// Locking follows LoanTable: title stats and title counters are sharded by
+// bookShard and borrower counters by studentShard, and callers hold those
+// stripe locks. The hourly counters are lock-free.
+
+#ifndef LMS_ANALYTICS_H
+#define LMS_ANALYTICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Loans.h"
+
+class Analytics
+{
+public:
+    static constexpr size_t SHARDS = LoanTable::SHARDS;
+    static constexpr size_t CAPACITY = 16;     // Heavy hitter counters per shard
+    static constexpr int HOUR_SLOTS = 24 * 28; // Hourly counts kept for four weeks
+    static constexpr int WEEK_HOURS = 7 * 24;
+
+    struct TitleStats
+    {
+        uint64_t issues = 0;
+        uint64_t returns = 0;
+        int64_t issueTimes = 0;  // Sum of the issue times
+        int64_t returnTimes = 0; // Sum of the return times
+    };
+
+    // One Space-Saving counter: key was seen between count - error and count times
+    struct Counter
+    {
+        uint64_t key;
+        uint64_t count;
+        uint64_t error;
+    };
+
+    // The counters of one shard. With so few of them a linear scan beats any
+    // index, and adding a key never allocates.
+    class TopCounters
+    {
+    private:
+        Counter counters[CAPACITY];
+        size_t used = 0;
+
+    public:
+        void add(uint64_t key)
+        {
+            size_t smallest = 0;
+            for (size_t i = 0; i < used; i++)
+            {
+                if (counters[i].key == key)
+                {
+                    counters[i].count++;
+                    return;
+                }
+                if (counters[i].count < counters[smallest].count)
+                    smallest = i;
+            }
+            if (used < CAPACITY)
+            {
+                counters[used++] = {key, 1, 0};
+                return;
+            }
+            // Evict the smallest counter; the newcomer inherits its count as error
+            Counter &victim = counters[smallest];
+            victim = {key, victim.count + 1, victim.count};
+        }
+
+        // Counters taken from exact counts (rebuild)
+        void assign(const std::vector<Counter> &exact)
+        {
+            used = std::min(exact.size(), CAPACITY);
+            std::copy(exact.begin(), exact.begin() + used, counters);
+        }
+
+        const Counter *begin() const { return counters; }
+        const Counter *end() const { return counters + used; }
+    };
+
+    // One ISSUE or RETURN line of the circulation log
+    struct Event
+    {
+        time_t at;
+        bool issue;
+        uint32_t reg;
+        uint64_t isbn;
+    };
+
+    // A log file to read up to size bytes of
+    struct HistoryFile
+    {
+        std::string path;
+        uint64_t size;
+    };
+
+    struct RebuildStats
+    {
+        size_t files = 0;
+        uint64_t bytes = 0;
+        uint64_t events = 0;  // Issues and returns counted
+        uint64_t skipped = 0; // Other events and unreadable lines
+        unsigned threads = 0;
+        double seconds = 0;
+    };
+
+private:
+    typedef std::unordered_map<uint64_t, TitleStats> TitleMap;
+
+    TitleMap titles[SHARDS];
+    TopCounters topTitles[SHARDS];
+    TopCounters topBorrowers[SHARDS];
+    // Per slot: the local hour number in the high 40 bits and its count in the low 24
+    std::atomic<uint64_t> hourIssues[HOUR_SLOTS] = {};
+    std::atomic<uint64_t> hourReturns[HOUR_SLOTS] = {};
+    std::atomic<uint64_t> weekIssues[WEEK_HOURS] = {};
+    std::atomic<uint64_t> issueTotal{0};
+    std::atomic<uint64_t> returnTotal{0};
+    time_t since;
+    long utcOffset; // Seconds local time is ahead of UTC, for hours of the day
+
+    static constexpr int COUNT_BITS = 24;
+
+    static void bump(std::atomic<uint64_t> &slot, int64_t hour, uint64_t count = 1)
+    {
+        uint64_t old = slot.load(std::memory_order_relaxed);
+        while (true)
+        {
+            int64_t slotHour = (int64_t)(old >> COUNT_BITS);
+            if (slotHour > hour)
+                return; // The slot already moved on to a later hour
+            uint64_t next = slotHour == hour ? old + count : ((uint64_t)hour << COUNT_BITS) | count;
+            if (slot.compare_exchange_weak(old, next, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    static uint64_t countAt(const std::atomic<uint64_t> &slot, int64_t hour)
+    {
+        uint64_t value = slot.load(std::memory_order_relaxed);
+        return (int64_t)(value >> COUNT_BITS) == hour ? value & ((1u << COUNT_BITS) - 1) : 0;
+    }
+
+    // Days since 1970-01-01 of a proleptic Gregorian date (Howard Hinnant's days_from_civil)
+    static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = (unsigned)(y - era * 400);
+        unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + (int64_t)doe - 719468;
+    }
+
+    static long currentUtcOffset()
+    {
+        time_t now = time(0);
+        tm local = {};
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        int64_t asUtc = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400 +
+                        local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+        return (long)(asUtc - now);
+    }
+
+    // Reads digits [from, from + count) of text as a number; -1 if any is not a digit
+    static int64_t digits(std::string_view text, size_t from, size_t count)
+    {
+        if (from + count > text.size())
+            return -1;
+        int64_t value = 0;
+        for (size_t i = from; i < from + count; i++)
+        {
+            if (text[i] < '0' || text[i] > '9')
+                return -1;
+            value = value * 10 + (text[i] - '0');
+        }
+        return value;
+    }
+
+    // Calls fn(line) for each complete line of path that starts in [begin, end),
+    // reading no further than limit. A line that starts before begin belongs
+    // to the previous range, and the last line may run past end.
+    template <typename Fn>
+    static void scanLines(const std::string &path, uint64_t begin, uint64_t end, uint64_t limit, Fn fn)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file || begin >= limit)
+            return;
+        // Starting one byte early tells whether a line starts exactly at begin
+        bool skipFirst = begin > 0;
+        uint64_t position = skipFirst ? begin - 1 : begin;
+        uint64_t lineStart = position;
+        file.seekg((std::streamoff)position);
+
+        std::vector<char> block(1 << 20);
+        std::string partial; // A line split across blocks
+        while (position < limit)
+        {
+            file.read(block.data(), (std::streamsize)std::min<uint64_t>(block.size(), limit - position));
+            size_t got = (size_t)file.gcount();
+            if (got == 0)
+                return;
+            const char *p = block.data(), *blockEnd = p + got;
+            while (p < blockEnd)
+            {
+                const char *newline = (const char *)memchr(p, '\n', blockEnd - p);
+                if (!newline)
+                {
+                    partial.append(p, blockEnd);
+                    break;
+                }
+                uint64_t next = position + (newline - block.data()) + 1;
+                if (skipFirst)
+                    skipFirst = false;
+                else if (lineStart >= end)
+                    return;
+                else if (partial.empty())
+                    fn(std::string_view(p, newline - p));
+                else
+                {
+                    partial.append(p, newline);
+                    fn(std::string_view(partial));
+                }
+                partial.clear();
+                lineStart = next;
+                p = newline + 1;
+            }
+            position += got;
+            if (!skipFirst && lineStart >= end)
+                return;
+        }
+    }
+
+    // Aggregates of one rebuild thread, merged shard by shard afterwards
+    struct Partial
+    {
+        TitleMap titles[SHARDS];
+        std::unordered_map<uint32_t, uint64_t> borrowers[SHARDS];
+        std::vector<uint64_t> hourIssues = std::vector<uint64_t>(HOUR_SLOTS);
+        std::vector<uint64_t> hourReturns = std::vector<uint64_t>(HOUR_SLOTS);
+        uint64_t weekIssues[WEEK_HOURS] = {};
+        time_t first = 0;
+        uint64_t events = 0;
+        uint64_t skipped = 0;
+    };
+
+    // Runs fn(index) for index in [0, count) on threads threads
+    template <typename Fn>
+    static void parallelFor(size_t count, unsigned threads, Fn fn)
+    {
+        std::atomic<size_t> next{0};
+        auto work = [&]
+        {
+            for (size_t i; (i = next++) < count;)
+                fn(i);
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++)
+            pool.emplace_back(work);
+        work();
+        for (auto &thread : pool)
+            thread.join();
+    }
+
+public:
+    Analytics() : since(time(0)), utcOffset(currentUtcOffset())
+    {
+    }
+
+    Analytics(const Analytics &) = delete;
+    Analytics &operator=(const Analytics &) = delete;
+
+    // Start of the period the aggregates cover
+    time_t periodStart() const
+    {
+        return since;
+    }
+
+    int64_t localHour(time_t at) const
+    {
+        return ((int64_t)at + utcOffset) / 3600;
+    }
+
+    // Local time at which local hour number hour starts
+    time_t hourStart(int64_t hour) const
+    {
+        return (time_t)(hour * 3600 - utcOffset);
+    }
+
+    // 0 = Sunday 00:00-01:00 local time, ..., 167 = Saturday 23:00-24:00
+    int hourOfWeek(time_t at) const
+    {
+        int64_t hour = localHour(at);
+        return (int)(((hour / 24 + 4) % 7) * 24 + hour % 24); // 1970-01-01 was a Thursday
+    }
+
+    void recordIssue(uint32_t reg, uint64_t isbn, time_t at)
+    {
+        TitleStats &title = titles[LoanTable::bookShard(isbn)][isbn];
+        title.issues++;
+        title.issueTimes += at;
+        topTitles[LoanTable::bookShard(isbn)].add(isbn);
+        topBorrowers[LoanTable::studentShard(reg)].add(reg);
+        int64_t hour = localHour(at);
+        bump(hourIssues[hour % HOUR_SLOTS], hour);
+        weekIssues[hourOfWeek(at)].fetch_add(1, std::memory_order_relaxed);
+        issueTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void recordReturn(uint64_t isbn, time_t at)
+    {
+        TitleStats &title = titles[LoanTable::bookShard(isbn)][isbn];
+        title.returns++;
+        title.returnTimes += at;
+        int64_t hour = localHour(at);
+        bump(hourReturns[hour % HOUR_SLOTS], hour);
+        returnTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record(const Event &event)
+    {
+        if (event.issue)
+            recordIssue(event.reg, event.isbn, event.at);
+        else
+            recordReturn(event.isbn, event.at);
+    }
+
+    uint64_t issues() const
+    {
+        return issueTotal.load(std::memory_order_relaxed);
+    }
+
+    uint64_t returns() const
+    {
+        return returnTotal.load(std::memory_order_relaxed);
+    }
+
+    const TitleStats *title(uint64_t isbn) const
+    {
+        const TitleMap &map = titles[LoanTable::bookShard(isbn)];
+        auto it = map.find(isbn);
+        return it == map.end() ? nullptr : &it->second;
+    }
+
+    // Calls fn(isbn, stats) for every title issued or returned in the period
+    template <typename Fn>
+    void forEachTitle(Fn fn) const
+    {
+        for (const auto &map : titles)
+            for (const auto &entry : map)
+                fn(entry.first, entry.second);
+    }
+
+    // Seconds the title's copies spent on loan during the period, given its
+    // loans still open now
+    int64_t busySeconds(uint64_t isbn, size_t open, time_t now) const
+    {
+        static const TitleStats none;
+        const TitleStats *stats = title(isbn);
+        if (!stats)
+            stats = &none;
+        int64_t earlier = (int64_t)(stats->returns + open) - (int64_t)stats->issues;
+        int64_t busy = stats->returnTimes + (int64_t)open * now - stats->issueTimes - earlier * since;
+        return std::max<int64_t>(busy, 0);
+    }
+
+    // The most frequent titles (by ISBN) or borrowers (by packed reg. number),
+    // largest count first, at most limit of them
+    std::vector<Counter> topTitleCounters(size_t limit) const
+    {
+        return top(topTitles, limit);
+    }
+
+    std::vector<Counter> topBorrowerCounters(size_t limit) const
+    {
+        return top(topBorrowers, limit);
+    }
+
+    static std::vector<Counter> top(const TopCounters (&shards)[SHARDS], size_t limit)
+    {
+        std::vector<Counter> all;
+        for (const auto &shard : shards)
+            all.insert(all.end(), shard.begin(), shard.end());
+        size_t keep = std::min(limit, all.size());
+        std::partial_sort(all.begin(), all.begin() + keep, all.end(), [](const Counter &a, const Counter &b)
+                          { return a.count != b.count ? a.count > b.count : a.key < b.key; });
+        all.resize(keep);
+        return all;
+    }
+
+    // Issues and returns in local hour number hour (0 once it is older than HOUR_SLOTS hours)
+    uint64_t issuesInHour(int64_t hour) const
+    {
+        return countAt(hourIssues[hour % HOUR_SLOTS], hour);
+    }
+
+    uint64_t returnsInHour(int64_t hour) const
+    {
+        return countAt(hourReturns[hour % HOUR_SLOTS], hour);
+    }
+
+    // Issues in an hour of the week (see hourOfWeek) over the whole period
+    uint64_t issuesInHourOfWeek(int hour) const
+    {
+        return weekIssues[hour].load(std::memory_order_relaxed);
+    }
+
+    // Reads "<timestamp> ISSUE|RETURN <reg> <isbn>"; false for other events and
+    // bad lines. The timestamp is ISO-8601 UTC or epoch milliseconds (AuditLog).
+    static bool parseEvent(std::string_view line, Event &event)
+    {
+        size_t space = line.find(' ');
+        if (space == std::string_view::npos)
+            return false;
+        if (space >= 19 && line[10] == 'T')
+        {
+            int64_t y = digits(line, 0, 4), mo = digits(line, 5, 2), d = digits(line, 8, 2);
+            int64_t h = digits(line, 11, 2), mi = digits(line, 14, 2), s = digits(line, 17, 2);
+            if (y < 0 || mo < 1 || mo > 12 || d < 1 || d > 31 || h < 0 || mi < 0 || s < 0)
+                return false;
+            event.at = (time_t)(daysFromCivil(y, (unsigned)mo, (unsigned)d) * 86400 + h * 3600 + mi * 60 + s);
+        }
+        else
+        {
+            int64_t millis = digits(line, 0, space);
+            if (millis < 0)
+                return false;
+            event.at = (time_t)(millis / 1000);
+        }
+        std::string_view rest = line.substr(space + 1);
+        if (rest.compare(0, 6, "ISSUE ") == 0)
+        {
+            event.issue = true;
+            rest.remove_prefix(6);
+        }
+        else if (rest.compare(0, 7, "RETURN ") == 0)
+        {
+            event.issue = false;
+            rest.remove_prefix(7);
+        }
+        else
+            return false;
+        int64_t reg = digits(rest, 0, 8), isbn = digits(rest, 9, 13);
+        if (reg < 0 || isbn < 0 || rest[8] != ' ')
+            return false;
+        event.reg = (uint32_t)reg;
+        event.isbn = (uint64_t)isbn;
+        return true;
+    }
+
+    // Calls fn(event) for each issue and return in [begin, limit) of path, in file order
+    template <typename Fn>
+    static void scanEvents(const std::string &path, uint64_t begin, uint64_t limit, Fn fn)
+    {
+        Event event;
+        scanLines(path, begin, limit, limit, [&](std::string_view line)
+                  {
+            if (parseEvent(line, event))
+                fn(event); });
+    }
+
+    // Fills this (freshly constructed) object from the issue and return events
+    // in files, using threads threads (0 = one per core). The files are cut into
+    // chunks that the threads take in turn, and their per-thread aggregates are
+    // then merged shard by shard, also in parallel. The period starts at the
+    // first event read.
+    void rebuild(const std::vector<HistoryFile> &files, unsigned threads, time_t now, RebuildStats *stats = nullptr)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        struct Chunk
+        {
+            size_t file;
+            uint64_t begin, end;
+        };
+        uint64_t bytes = 0;
+        for (const auto &file : files)
+            bytes += file.size;
+        uint64_t chunkSize = std::max<uint64_t>(bytes / (threads * 8) + 1, 1 << 20);
+        std::vector<Chunk> chunks;
+        for (size_t f = 0; f < files.size(); f++)
+            for (uint64_t begin = 0; begin < files[f].size; begin += chunkSize)
+                chunks.push_back({f, begin, std::min(begin + chunkSize, files[f].size)});
+        threads = (unsigned)std::max<size_t>(1, std::min<size_t>(threads, chunks.size()));
+
+        int64_t firstHour = localHour(now) - HOUR_SLOTS + 1;
+        std::vector<Partial> partials(threads);
+        std::atomic<size_t> nextChunk{0};
+        auto count = [&](Partial &partial)
+        {
+            for (size_t c; (c = nextChunk++) < chunks.size();)
+            {
+                const Chunk &chunk = chunks[c];
+                const HistoryFile &file = files[chunk.file];
+                scanLines(file.path, chunk.begin, chunk.end, file.size, [&](std::string_view line)
+                          {
+                    Event event;
+                    if (!parseEvent(line, event))
+                    {
+                        partial.skipped++;
+                        return;
+                    }
+                    partial.events++;
+                    partial.first = partial.first ? std::min(partial.first, event.at) : event.at;
+                    TitleStats &title = partial.titles[LoanTable::bookShard(event.isbn)][event.isbn];
+                    int64_t slot = localHour(event.at) - firstHour;
+                    if (event.issue)
+                    {
+                        title.issues++;
+                        title.issueTimes += event.at;
+                        partial.borrowers[LoanTable::studentShard(event.reg)][event.reg]++;
+                        partial.weekIssues[hourOfWeek(event.at)]++;
+                        if (slot >= 0 && slot < HOUR_SLOTS)
+                            partial.hourIssues[slot]++;
+                    }
+                    else
+                    {
+                        title.returns++;
+                        title.returnTimes += event.at;
+                        if (slot >= 0 && slot < HOUR_SLOTS)
+                            partial.hourReturns[slot]++;
+                    } });
+            }
+        };
+        {
+            std::vector<std::thread> pool;
+            for (unsigned t = 1; t < threads; t++)
+                pool.emplace_back(count, std::ref(partials[t]));
+            count(partials[0]);
+            for (auto &thread : pool)
+                thread.join();
+        }
+
+        // Merge each shard's titles and borrowers, and take its heaviest keys as exact counters
+        auto byCount = [](const Counter &a, const Counter &b)
+        { return a.count != b.count ? a.count > b.count : a.key < b.key; };
+        parallelFor(SHARDS, threads, [&](size_t shard)
+                    {
+            TitleMap &merged = titles[shard];
+            merged = std::move(partials[0].titles[shard]);
+            std::unordered_map<uint32_t, uint64_t> borrowers = std::move(partials[0].borrowers[shard]);
+            for (unsigned t = 1; t < threads; t++)
+            {
+                for (const auto &entry : partials[t].titles[shard])
+                {
+                    TitleStats &title = merged[entry.first];
+                    title.issues += entry.second.issues;
+                    title.returns += entry.second.returns;
+                    title.issueTimes += entry.second.issueTimes;
+                    title.returnTimes += entry.second.returnTimes;
+                }
+                for (const auto &entry : partials[t].borrowers[shard])
+                    borrowers[entry.first] += entry.second;
+                TitleMap().swap(partials[t].titles[shard]);
+            }
+
+            std::vector<Counter> heaviest;
+            for (const auto &entry : merged)
+                if (entry.second.issues)
+                    heaviest.push_back({entry.first, entry.second.issues, 0});
+            size_t keep = std::min(CAPACITY, heaviest.size());
+            std::partial_sort(heaviest.begin(), heaviest.begin() + keep, heaviest.end(), byCount);
+            heaviest.resize(keep);
+            topTitles[shard].assign(heaviest);
+
+            heaviest.clear();
+            for (const auto &entry : borrowers)
+                heaviest.push_back({entry.first, entry.second, 0});
+            keep = std::min(CAPACITY, heaviest.size());
+            std::partial_sort(heaviest.begin(), heaviest.begin() + keep, heaviest.end(), byCount);
+            heaviest.resize(keep);
+            topBorrowers[shard].assign(heaviest); });
+
+        uint64_t events = 0, skipped = 0, issued = 0, returned = 0;
+        time_t first = 0;
+        for (const auto &partial : partials)
+        {
+            events += partial.events;
+            skipped += partial.skipped;
+            if (partial.first)
+                first = first ? std::min(first, partial.first) : partial.first;
+            for (int h = 0; h < HOUR_SLOTS; h++)
+            {
+                if (partial.hourIssues[h])
+                    bump(hourIssues[(firstHour + h) % HOUR_SLOTS], firstHour + h, partial.hourIssues[h]);
+                if (partial.hourReturns[h])
+                    bump(hourReturns[(firstHour + h) % HOUR_SLOTS], firstHour + h, partial.hourReturns[h]);
+            }
+            for (int h = 0; h < WEEK_HOURS; h++)
+            {
+                weekIssues[h].fetch_add(partial.weekIssues[h], std::memory_order_relaxed);
+                issued += partial.weekIssues[h];
+            }
+        }
+        returned = events - issued;
+        issueTotal.store(issued, std::memory_order_relaxed);
+        returnTotal.store(returned, std::memory_order_relaxed);
+        since = first ? std::min(first, now) : now;
+
+        if (stats)
+        {
+            stats->files = files.size();
+            stats->bytes = bytes;
+            stats->events = events;
+            stats->skipped = skipped;
+            stats->threads = threads;
+            stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    // Takes over the contents of other (a rebuilt copy); callers hold every
+    // stripe lock, e.g. through the exclusive catalog lock
+    void replaceWith(Analytics &other)
+    {
+        for (size_t s = 0; s < SHARDS; s++)
+        {
+            titles[s].swap(other.titles[s]);
+            topTitles[s] = other.topTitles[s];
+            topBorrowers[s] = other.topBorrowers[s];
+        }
+        for (int h = 0; h < HOUR_SLOTS; h++)
+        {
+            hourIssues[h].store(other.hourIssues[h].load());
+            hourReturns[h].store(other.hourReturns[h].load());
+        }
+        for (int h = 0; h < WEEK_HOURS; h++)
+            weekIssues[h].store(other.weekIssues[h].load());
+        issueTotal.store(other.issueTotal.load());
+        returnTotal.store(other.returnTotal.load());
+        since = other.since;
+        utcOffset = other.utcOffset;
+    }
+};
+
+#endif
@@ -0,0 +1,376 @@
+// Audit Log
+// Asynchronous, append-only event log (login_log.txt, circulation_log.txt).
+// Callers never touch the file: write() stamps the event with the current
+// time and copies it into a fixed-size lock-free ring buffer (bounded
+// multi-producer queue, one sequence number per slot), which costs a few
+// atomic operations and no system call. If the ring is full the caller waits
+// for the writer to free a slot at most maxWait and then drops the event (and
+// counts it), so a caller, who may hold the library's locks, is never blocked
+// for longer than that by a slow disk. The writer drains a full ring in well
+// under a millisecond, so only a stalled disk makes events drop. A log passed
+// BLOCK waits as long as it takes instead.
+//
+// A background thread drains the ring, formats the timestamps and writes the
+// lines in batches: once FLUSH_BYTES are pending or FLUSH_INTERVAL has passed
+// since the first pending line, whichever comes first. Everything still queued
+// is written when the log is destroyed. Lines the file does not take (it could
+// not be opened, or a write failed) are counted as dropped too.
+//
+// When a write would take the file past maxBytes it is rotated:
+// file.(keep-1) is dropped, file.1 -> file.2, ..., file -> file.1.
+// flush() waits until everything queued so far is in the file, for readers
+// of the log such as the circulation analytics rebuild.
+//
+// Line format: <timestamp> <message>, where the timestamp is ISO-8601 UTC with
+// milliseconds (2024-05-01T09:30:12.345Z) or epoch milliseconds.
+
+#ifndef LMS_AUDITLOG_H
+#define LMS_AUDITLOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+inline bool utcTime(time_t t, tm &out) { return gmtime_s(&out, &t) == 0; }
+#else
+#include <unistd.h>
+inline bool utcTime(time_t t, tm &out) { return gmtime_r(&t, &out) != nullptr; }
+#endif
+
+class AuditLog
+{
+public:
+    enum class TimeFormat
+    {
+        Iso8601,
+        EpochMillis
+    };
+
+    static constexpr size_t MAX_MESSAGE = 240; // Longer messages are truncated
+    static constexpr size_t RING_SLOTS = 4096;  // Power of two
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+    static constexpr std::chrono::microseconds BLOCK = std::chrono::microseconds::max(); // Wait, never drop
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        int64_t timeMillis;
+        uint32_t length;
+        char text[MAX_MESSAGE];
+    };
+
+    std::vector<Slot> ring;
+    alignas(64) std::atomic<size_t> head{0}; // Next slot to claim (producers)
+    alignas(64) size_t tail = 0;             // Next slot to read (writer thread only)
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> rotations{0};
+
+    // flush() asks for every event up to flushWanted; the writer reports
+    // flushedTo (the events in the file) under flushLock
+    std::atomic<size_t> flushWanted{0};
+    std::mutex flushLock;
+    std::condition_variable flushed;
+    size_t flushedTo = 0;
+
+    std::string path;
+    TimeFormat format;
+    size_t maxBytes;
+    int keepFiles;
+    std::chrono::microseconds maxWait;
+    int fd = -1;
+    size_t fileBytes = 0;
+    size_t buffered = 0; // Events in the writer's buffer (writer thread only)
+
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+
+    static int64_t nowMillis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // The date and time up to the seconds only change once a second, so the
+    // writer formats them once and reuses them (writer thread only)
+    int64_t cachedSecond = -1;
+    char cachedPrefix[32];
+    int cachedLength = 0;
+
+    void appendTimestamp(std::string &out, int64_t millis)
+    {
+        char stamp[32];
+        tm t;
+        if (format == TimeFormat::EpochMillis)
+        {
+            out.append(stamp, snprintf(stamp, sizeof(stamp), "%lld", (long long)millis));
+            return;
+        }
+        if (millis / 1000 != cachedSecond)
+        {
+            cachedSecond = millis / 1000;
+            cachedLength = 0;
+            if (utcTime((time_t)cachedSecond, t))
+                cachedLength = snprintf(cachedPrefix, sizeof(cachedPrefix), "%04d-%02d-%02dT%02d:%02d:%02d",
+                                        t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+        }
+        out.append(cachedPrefix, cachedLength);
+        out.append(stamp, snprintf(stamp, sizeof(stamp), ".%03dZ", (int)(millis % 1000)));
+    }
+
+    void openFile()
+    {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        struct stat info;
+        fileBytes = fd >= 0 && fstat(fd, &info) == 0 ? (size_t)info.st_size : 0;
+    }
+
+    void rotate()
+    {
+        ::close(fd);
+        for (int i = keepFiles - 1; i >= 1; i--)
+        {
+            std::string from = i == 1 ? path : path + "." + std::to_string(i - 1);
+            std::rename(from.c_str(), (path + "." + std::to_string(i)).c_str());
+        }
+        if (keepFiles <= 1)
+            std::remove(path.c_str());
+        openFile();
+        rotations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Writes and empties buffer. Events whose line did not reach the file in
+    // full are counted as dropped.
+    void writeOut(std::string &buffer)
+    {
+        if (buffer.empty())
+            return;
+        if (fd >= 0 && maxBytes > 0 && fileBytes > 0 && fileBytes + buffer.size() > maxBytes)
+            rotate();
+        size_t done = 0;
+        while (fd >= 0 && done < buffer.size())
+        {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n > 0)
+                done += n;
+            else if (n < 0 && errno == EINTR)
+                continue;
+            else
+                break;
+        }
+        fileBytes += done;
+        size_t lost = done == buffer.size() ? 0 : std::count(buffer.begin() + done, buffer.end(), '\n');
+        written.fetch_add(buffered - lost, std::memory_order_relaxed);
+        dropped.fetch_add(lost, std::memory_order_relaxed);
+        buffered = 0;
+        buffer.clear();
+    }
+
+    // Moves every published slot into buffer; returns the number of events taken
+    size_t drain(std::string &buffer)
+    {
+        size_t taken = 0;
+        while (true)
+        {
+            Slot &slot = ring[tail & (RING_SLOTS - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != tail + 1)
+                return taken;
+            appendTimestamp(buffer, slot.timeMillis);
+            buffer += ' ';
+            buffer.append(slot.text, slot.length);
+            buffer += '\n';
+            slot.sequence.store(tail + RING_SLOTS, std::memory_order_release);
+            tail++;
+            taken++;
+            buffered++;
+            if (buffer.size() >= FLUSH_BYTES)
+                return taken;
+        }
+    }
+
+    void run()
+    {
+        std::string buffer;
+        buffer.reserve(FLUSH_BYTES + MAX_MESSAGE + 64);
+        auto firstPending = std::chrono::steady_clock::now();
+        size_t reported = 0; // Events known to be in the file
+        while (true)
+        {
+            bool hadPending = !buffer.empty();
+            size_t taken = drain(buffer);
+            if (!hadPending && !buffer.empty())
+                firstPending = std::chrono::steady_clock::now();
+
+            bool stop = stopping.load(std::memory_order_acquire);
+            bool asked = flushWanted.load(std::memory_order_acquire) > reported;
+            bool due = stop || asked || std::chrono::steady_clock::now() - firstPending >= FLUSH_INTERVAL;
+            if (buffer.size() >= FLUSH_BYTES || (due && !buffer.empty()))
+                writeOut(buffer);
+            if (buffer.empty() && tail != reported)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(flushLock);
+                    flushedTo = reported = tail;
+                }
+                flushed.notify_all();
+            }
+            if (stop && taken == 0 && buffer.empty())
+                return;
+            if (taken == 0)
+            {
+                std::unique_lock<std::mutex> guard(wakeLock);
+                wake.wait_for(guard, FLUSH_INTERVAL / 4);
+            }
+        }
+    }
+
+public:
+    // Appends to file, rotating it when it would grow past maxBytes (0 = never)
+    // and keeping keepFiles files in total including the current one
+    explicit AuditLog(const std::string &file, TimeFormat timeFormat = TimeFormat::Iso8601,
+                      size_t maxBytes = 4 * 1024 * 1024, int keepFiles = 4,
+                      std::chrono::microseconds maxWait = std::chrono::milliseconds(2))
+        : ring(RING_SLOTS), path(file), format(timeFormat), maxBytes(maxBytes), keepFiles(keepFiles), maxWait(maxWait)
+    {
+        for (size_t i = 0; i < RING_SLOTS; i++)
+            ring[i].sequence.store(i, std::memory_order_relaxed);
+        openFile();
+        writer = std::thread(&AuditLog::run, this);
+    }
+
+    AuditLog(const AuditLog &) = delete;
+    AuditLog &operator=(const AuditLog &) = delete;
+
+    ~AuditLog()
+    {
+        stopping.store(true, std::memory_order_release);
+        wake.notify_one();
+        writer.join();
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    // Queues one event; returns false if it was dropped because the ring
+    // stayed full for maxWait (never with BLOCK)
+    bool write(std::string_view message)
+    {
+        int64_t millis = nowMillis();
+        size_t position = head.load(std::memory_order_relaxed);
+        Slot *slot;
+        std::chrono::steady_clock::time_point deadline{};
+        while (true)
+        {
+            slot = &ring[position & (RING_SLOTS - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence == position)
+            {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (sequence < position)
+            {
+                // Full: let the writer catch up, unless that takes longer than maxWait
+                auto now = std::chrono::steady_clock::now();
+                if (deadline == std::chrono::steady_clock::time_point{})
+                {
+                    deadline = maxWait == BLOCK ? std::chrono::steady_clock::time_point::max() : now + maxWait;
+                    wake.notify_one();
+                }
+                else if (now >= deadline)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                std::this_thread::yield();
+                position = head.load(std::memory_order_relaxed);
+            }
+            else
+                position = head.load(std::memory_order_relaxed);
+        }
+
+        slot->timeMillis = millis;
+        slot->length = (uint32_t)std::min(message.size(), MAX_MESSAGE);
+        memcpy(slot->text, message.data(), slot->length);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        // The writer polls on its own; during a burst it is woken every quarter
+        // ring so it drains the events before the ring fills up
+        if (((position + 1) & (RING_SLOTS / 4 - 1)) == 0)
+            wake.notify_one();
+        return true;
+    }
+
+    // Events dropped because the ring stayed full for maxWait or the file did not take them
+    uint64_t droppedCount() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    // Events written to the file so far
+    uint64_t writtenCount() const
+    {
+        return written.load(std::memory_order_relaxed);
+    }
+
+    // Waits until every event queued before the call has been written out
+    void flush()
+    {
+        size_t target = head.load(std::memory_order_acquire);
+        size_t wanted = flushWanted.load(std::memory_order_relaxed);
+        while (wanted < target && !flushWanted.compare_exchange_weak(wanted, target, std::memory_order_release))
+        {
+        }
+        wake.notify_one();
+        std::unique_lock<std::mutex> guard(flushLock);
+        flushed.wait(guard, [&]
+                     { return flushedTo >= target; });
+    }
+
+    // Times the file has been rotated since the log was opened
+    uint64_t rotationCount() const
+    {
+        return rotations.load(std::memory_order_relaxed);
+    }
+
+    // The rotated files that exist, oldest first, then the current file
+    std::vector<std::string> files() const
+    {
+        std::vector<std::string> existing;
+        struct stat info;
+        for (int i = keepFiles - 1; i >= 1; i--)
+        {
+            std::string rotated = path + "." + std::to_string(i);
+            if (stat(rotated.c_str(), &info) == 0)
+                existing.push_back(rotated);
+        }
+        existing.push_back(path);
+        return existing;
+    }
+
+    const std::string &filePath() const
+    {
+        return path;
+    }
+};
+
+#endif
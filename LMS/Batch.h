@@ -0,0 +1,515 @@
+// Batch Commands
+// Line-delimited command language for driving the LMS API without prompts.
+// One command per line; blank lines and lines starting with # are skipped.
+//
+//   issue <reg> <isbn> [branch]
+//   return <reg> <isbn> [branch]
+//                          -> OK [FINE <amount>] [HOLD <reg>] (fine for a late return; copy set aside for a hold)
+//   hold <reg> <isbn>      -> OK <position in queue>
+//   cancelhold <reg> <isbn>
+//   holds [n]              -> OK <n> <isbn>:<waiting>:<ready> ... (longest queues first, default 20)
+//   overdue [n]            -> OK <n> <reg>:<isbn>:<days late> ... (most overdue first, default 20)
+//   due <days> [n]         -> OK <n> <reg>:<isbn>:<due epoch> ... (due within the next <days> days)
+//   fine <reg>             -> OK <amount owed>
+//   payfine <reg> <amount> -> OK <amount still owed>
+//   sweep                  -> OK <loans charged> <amount> (fines are also swept daily by themselves)
+//   analytics titles|utilized [n]
+//                          -> OK <n> <isbn>:<issues> ... (utilized: <isbn>:<percent on loan>; default 10)
+//   analytics borrowers [n]
+//                          -> OK <n> <reg>:<issues>:<error> ... (issues may be up to error too high)
+//   analytics hours [n]    -> OK <n> <hour start epoch>:<issues>:<returns> ... (last n hours, default 24)
+//   analytics rebuild [threads]
+//                          -> OK <issues and returns read> <seconds> (from circulation_log.txt)
+//   utilization <isbn>     -> OK <issues> <percent of the period on loan>
+//   addbook <isbn> <copies> <title>|<author>
+//   delbook <isbn> <copies>
+//   update <isbn> <copies> [branch]
+//   where <isbn>           -> OK <n> <branch>:<copies> ... (copies on the shelf at every branch, main first)
+//   transfer <isbn> <from branch> <to branch> <copies>
+//   branches               -> OK <n> <branch>:<copies> ... (copies on the shelf at each branch)
+//   addbranch <name>
+//   addstudent <first> <last> <reg> <phone> <email>
+//   find <isbn>            -> OK <copies> <title>|<author>
+//   student <reg>          -> OK <first> <last> <phone> <email> <books issued>
+//   findstudent <reg|phone|email>
+//                          -> OK <n> <reg> ...
+//   search <words>         -> OK <n> <isbn> ... (first 20 matches by title)
+//   fuzzy <words>          -> OK <n> <isbn>:<edits> ... (20 closest titles, allowing typos)
+//   fuzzystudent <name>    -> OK <n> <reg>:<edits> ... (20 closest student names)
+//   list [title|author|copies] [available] [after <isbn>]
+//                          -> OK <n> <isbn> ... (one page of 20; pass the last ISBN as "after")
+//   liststudents [name|reg] [after <reg>]
+//                          -> OK <n> <reg> ...
+//   checkpoint
+//   snapshot               (checkpoint and start a history snapshot now)
+//   history                -> OK <n> <snapshot epoch> ... (oldest first)
+//   restore <time> <name>  -> OK <snapshot epoch> <records replayed> <books> <students> <loans>
+//                             (<time> is YYYY-MM-DD[THH:MM[:SS]] local time or epoch seconds; the copy
+//                             goes to restores/<name> in the data directory)
+//   metrics [name.prom]    -> OK <path> (Prometheus text format, written to the data directory; default metrics.prom)
+//   login <user> <password>
+//                          -> OK <session token> librarian|counter, DENIED, or THROTTLED <seconds to wait>
+//   resume <token>         -> OK <user> <role> (continue a session from an earlier connection)
+//   logout
+//   addaccount <user> librarian|counter <password>
+//   passwd <user> <password>
+//   accounts               -> OK <n> <user>:<role> ... (by name)
+//
+// Each command produces one response line: OK (plus any data) or the status
+// name (NOT_FOUND, UNAVAILABLE, LIMIT_REACHED, ...), or ERROR for bad syntax.
+// Commands taking an optional branch use the main branch without one.
+//
+// A stream logs in once and its later commands run under that session; the
+// session is checked with a hash lookup rather than the password. The account
+// commands need a librarian session. When the session requires a login (as
+// server connections do unless --no-login), every other command needs one too, and the
+// commands of the Librarian menu (catalog and student changes, branches,
+// analytics, checkpoints and history) need a librarian.
+
+#ifndef LMS_BATCH_H
+#define LMS_BATCH_H
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "LMS.h"
+
+// Parses "<n>" as a non-negative int; returns -1 if it is not one
+inline int parseCount(const string &text)
+{
+    if (text.empty() || text.size() > 9 || !isAllDigits(text, text.size()))
+        return -1;
+    return stoi(text);
+}
+
+// Login state of one batch run or server connection
+struct BatchSession
+{
+    string terminal = "batch"; // Where its logins are throttled and logged as coming from
+    bool requireLogin = false; // Only login and resume run without a session
+    string token;              // Session opened by login or resume; empty if none
+};
+
+// Commands a counter session may not run when logins are required
+inline bool librarianOnly(const string &command)
+{
+    static const char *commands[] = {"addbook", "delbook", "update", "addbranch", "transfer", "addstudent",
+                                     "sweep", "holds", "analytics", "utilization", "checkpoint", "snapshot",
+                                     "history", "restore", "metrics"};
+    for (const char *name : commands)
+        if (command == name)
+            return true;
+    return false;
+}
+
+// Executes one command line for session and returns its response (without a newline)
+inline string executeCommand(LMS &library, const string &line, BatchSession &session)
+{
+    istringstream in(line);
+    string command, a, b;
+    in >> command;
+
+    if (command == "login" && in >> a >> b)
+    {
+        LoginInfo info;
+        Status status = library.login(a, b, session.terminal, &info);
+        if (status == Status::Throttled)
+            return "THROTTLED " + to_string(info.retryAfter);
+        if (status != Status::Ok)
+            return statusName(status);
+        if (!session.token.empty())
+            library.logout(session.token);
+        session.token = info.token;
+        return "OK " + info.token + " " + roleName(info.role);
+    }
+    if (command == "resume" && in >> a)
+    {
+        AccountRole role;
+        string user;
+        Status status = library.resume(a, &role, &user);
+        if (status != Status::Ok)
+            return statusName(status);
+        session.token = a;
+        return "OK " + user + " " + roleName(role);
+    }
+    if (command == "logout")
+    {
+        Status status = session.token.empty() ? Status::NotFound : library.logout(session.token);
+        session.token.clear();
+        return statusName(status);
+    }
+
+    bool accountCommand = command == "addaccount" || command == "passwd" || command == "accounts";
+    if (session.requireLogin || accountCommand)
+    {
+        AccountRole role;
+        if (session.token.empty() || library.resume(session.token, &role) != Status::Ok)
+            return statusName(Status::Denied);
+        if (role != AccountRole::Librarian && (accountCommand || librarianOnly(command)))
+            return statusName(Status::Denied);
+    }
+
+    string branch;
+    if (command == "issue" && in >> a >> b)
+        return statusName(library.issueBook(a, b, in >> branch ? branch : ""));
+    if (command == "return" && in >> a >> b)
+    {
+        ReturnInfo info;
+        Status status = library.returnBook(a, b, &info, in >> branch ? branch : "");
+        if (status != Status::Ok)
+            return statusName(status);
+        string response = "OK";
+        if (info.fine > 0)
+            response += " FINE " + to_string(info.fine);
+        if (!info.notices.empty())
+            response += " HOLD " + info.notices[0].regNumber;
+        return response;
+    }
+    if (command == "hold" && in >> a >> b)
+    {
+        size_t position = 0;
+        Status status = library.placeHold(a, b, &position);
+        return status == Status::Ok ? "OK " + to_string(position) : statusName(status);
+    }
+    if (command == "cancelhold" && in >> a >> b)
+        return statusName(library.cancelHold(a, b));
+    if (command == "overdue" || (command == "due" && in >> a))
+    {
+        bool overdue = command == "overdue";
+        int days = overdue ? 0 : parseCount(a);
+        int limit = in >> b ? parseCount(b) : 20;
+        if (days < 0 || limit < 0)
+            return "ERROR expected a number";
+        time_t now = time(0);
+        vector<DueLoan> loans = overdue ? library.overdueLoans(limit) : library.dueLoans(now, now + days * 86400LL, limit);
+        string response = "OK " + to_string(loans.size());
+        for (const auto &loan : loans)
+            response += " " + loan.regNumber + ":" + loan.isbn + ":" + to_string(overdue ? loan.daysLate : (long long)loan.dueAt);
+        return response;
+    }
+    if (command == "fine" && in >> a)
+        return "OK " + to_string(library.fineBalance(a));
+    if (command == "payfine" && in >> a >> b)
+    {
+        long long remaining = 0;
+        Status status = library.payFine(a, parseCount(b), &remaining);
+        return status == Status::Ok ? "OK " + to_string(remaining) : statusName(status);
+    }
+    if (command == "sweep")
+    {
+        FineSweepReport report = library.sweepFines();
+        return "OK " + to_string(report.charged) + " " + to_string(report.amount);
+    }
+    if (command == "holds")
+    {
+        int limit = in >> a ? parseCount(a) : 20;
+        if (limit < 0)
+            return "ERROR expected a number of titles";
+        vector<HoldQueueInfo> queues = library.holdQueues(limit);
+        string response = "OK " + to_string(queues.size());
+        for (const auto &queue : queues)
+            response += " " + queue.isbn + ":" + to_string(queue.waiting) + ":" + to_string(queue.ready);
+        return response;
+    }
+    if (command == "analytics" && in >> a)
+    {
+        int count = in >> b ? parseCount(b) : a == "hours" ? 24 : a == "rebuild" ? 0 : 10;
+        if (count < 0)
+            return "ERROR expected a number";
+        if (a == "rebuild")
+        {
+            Analytics::RebuildStats stats = library.rebuildAnalytics(count);
+            return "OK " + to_string(stats.events) + " " + to_string(stats.seconds);
+        }
+        CirculationReport report = library.circulationReport(count, count);
+        string response;
+        size_t n = 0;
+        if (a == "titles" || a == "utilized")
+            for (const auto &title : a == "titles" ? report.mostBorrowed : report.mostUtilized)
+            {
+                response += " " + title.isbn + ":" +
+                            to_string(a == "titles" ? (long long)title.issues : (long long)(title.utilization * 100 + 0.5));
+                n++;
+            }
+        else if (a == "borrowers")
+            for (const auto &borrower : report.mostActive)
+            {
+                response += " " + borrower.regNumber + ":" + to_string(borrower.issues) + ":" + to_string(borrower.error);
+                n++;
+            }
+        else if (a == "hours")
+            for (const auto &hour : report.recentHours)
+            {
+                response += " " + to_string((long long)hour.start) + ":" + to_string(hour.issues) + ":" +
+                            to_string(hour.returns);
+                n++;
+            }
+        else
+            return "ERROR expected titles, utilized, borrowers, hours or rebuild";
+        return "OK " + to_string(n) + response;
+    }
+    if (command == "utilization" && in >> a)
+    {
+        optional<TitleActivity> title = library.titleActivity(a);
+        if (!title)
+            return statusName(Status::NotFound);
+        return "OK " + to_string(title->issues) + " " + to_string((int)(title->utilization * 100 + 0.5));
+    }
+    if (command == "delbook" && in >> a >> b)
+        return statusName(library.deleteBook(a, parseCount(b)));
+    if (command == "update" && in >> a >> b)
+        return statusName(library.updateBook(a, parseCount(b), in >> branch ? branch : ""));
+
+    if (command == "where" && in >> a)
+    {
+        vector<BranchCopies> where;
+        Status status = library.whereAvailable(a, where);
+        if (status != Status::Ok)
+            return statusName(status);
+        string response = "OK " + to_string(where.size());
+        for (const auto &entry : where)
+            response += " " + entry.branch + ":" + to_string(entry.copies);
+        return response;
+    }
+    if (command == "transfer")
+    {
+        string from, to, copies;
+        if (in >> a >> from >> to >> copies)
+            return statusName(library.transferCopies(a, from, to, parseCount(copies)));
+    }
+    if (command == "branches")
+    {
+        vector<BranchCopies> totals = library.branchTotals();
+        string response = "OK " + to_string(totals.size());
+        for (const auto &entry : totals)
+            response += " " + entry.branch + ":" + to_string(entry.copies);
+        return response;
+    }
+    if (command == "addbranch" && in >> a)
+        return statusName(library.addBranch(a));
+
+    if (command == "addbook" && in >> a >> b)
+    {
+        string rest;
+        getline(in >> ws, rest);
+        size_t bar = rest.find('|');
+        if (bar == string::npos)
+            return "ERROR expected <title>|<author>";
+        return statusName(library.addBook(rest.substr(0, bar), rest.substr(bar + 1), a, parseCount(b)));
+    }
+
+    if (command == "addstudent")
+    {
+        string first, last, reg, phone, email;
+        if (in >> first >> last >> reg >> phone >> email)
+            return statusName(library.addStudent(first, last, reg, phone, email));
+    }
+
+    if (command == "find" && in >> a)
+    {
+        optional<Record> book = library.getBook(a);
+        if (!book)
+            return statusName(Status::NotFound);
+        return "OK " + to_string(book->copies) + " " + book->bookName + "|" + book->author;
+    }
+
+    if (command == "student" && in >> a)
+    {
+        optional<Student> student = library.getStudent(a);
+        if (!student)
+            return statusName(Status::NotFound);
+        return "OK " + student->firstName + " " + student->lastName + " " + student->phone + " " + student->email +
+               " " + to_string(library.issuedCount(a));
+    }
+
+    if (command == "findstudent" && in >> a)
+    {
+        vector<Student> found = library.findStudents(a);
+        string response = "OK " + to_string(found.size());
+        for (const auto &student : found)
+            response += " " + student.regNumber;
+        return response;
+    }
+
+    if (command == "search")
+    {
+        string query;
+        getline(in >> ws, query);
+        vector<Record> results = library.searchBooks(query);
+        string response = "OK " + to_string(results.size());
+        for (const auto &book : results)
+            response += " " + book.isbn;
+        return response;
+    }
+
+    if (command == "fuzzy" || command == "fuzzystudent")
+    {
+        string query;
+        getline(in >> ws, query);
+        string response;
+        size_t count = 0;
+        if (command == "fuzzy")
+            for (const auto &match : library.fuzzySearchBooks(query))
+            {
+                response += " " + match.first.isbn + ":" + to_string(match.second);
+                count++;
+            }
+        else
+            for (const auto &match : library.fuzzyFindStudents(query))
+            {
+                response += " " + match.first.regNumber + ":" + to_string(match.second);
+                count++;
+            }
+        return "OK " + to_string(count) + response;
+    }
+
+    if (command == "list" || command == "liststudents")
+    {
+        const size_t PAGE = 20;
+        bool books = command == "list";
+        BookOrder bookOrder = BookOrder::Catalog;
+        StudentOrder studentOrder = StudentOrder::Catalog;
+        bool availableOnly = false;
+        string after, word;
+        while (in >> word)
+        {
+            if (books && word == "title")
+                bookOrder = BookOrder::Title;
+            else if (books && word == "author")
+                bookOrder = BookOrder::Author;
+            else if (books && word == "copies")
+                bookOrder = BookOrder::Copies;
+            else if (books && word == "available")
+                availableOnly = true;
+            else if (!books && word == "name")
+                studentOrder = StudentOrder::Name;
+            else if (!books && word == "reg")
+                studentOrder = StudentOrder::Registration;
+            else if (word == "after" && in >> after)
+                continue;
+            else
+                return "ERROR unknown listing option " + word;
+        }
+
+        string response;
+        size_t rows = 0;
+        Status status;
+        if (books)
+        {
+            vector<Record> page;
+            status = library.listBooks(bookOrder, availableOnly, after, PAGE, page);
+            for (const auto &book : page)
+                response += " " + book.isbn;
+            rows = page.size();
+        }
+        else
+        {
+            vector<Student> page;
+            status = library.listStudents(studentOrder, after, PAGE, page);
+            for (const auto &student : page)
+                response += " " + student.regNumber;
+            rows = page.size();
+        }
+        if (status != Status::Ok)
+            return statusName(status);
+        return "OK " + to_string(rows) + response;
+    }
+
+    if (command == "checkpoint")
+    {
+        library.checkpoint();
+        return "OK";
+    }
+    if (command == "snapshot")
+        return statusName(library.snapshotHistory());
+    if (command == "history")
+    {
+        vector<time_t> snapshots = library.historySnapshots();
+        string response = "OK " + to_string(snapshots.size());
+        for (time_t at : snapshots)
+            response += " " + to_string(at);
+        return response;
+    }
+    if (command == "restore" && in >> a >> b)
+    {
+        time_t when = HistoryArchive::parseTime(a);
+        if (when < 0)
+            return "ERROR expected YYYY-MM-DD[THH:MM[:SS]] or epoch seconds";
+        RestoreReport report;
+        Status status = library.restoreAsOf(when, b, &report);
+        if (status != Status::Ok)
+            return statusName(status);
+        return "OK " + to_string(report.snapshotAt) + " " + to_string(report.events) + " " + to_string(report.books) +
+               " " + to_string(report.students) + " " + to_string(report.loans);
+    }
+
+    if (command == "metrics")
+    {
+        // Only a .prom file in the data directory, so a client cannot replace other files
+        string name = in >> a ? a : "metrics.prom";
+        if (name.size() <= 5 || name.compare(name.size() - 5, 5, ".prom") != 0 ||
+            name.find_first_of("/\\") != string::npos)
+            return "ERROR expected a file name ending in .prom";
+        string path = library.dataPath(name);
+        return library.writeMetrics(path) ? "OK " + path : "ERROR could not write " + path;
+    }
+
+    AccountRole role;
+    if (command == "addaccount" && in >> a >> b)
+    {
+        string password;
+        if (!parseRole(b, role) || !(in >> password))
+            return "ERROR expected addaccount <user> librarian|counter <password>";
+        return statusName(library.addAccount(a, role, password));
+    }
+    if (command == "passwd" && in >> a >> b)
+        return statusName(library.setPassword(a, b));
+    if (command == "accounts")
+    {
+        vector<pair<string, AccountRole>> list = library.accountList();
+        string response = "OK " + to_string(list.size());
+        for (const auto &account : list)
+            response += " " + account.first + ":" + roleName(account.second);
+        return response;
+    }
+
+    return "ERROR unknown or incomplete command";
+}
+
+struct BatchSummary
+{
+    size_t commands = 0;
+    size_t ok = 0;
+    double seconds = 0;
+};
+
+// Runs every command read from in, writing one response line per command to out
+inline BatchSummary runBatch(LMS &library, istream &in, ostream &out)
+{
+    BatchSummary summary;
+    BatchSession session;
+    auto start = chrono::steady_clock::now();
+
+    string line;
+    while (getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == string::npos || line[first] == '#')
+            continue;
+
+        string response = executeCommand(library, line, session);
+        summary.commands++;
+        if (response.compare(0, 2, "OK") == 0)
+            summary.ok++;
+        out << response << '\n';
+    }
+
+    out.flush();
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+#endif
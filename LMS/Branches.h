@@ -0,0 +1,247 @@
+// Branch Stock
+// Copies on the shelf at each branch of the library, under one catalog of
+// titles. books.copies (see Tables.h) stays the total on the shelf across all
+// branches; every other branch has its own column of counts, parallel to the
+// rows of BookTable, and the main branch holds whatever the others do not:
+//   main(row) = total(row) - sum of the other branches' counts
+// so a library with a single branch has no extra columns or files at all, and
+// data files and journals written before branches existed load unchanged.
+//
+// Each branch other than main is a shard with its own file,
+// stock_<name>.txt, of "<isbn> <copies>" lines for the titles it holds.
+// The files are loaded in parallel at startup, and at a checkpoint only the
+// branches whose counts changed are rewritten, again in parallel.
+//
+// Like BookTable, the class does no locking itself: a count is read and
+// changed under the book's stripe lock, and rows and branches are added or
+// removed under the exclusive catalog lock.
+
+#ifndef LMS_BRANCHES_H
+#define LMS_BRANCHES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DurableFile.h"
+
+class BranchStock
+{
+public:
+    static constexpr size_t MAX_BRANCHES = 64;
+    static constexpr int MAIN = 0;
+    static constexpr size_t MAX_NAME_LENGTH = 20;
+
+private:
+    std::vector<std::string> names{"Main"};         // names[MAIN] is the main branch
+    std::vector<std::vector<int>> columns{{}};      // columns[b][row]; columns[MAIN] stays empty
+    std::atomic<uint64_t> changes[MAX_BRANCHES] = {};
+    uint64_t saved[MAX_BRANCHES] = {};              // changes[b] when stock_<name>.txt was last written
+
+    // Runs fn(b) for each branch in list on up to hardware_concurrency threads
+    template <typename Fn>
+    static void parallelFor(const std::vector<int> &list, Fn fn)
+    {
+        size_t threads = std::min<size_t>(list.size(), std::max(1u, std::thread::hardware_concurrency()));
+        if (threads <= 1)
+        {
+            for (int b : list)
+                fn(b);
+            return;
+        }
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+            workers.emplace_back([&]
+                                 {
+                for (size_t i = next++; i < list.size(); i = next++)
+                    fn(list[i]); });
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+public:
+    // Letters, digits and '-', so a name can go in a file name and a batch command
+    static bool isValidName(const std::string &name)
+    {
+        if (name.empty() || name.size() > MAX_NAME_LENGTH)
+            return false;
+        for (char c : name)
+            if (!isalnum((unsigned char)c) && c != '-')
+                return false;
+        return true;
+    }
+
+    size_t count() const
+    {
+        return names.size();
+    }
+
+    const std::string &name(int b) const
+    {
+        return names[b];
+    }
+
+    // Index of the named branch (ignoring case), MAIN for an empty name, or -1
+    int find(const std::string &name) const
+    {
+        if (name.empty())
+            return MAIN;
+        for (size_t b = 0; b < names.size(); b++)
+            if (names[b].size() == name.size() &&
+                std::equal(name.begin(), name.end(), names[b].begin(), [](char x, char y)
+                           { return tolower((unsigned char)x) == tolower((unsigned char)y); }))
+                return (int)b;
+        return -1;
+    }
+
+    // Adds an empty branch; rows is the number of titles in the catalog.
+    // Returns its index, or -1 if the name is invalid, taken or there is no room.
+    int add(const std::string &name, size_t rows)
+    {
+        if (!isValidName(name) || find(name) >= 0 || names.size() >= MAX_BRANCHES)
+            return -1;
+        names.push_back(name);
+        columns.emplace_back(rows, 0);
+        return (int)names.size() - 1;
+    }
+
+    void reserve(size_t rows)
+    {
+        for (size_t b = 1; b < columns.size(); b++)
+            columns[b].reserve(rows);
+    }
+
+    // Mirrors BookTable::add: a new title starts with all its copies at main
+    void addRow()
+    {
+        for (size_t b = 1; b < columns.size(); b++)
+            columns[b].push_back(0);
+    }
+
+    // Mirrors BookTable::removeAt, which moves the last row into pos
+    void removeAt(size_t pos)
+    {
+        for (size_t b = 1; b < columns.size(); b++)
+        {
+            if (columns[b][pos])
+                changes[b]++;
+            columns[b][pos] = columns[b].back();
+            columns[b].pop_back();
+        }
+    }
+
+    // Copies of the row held by branches other than main
+    int others(size_t row) const
+    {
+        int sum = 0;
+        for (size_t b = 1; b < columns.size(); b++)
+            sum += columns[b][row];
+        return sum;
+    }
+
+    // Copies on the shelf at branch b, given the row's total
+    int at(int b, size_t row, int total) const
+    {
+        return b == MAIN ? total - others(row) : columns[b][row];
+    }
+
+    // Sets branch b's count (b != MAIN); the caller adjusts the total to match
+    void set(int b, size_t row, int copies)
+    {
+        columns[b][row] = copies;
+        changes[b]++;
+    }
+
+    // Copies on the shelf at each branch, summed over the rows of the
+    // catalog; totalOf(row) gives a row's total
+    template <typename TotalOf>
+    std::vector<long long> totals(size_t rows, TotalOf totalOf) const
+    {
+        std::vector<long long> sums(names.size());
+        for (size_t row = 0; row < rows; row++)
+        {
+            int others = 0;
+            for (size_t b = 1; b < columns.size(); b++)
+            {
+                sums[b] += columns[b][row];
+                others += columns[b][row];
+            }
+            sums[MAIN] += totalOf(row) - others;
+        }
+        return sums;
+    }
+
+    // Reads branches.txt: one branch name per line, main not included
+    void loadNames(const std::string &path, size_t rows)
+    {
+        std::ifstream file(path);
+        std::string name;
+        while (file >> name)
+            add(name, rows);
+    }
+
+    bool saveNames(const std::string &path) const
+    {
+        DurableWriter file(path);
+        for (size_t b = 1; b < names.size(); b++)
+            file.append(names[b]).append('\n');
+        return file.commit();
+    }
+
+    // Loads every branch's file in parallel. pathOf(name) gives the file and
+    // rowOf(isbn) the title's row (or -1 to skip the line); it is called from
+    // several threads at once, so it must only read.
+    template <typename PathOf, typename RowOf>
+    void loadAll(PathOf pathOf, RowOf rowOf)
+    {
+        std::vector<int> list;
+        for (size_t b = 1; b < names.size(); b++)
+            list.push_back((int)b);
+        parallelFor(list, [&](int b)
+                    {
+            std::ifstream file(pathOf(names[b]));
+            std::string isbn;
+            long long copies;
+            while (file >> isbn >> copies)
+            {
+                long long row = rowOf(isbn);
+                if (row >= 0 && copies > 0)
+                    columns[b][row] = (int)copies;
+            }
+            saved[b] = changes[b].load(); });
+    }
+
+    // Rewrites the files of the branches whose counts changed since they were
+    // last saved, in parallel. isbnOf(row) gives the title's ISBN, and
+    // done(name, ok, bytes, start) is called as each file is committed (from
+    // the worker threads).
+    template <typename PathOf, typename IsbnOf, typename Done>
+    void saveChanged(PathOf pathOf, IsbnOf isbnOf, Done done)
+    {
+        std::vector<int> list;
+        for (size_t b = 1; b < names.size(); b++)
+            if (changes[b].load(std::memory_order_relaxed) != saved[b])
+                list.push_back((int)b);
+        parallelFor(list, [&](int b)
+                    {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t version = changes[b].load();
+            DurableWriter file(pathOf(names[b]));
+            const std::vector<int> &column = columns[b];
+            for (size_t row = 0; row < column.size(); row++)
+                if (column[row] > 0)
+                    file.appendNumber(isbnOf(row), 13).append(' ').appendNumber(column[row]).append('\n');
+            bool ok = file.commit();
+            if (ok)
+                saved[b] = version;
+            done(names[b], ok, file.size(), start); });
+    }
+};
+
+#endif
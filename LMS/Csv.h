@@ -0,0 +1,244 @@
+// CSV Streaming
+// CsvReader reads a file in large chunks and splits it into rows without
+// reading the whole file into memory. Fields may be quoted ("..."), with
+// doubled quotes for a literal quote, so titles can contain commas.
+// CsvWriter buffers output and writes it in large blocks.
+
+#ifndef LMS_CSV_H
+#define LMS_CSV_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CsvReader
+{
+private:
+    static const size_t CHUNK_SIZE = 1 << 20;
+
+    FILE *file = nullptr;
+    std::vector<char> chunk;
+    size_t pos = 0;
+    size_t end = 0;
+    bool eof = false;
+    size_t line = 0;
+    size_t bytes = 0;
+
+    // Returns the next byte, refilling the chunk as needed; -1 at end of file
+    int next()
+    {
+        if (pos == end)
+        {
+            if (eof || !file)
+                return -1;
+            end = fread(chunk.data(), 1, chunk.size(), file);
+            pos = 0;
+            bytes += end;
+            if (end < chunk.size())
+                eof = true;
+            if (end == 0)
+                return -1;
+        }
+        return (unsigned char)chunk[pos++];
+    }
+
+    int peek()
+    {
+        int c = next();
+        if (c != -1)
+            pos--;
+        return c;
+    }
+
+public:
+    CsvReader(const std::string &path) : chunk(CHUNK_SIZE)
+    {
+        file = fopen(path.c_str(), "rb");
+    }
+
+    ~CsvReader()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    CsvReader(const CsvReader &) = delete;
+    CsvReader &operator=(const CsvReader &) = delete;
+
+    bool isOpen() const
+    {
+        return file != nullptr;
+    }
+
+    // Line number of the row most recently returned by readRow (1-based)
+    size_t lineNumber() const
+    {
+        return line;
+    }
+
+    size_t bytesRead() const
+    {
+        return bytes;
+    }
+
+    // Reads the next non-empty row into fields, reusing its storage.
+    // Returns false at end of file.
+    bool readRow(std::vector<std::string> &fields)
+    {
+        size_t used = 0;
+        while (true)
+        {
+            int c = peek();
+            if (c == -1)
+                return false;
+
+            line++;
+            used = 0;
+            bool endOfRow = false;
+            while (!endOfRow)
+            {
+                if (used == fields.size())
+                    fields.emplace_back();
+                std::string &field = fields[used++];
+                field.clear();
+
+                bool quoted = false;
+                c = next();
+                if (c == '"')
+                {
+                    quoted = true;
+                    c = next();
+                }
+                while (true)
+                {
+                    if (c == -1)
+                    {
+                        endOfRow = true;
+                        break;
+                    }
+                    if (quoted)
+                    {
+                        if (c == '"')
+                        {
+                            if (peek() == '"')
+                            {
+                                next();
+                                field += '"';
+                            }
+                            else
+                                quoted = false;
+                        }
+                        else
+                        {
+                            if (c == '\n')
+                                line++;
+                            field += (char)c;
+                        }
+                    }
+                    else if (c == ',')
+                        break;
+                    else if (c == '\n')
+                    {
+                        endOfRow = true;
+                        break;
+                    }
+                    else if (c != '\r')
+                        field += (char)c;
+                    c = next();
+                }
+            }
+
+            fields.resize(used);
+            if (!(used == 1 && fields[0].empty()))
+                return true;
+        }
+    }
+};
+
+class CsvWriter
+{
+private:
+    static const size_t FLUSH_AT = 1 << 20;
+
+    FILE *file = nullptr;
+    std::string buffer;
+    bool firstField = true;
+
+public:
+    CsvWriter(const std::string &path)
+    {
+        file = fopen(path.c_str(), "wb");
+        buffer.reserve(FLUSH_AT + 4096);
+    }
+
+    ~CsvWriter()
+    {
+        close();
+    }
+
+    CsvWriter(const CsvWriter &) = delete;
+    CsvWriter &operator=(const CsvWriter &) = delete;
+
+    bool isOpen() const
+    {
+        return file != nullptr;
+    }
+
+    // Appends one field, quoting it only if it contains a separator, quote or line break
+    CsvWriter &field(std::string_view value)
+    {
+        if (!firstField)
+            buffer += ',';
+        firstField = false;
+
+        if (value.find_first_of(",\"\r\n") == std::string_view::npos)
+        {
+            buffer += value;
+            return *this;
+        }
+        buffer += '"';
+        for (char c : value)
+        {
+            if (c == '"')
+                buffer += '"';
+            buffer += c;
+        }
+        buffer += '"';
+        return *this;
+    }
+
+    CsvWriter &field(long long value)
+    {
+        return field(std::to_string(value));
+    }
+
+    void endRow()
+    {
+        buffer += '\n';
+        firstField = true;
+        if (buffer.size() >= FLUSH_AT)
+            flush();
+    }
+
+    void flush()
+    {
+        if (file && !buffer.empty())
+            fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+
+    // Flushes and closes; returns false if any write failed
+    bool close()
+    {
+        if (!file)
+            return false;
+        flush();
+        bool ok = !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
+#endif
@@ -0,0 +1,219 @@
+// Durable Writes
+// Replaces a data file so that after a crash at any point the file holds
+// either its old contents or its new contents, never a mix or nothing:
+//   1. the new contents go to a uniquely named temporary file in the same
+//      directory (mkstemp), in 1 MB buffered writes,
+//   2. the temporary file is fsync'ed, so its data is on disk,
+//   3. it is renamed over the target, which atomically swaps the two,
+//   4. the directory is fsync'ed, so the rename itself survives a crash.
+// If anything fails before the rename the temporary file is removed and the
+// target is left untouched.
+//
+// Usage:
+//   DurableWriter out(path);
+//   out.append(name).append(',').appendNumber(copies).append('\n');
+//   if (!out.commit()) ... // the old file is still in place
+
+#ifndef LMS_DURABLEFILE_H
+#define LMS_DURABLEFILE_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+class DurableWriter
+{
+private:
+    static const size_t FLUSH_AT = 1 << 20;
+
+    std::string path;
+    std::string tempPath;
+    int fd = -1;
+    std::string buffer;
+    uint64_t written = 0;
+    bool failed = false;
+
+    void openTemp()
+    {
+#ifdef _WIN32
+        static int counter = 0;
+        tempPath = path + ".tmp." + std::to_string(GetCurrentProcessId()) + "." + std::to_string(++counter);
+        fd = _open(tempPath.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, 0644);
+#else
+        std::string pattern = path + ".tmp.XXXXXX";
+        fd = mkstemp(&pattern[0]);
+        tempPath = pattern;
+        if (fd >= 0)
+            fchmod(fd, 0644);
+#endif
+        failed = fd < 0;
+    }
+
+    // Writes all of data, retrying short writes
+    bool writeAll(const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            auto n = ::write(fd, data, (unsigned)std::min<size_t>(size, 1u << 30));
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+    void flushBuffer()
+    {
+        if (!failed && !buffer.empty() && !writeAll(buffer.data(), buffer.size()))
+            failed = true;
+        buffer.clear();
+    }
+
+    void discard()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+        if (!tempPath.empty())
+            std::remove(tempPath.c_str());
+        tempPath.clear();
+    }
+
+    static std::string directoryOf(const std::string &file)
+    {
+        size_t slash = file.find_last_of("/\\");
+        return slash == std::string::npos ? "." : slash == 0 ? "/" : file.substr(0, slash);
+    }
+
+    // Makes a completed rename durable
+    static bool syncDirectory(const std::string &dir)
+    {
+#ifdef _WIN32
+        (void)dir; // MoveFileEx with MOVEFILE_WRITE_THROUGH already waited for it
+        return true;
+#else
+        int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd < 0)
+            return false;
+        bool ok = fsync(dirFd) == 0;
+        ::close(dirFd);
+        return ok;
+#endif
+    }
+
+public:
+    explicit DurableWriter(const std::string &target) : path(target)
+    {
+        buffer.reserve(FLUSH_AT + 4096);
+        openTemp();
+    }
+
+    DurableWriter(const DurableWriter &) = delete;
+    DurableWriter &operator=(const DurableWriter &) = delete;
+
+    // Without a successful commit the target is left as it was
+    ~DurableWriter()
+    {
+        discard();
+    }
+
+    bool isOpen() const
+    {
+        return fd >= 0;
+    }
+
+    DurableWriter &append(std::string_view text)
+    {
+        if (buffer.size() + text.size() > FLUSH_AT)
+            flushBuffer();
+        if (text.size() > FLUSH_AT)
+        {
+            if (!failed && !writeAll(text.data(), text.size()))
+                failed = true;
+        }
+        else
+            buffer.append(text.data(), text.size());
+        written += text.size();
+        return *this;
+    }
+
+    DurableWriter &append(char c)
+    {
+        if (buffer.size() >= FLUSH_AT)
+            flushBuffer();
+        buffer += c;
+        written++;
+        return *this;
+    }
+
+    // Appends the decimal digits of value, left-padded with zeros to width
+    DurableWriter &appendNumber(long long value, int width = 0)
+    {
+        char digits[24];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        for (int pad = width - (int)(end - digits); pad > 0; pad--)
+            append('0');
+        return append(std::string_view(digits, end - digits));
+    }
+
+    // Binary data, for the snapshot
+    DurableWriter &appendBytes(const void *data, size_t size)
+    {
+        return append(std::string_view((const char *)data, size));
+    }
+
+    // Bytes appended so far
+    uint64_t size() const
+    {
+        return written;
+    }
+
+    // Flushes, fsyncs and renames the temporary file over the target. Returns
+    // false (and keeps the old file) if any step before the rename failed.
+    bool commit()
+    {
+        if (fd < 0)
+            return false;
+        flushBuffer();
+#ifdef _WIN32
+        bool ok = !failed && _commit(fd) == 0;
+        ::close(fd);
+        fd = -1;
+        ok = ok && MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        bool ok = !failed && fsync(fd) == 0;
+        ::close(fd);
+        fd = -1;
+        ok = ok && std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+        if (!ok)
+        {
+            discard();
+            return false;
+        }
+        tempPath.clear();
+        syncDirectory(directoryOf(path));
+        return true;
+    }
+};
+
+#endif
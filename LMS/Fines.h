@@ -0,0 +1,149 @@
+// Fine Ledger
+// Outstanding overdue fines per student. A loan is charged a fixed amount for
+// every full day past its due date, in increments:
+//   - a sweep at time T charges each overdue loan for the days it became late
+//     since the previous sweep S: daysLate(T) - daysLate(S),
+//   - a return at time t charges the remaining daysLate(t) - daysLate(S).
+// The increments telescope to exactly daysLate(return) per loan, but a sweep
+// only visits loans that are overdue (via LoanTable::forEachDue) rather than
+// recomputing over every loan or the whole circulation history.
+//
+// Balances are sharded by studentShard(reg); callers hold that student's
+// stripe lock, as for LoanTable.
+
+#ifndef LMS_FINES_H
+#define LMS_FINES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <unordered_map>
+#include "Loans.h"
+
+class FineLedger
+{
+public:
+    static const size_t SHARDS = LoanTable::SHARDS;
+
+private:
+    typedef std::unordered_map<uint32_t, long long> BalanceMap;
+
+    BalanceMap shards[SHARDS];
+    std::atomic<time_t> lastSweep{0};
+    std::atomic<long long> outstandingTotal{0};
+    std::atomic<long long> chargedTotal{0}; // Since startup
+    std::atomic<long long> paidTotal{0};    // Since startup
+    std::atomic<uint64_t> changes{0};
+
+    BalanceMap &shard(uint32_t reg) { return shards[LoanTable::studentShard(reg)]; }
+    const BalanceMap &shard(uint32_t reg) const { return shards[LoanTable::studentShard(reg)]; }
+
+public:
+    // Full days a loan due at dueAt is overdue at time at
+    static long long daysLate(time_t dueAt, time_t at)
+    {
+        return at > dueAt ? (long long)((at - dueAt) / 86400) : 0;
+    }
+
+    // Days of lateness a loan has not been charged for yet, as of time at
+    long long unchargedDays(time_t dueAt, time_t at) const
+    {
+        return daysLate(dueAt, at) - daysLate(dueAt, lastSweep.load(std::memory_order_relaxed));
+    }
+
+    time_t lastSweepTime() const
+    {
+        return lastSweep.load(std::memory_order_relaxed);
+    }
+
+    void setLastSweepTime(time_t at)
+    {
+        lastSweep.store(at, std::memory_order_relaxed);
+        changes++;
+    }
+
+    // Changes whenever a balance or the sweep time changes, so a checkpoint can skip saving them
+    uint64_t version() const
+    {
+        return changes.load(std::memory_order_relaxed);
+    }
+
+    long long balance(uint32_t reg) const
+    {
+        auto it = shard(reg).find(reg);
+        return it == shard(reg).end() ? 0 : it->second;
+    }
+
+    // Adds amount to the student's balance and returns the new balance
+    long long charge(uint32_t reg, long long amount)
+    {
+        if (amount <= 0)
+            return balance(reg);
+        chargedTotal += amount;
+        outstandingTotal += amount;
+        changes++;
+        return shard(reg)[reg] += amount;
+    }
+
+    // Takes a payment of at most the balance; returns the new balance
+    long long pay(uint32_t reg, long long amount)
+    {
+        auto it = shard(reg).find(reg);
+        if (it == shard(reg).end() || amount <= 0)
+            return balance(reg);
+        amount = std::min(amount, it->second);
+        paidTotal += amount;
+        outstandingTotal -= amount;
+        changes++;
+        it->second -= amount;
+        long long left = it->second;
+        if (left == 0)
+            shard(reg).erase(it);
+        return left;
+    }
+
+    // Sets a balance read back from fines.txt or the journal
+    void set(uint32_t reg, long long amount)
+    {
+        outstandingTotal += amount - balance(reg);
+        changes++;
+        if (amount > 0)
+            shard(reg)[reg] = amount;
+        else
+            shard(reg).erase(reg);
+    }
+
+    long long outstanding() const
+    {
+        return outstandingTotal.load(std::memory_order_relaxed);
+    }
+
+    long long charged() const
+    {
+        return chargedTotal.load(std::memory_order_relaxed);
+    }
+
+    long long paid() const
+    {
+        return paidTotal.load(std::memory_order_relaxed);
+    }
+
+    // Zeroes the since-startup totals (after the journal replay)
+    void resetStats()
+    {
+        chargedTotal = 0;
+        paidTotal = 0;
+    }
+
+    // Calls fn(reg, balance) for every student who owes something
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (const auto &map : shards)
+            for (const auto &entry : map)
+                fn(entry.first, entry.second);
+    }
+};
+
+#endif
@@ -0,0 +1,220 @@
+// Point-in-Time History
+// Keeps enough of the past to rebuild the catalog, students and loans as they
+// were at any moment since the oldest kept snapshot. In <data dir>/history:
+//   snapshot-<epoch>.snap  binary snapshot (Snapshot.h) of books, students and loans
+//   stock-<epoch>.txt      branch counts at the same moment, "<branch> <isbn> <copies>"
+//   events-<epoch>.log     every journal record logged after <epoch>, moved here
+//                          by each checkpoint before it truncates journal.log
+// A new snapshot starts a new events segment once the current one is a day
+// old or holds REPLAY_LIMIT records, so rebuilding any point in time costs
+// one snapshot load plus at most about that many records of replay.
+//
+// The snapshots themselves are written by a forked child process (see
+// LMS::snapshotHistoryLocked), so the only pause is the fork.
+
+#ifndef LMS_HISTORY_H
+#define LMS_HISTORY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include "Journal.h"
+
+class HistoryArchive
+{
+public:
+    static const time_t SNAPSHOT_SECONDS = 86400; // A new snapshot at least daily...
+    static const size_t REPLAY_LIMIT = 100000;    // ...or once a segment holds this many records
+    static const size_t SNAPSHOTS_KEPT = 90;
+
+    // What rebuilding a moment takes: the newest snapshot at or before it and
+    // the event files that follow it, oldest first
+    struct Plan
+    {
+        time_t snapshotAt = 0;
+        std::vector<std::string> eventFiles;
+    };
+
+private:
+    std::string dir;
+    time_t segment = 0;            // Start of the events segment being appended to; 0 before the first snapshot
+    std::atomic<time_t> lastSnapshot{0};
+    std::atomic<size_t> segmentRecords{0};
+
+    // Times of the files named <prefix><epoch><suffix> in dir, oldest first
+    static std::vector<time_t> list(const std::string &dir, const std::string &prefix, const std::string &suffix)
+    {
+        std::vector<time_t> times;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(dir, error))
+        {
+            std::string name = entry.path().filename().string();
+            if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+                continue;
+            std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+            if (std::all_of(digits.begin(), digits.end(), ::isdigit))
+                times.push_back((time_t)std::stoll(digits));
+        }
+        std::sort(times.begin(), times.end());
+        return times;
+    }
+
+    static size_t countLines(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
+    }
+
+public:
+    static std::string snapshotPath(const std::string &dir, time_t at)
+    {
+        return dir + "/snapshot-" + std::to_string(at) + ".snap";
+    }
+
+    static std::string stockPath(const std::string &dir, time_t at)
+    {
+        return dir + "/stock-" + std::to_string(at) + ".txt";
+    }
+
+    static std::string eventsPath(const std::string &dir, time_t at)
+    {
+        return dir + "/events-" + std::to_string(at) + ".log";
+    }
+
+    // Accepts "YYYY-MM-DD", "YYYY-MM-DDTHH:MM[:SS]" (local time) or epoch
+    // seconds; returns -1 for anything else
+    static time_t parseTime(const std::string &text)
+    {
+        if (!text.empty() && std::all_of(text.begin(), text.end(), ::isdigit) && text.size() <= 12)
+            return (time_t)std::stoll(text);
+        const char *s = text.c_str();
+        int year, month, day, hour = 0, minute = 0, second = 0, used = 0, more = 0;
+        if (sscanf(s, "%4d-%2d-%2d%n", &year, &month, &day, &used) != 3)
+            return -1;
+        if (s[used] == 'T' || s[used] == ' ')
+        {
+            if (sscanf(s + used + 1, "%2d:%2d%n", &hour, &minute, &more) != 2)
+                return -1;
+            used += 1 + more;
+            if (s[used] == ':')
+            {
+                if (sscanf(s + used + 1, "%2d%n", &second, &more) != 1)
+                    return -1;
+                used += 1 + more;
+            }
+        }
+        if (s[used])
+            return -1;
+        tm when = {};
+        when.tm_year = year - 1900;
+        when.tm_mon = month - 1;
+        when.tm_mday = day;
+        when.tm_hour = hour;
+        when.tm_min = minute;
+        when.tm_sec = second;
+        when.tm_isdst = -1;
+        return mktime(&when);
+    }
+
+    // Finds (or creates) the history directory and picks up the segment in progress
+    void open(const std::string &directory)
+    {
+        dir = directory;
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+        std::vector<time_t> snapshots = list(dir, "snapshot-", ".snap");
+        std::vector<time_t> segments = list(dir, "events-", ".log");
+        segment = std::max(snapshots.empty() ? 0 : snapshots.back(), segments.empty() ? 0 : segments.back());
+        lastSnapshot = snapshots.empty() ? 0 : snapshots.back();
+        segmentRecords = segment ? countLines(eventsPath(dir, segment)) : 0;
+    }
+
+    const std::string &directory() const
+    {
+        return dir;
+    }
+
+    // Times of the snapshots on disk, oldest first
+    std::vector<time_t> snapshotTimes() const
+    {
+        return list(dir, "snapshot-", ".snap");
+    }
+
+    // Whether a checkpoint at now should take a snapshot; pending is the
+    // number of records in journal.log, which are not in the segment yet
+    bool snapshotDue(time_t now, size_t pending) const
+    {
+        return now - lastSnapshot.load(std::memory_order_relaxed) >= SNAPSHOT_SECONDS ||
+               segmentRecords.load(std::memory_order_relaxed) + pending >= REPLAY_LIMIT;
+    }
+
+    // Appends the journal file, holding records records, to the current
+    // segment and syncs it. Records from before the first snapshot have
+    // nothing to be replayed on and are dropped.
+    bool appendEvents(const std::string &journalPath, size_t records)
+    {
+        if (segment == 0 || records == 0)
+            return true;
+        std::ifstream in(journalPath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        content.resize(content.rfind('\n') + 1); // A torn last line is not a record yet
+        int fd = ::open(eventsPath(dir, segment).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0)
+            return false;
+        bool ok = ::write(fd, content.data(), content.size()) == (ssize_t)content.size() && syncFile(fd) == 0;
+        ::close(fd);
+        if (ok)
+            segmentRecords += records;
+        return ok;
+    }
+
+    // Starts the segment that follows the snapshot being taken at at, and
+    // drops the oldest snapshots beyond SNAPSHOTS_KEPT, with their stock and
+    // the events only they lead to. If the snapshot is never written, its
+    // segment is replayed after the previous snapshot's (see plan).
+    void beginSegment(time_t at)
+    {
+        segment = at;
+        lastSnapshot = at;
+        segmentRecords = 0;
+        std::vector<time_t> snapshots = list(dir, "snapshot-", ".snap");
+        if (snapshots.size() < SNAPSHOTS_KEPT)
+            return;
+        size_t drop = snapshots.size() - (SNAPSHOTS_KEPT - 1);
+        for (size_t i = 0; i < drop; i++)
+        {
+            std::remove(snapshotPath(dir, snapshots[i]).c_str());
+            std::remove(stockPath(dir, snapshots[i]).c_str());
+        }
+        for (time_t events : list(dir, "events-", ".log"))
+            if (events < snapshots[drop])
+                std::remove(eventsPath(dir, events).c_str());
+    }
+
+    // How to rebuild the moment when from the files in dir, or a plan with
+    // snapshotAt 0 if no snapshot is that old
+    static Plan plan(const std::string &dir, time_t when)
+    {
+        Plan result;
+        for (time_t at : list(dir, "snapshot-", ".snap"))
+            if (at <= when)
+                result.snapshotAt = at;
+        if (result.snapshotAt == 0)
+            return result;
+        for (time_t at : list(dir, "events-", ".log"))
+            if (at >= result.snapshotAt && at <= when)
+                result.eventFiles.push_back(eventsPath(dir, at));
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,306 @@
+// Hold Queues
+// Students waiting for titles with no copies on the shelf, one FIFO queue per
+// ISBN. When a copy comes back (a return, a restock, an expired pickup) it is
+// set aside for the student at the head of the queue: the hold becomes
+// "ready" and the copy stays off the shelf until that student collects it or
+// the pickup window runs out.
+//
+// Like LoanTable, the queues are split into SHARDS shards by bookShard(isbn)
+// and the table does no locking itself: callers hold the book's stripe lock.
+// Titles without holds cost one relaxed atomic load on the issue/return path.
+
+#ifndef LMS_HOLDS_H
+#define LMS_HOLDS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "Loans.h"
+
+class HoldTable
+{
+public:
+    struct Hold
+    {
+        uint32_t reg;
+        time_t placedAt;
+        time_t readyAt; // 0 while waiting
+        int branch = 0; // Once ready, the branch its copy was taken from (0 is main)
+    };
+
+    struct Queue
+    {
+        std::deque<Hold> waiting; // Oldest first
+        std::vector<Hold> ready;  // Copies set aside, waiting to be collected
+    };
+
+    enum class State
+    {
+        None,
+        Waiting,
+        Ready
+    };
+
+    // Lifetime counts, for the statistics
+    struct Counters
+    {
+        std::atomic<uint64_t> placed{0};
+        std::atomic<uint64_t> allocated{0};  // Copies set aside for a hold
+        std::atomic<uint64_t> fulfilled{0};  // Ready holds collected (issued)
+        std::atomic<uint64_t> cancelled{0};
+        std::atomic<uint64_t> expired{0};    // Ready holds not collected in time
+        std::atomic<uint64_t> waitSeconds{0}; // Sum of placed -> ready times
+    };
+
+    static const size_t SHARDS = LoanTable::SHARDS;
+
+private:
+    typedef std::unordered_map<uint64_t, Queue> QueueMap;
+
+    QueueMap shards[SHARDS];
+    std::atomic<size_t> waitingCount{0};
+    std::atomic<size_t> readyCount{0};
+    std::atomic<uint64_t> changes{0};
+    Counters counters;
+
+    QueueMap &shard(uint64_t isbn) { return shards[LoanTable::bookShard(isbn)]; }
+    const QueueMap &shard(uint64_t isbn) const { return shards[LoanTable::bookShard(isbn)]; }
+
+    void eraseIfEmpty(QueueMap &map, QueueMap::iterator it)
+    {
+        if (it->second.waiting.empty() && it->second.ready.empty())
+            map.erase(it);
+    }
+
+    static bool removeFrom(std::deque<Hold> &holds, uint32_t reg)
+    {
+        for (auto it = holds.begin(); it != holds.end(); ++it)
+            if (it->reg == reg)
+            {
+                holds.erase(it);
+                return true;
+            }
+        return false;
+    }
+
+    static bool removeFrom(std::vector<Hold> &holds, uint32_t reg, int *branch = nullptr)
+    {
+        for (size_t i = 0; i < holds.size(); i++)
+            if (holds[i].reg == reg)
+            {
+                if (branch)
+                    *branch = holds[i].branch;
+                holds[i] = holds.back();
+                holds.pop_back();
+                return true;
+            }
+        return false;
+    }
+
+public:
+    // True when no student is waiting for any title (the common fast path)
+    bool noneWaiting() const
+    {
+        return waitingCount.load(std::memory_order_relaxed) == 0;
+    }
+
+    bool noneReady() const
+    {
+        return readyCount.load(std::memory_order_relaxed) == 0;
+    }
+
+    size_t waitingTotal() const
+    {
+        return waitingCount.load(std::memory_order_relaxed);
+    }
+
+    size_t readyTotal() const
+    {
+        return readyCount.load(std::memory_order_relaxed);
+    }
+
+    // Changes whenever any queue changes, so a checkpoint can skip saving them
+    uint64_t version() const
+    {
+        return changes.load(std::memory_order_relaxed);
+    }
+
+    const Counters &stats() const
+    {
+        return counters;
+    }
+
+    // Zeroes the lifetime counts (after the journal replay at startup)
+    void resetStats()
+    {
+        for (auto *counter : {&counters.placed, &counters.allocated, &counters.fulfilled, &counters.cancelled,
+                              &counters.expired, &counters.waitSeconds})
+            counter->store(0, std::memory_order_relaxed);
+    }
+
+    State state(uint32_t reg, uint64_t isbn) const
+    {
+        auto it = shard(isbn).find(isbn);
+        if (it == shard(isbn).end())
+            return State::None;
+        for (const Hold &hold : it->second.ready)
+            if (hold.reg == reg)
+                return State::Ready;
+        for (const Hold &hold : it->second.waiting)
+            if (hold.reg == reg)
+                return State::Waiting;
+        return State::None;
+    }
+
+    // Students waiting for the title
+    size_t depth(uint64_t isbn) const
+    {
+        auto it = shard(isbn).find(isbn);
+        return it == shard(isbn).end() ? 0 : it->second.waiting.size();
+    }
+
+    // Appends reg to the title's queue; returns its 1-based position, or 0 if
+    // the student already holds the title
+    size_t place(uint32_t reg, uint64_t isbn, time_t now)
+    {
+        if (state(reg, isbn) != State::None)
+            return 0;
+        Queue &queue = shard(isbn)[isbn];
+        queue.waiting.push_back({reg, now, 0});
+        waitingCount++;
+        changes++;
+        counters.placed++;
+        return queue.waiting.size();
+    }
+
+    // Sets a copy from branch aside for the head of the queue; returns false
+    // (and leaves reg alone) if nobody is waiting
+    bool allocate(uint64_t isbn, time_t now, int branch, uint32_t &reg)
+    {
+        if (noneWaiting())
+            return false;
+        auto it = shard(isbn).find(isbn);
+        if (it == shard(isbn).end() || it->second.waiting.empty())
+            return false;
+        Hold hold = it->second.waiting.front();
+        it->second.waiting.pop_front();
+        reg = hold.reg;
+        hold.readyAt = now;
+        hold.branch = branch;
+        it->second.ready.push_back(hold);
+        waitingCount--;
+        readyCount++;
+        changes++;
+        counters.allocated++;
+        counters.waitSeconds += (uint64_t)std::max<time_t>(now - hold.placedAt, 0);
+        return true;
+    }
+
+    // Marks reg's hold ready, with a copy from branch, wherever it is in the
+    // queue (journal replay)
+    bool promote(uint32_t reg, uint64_t isbn, time_t now, int branch)
+    {
+        auto it = shard(isbn).find(isbn);
+        if (it == shard(isbn).end())
+            return false;
+        auto &waiting = it->second.waiting;
+        for (auto hold = waiting.begin(); hold != waiting.end(); ++hold)
+            if (hold->reg == reg)
+            {
+                it->second.ready.push_back({reg, hold->placedAt, now, branch});
+                waiting.erase(hold);
+                waitingCount--;
+                readyCount++;
+                changes++;
+                return true;
+            }
+        return false;
+    }
+
+    // Consumes reg's ready hold when the student collects the copy
+    bool collect(uint32_t reg, uint64_t isbn)
+    {
+        if (noneReady())
+            return false;
+        auto it = shard(isbn).find(isbn);
+        if (it == shard(isbn).end() || !removeFrom(it->second.ready, reg))
+            return false;
+        eraseIfEmpty(shard(isbn), it);
+        readyCount--;
+        changes++;
+        counters.fulfilled++;
+        return true;
+    }
+
+    // Withdraws reg's hold; a Ready result means its copy is free again, and
+    // fromBranch (if given) is set to the branch the copy was taken from
+    State cancel(uint32_t reg, uint64_t isbn, bool expired = false, int *fromBranch = nullptr)
+    {
+        auto it = shard(isbn).find(isbn);
+        if (it == shard(isbn).end())
+            return State::None;
+        State removed = State::None;
+        if (removeFrom(it->second.ready, reg, fromBranch))
+        {
+            readyCount--;
+            removed = State::Ready;
+        }
+        else if (removeFrom(it->second.waiting, reg))
+        {
+            waitingCount--;
+            removed = State::Waiting;
+        }
+        else
+            return State::None;
+        eraseIfEmpty(shard(isbn), it);
+        changes++;
+        (expired ? counters.expired : counters.cancelled)++;
+        return removed;
+    }
+
+    // Drops every hold on a title that left the inventory
+    void dropBook(uint64_t isbn)
+    {
+        auto it = shard(isbn).find(isbn);
+        if (it == shard(isbn).end())
+            return;
+        waitingCount -= it->second.waiting.size();
+        readyCount -= it->second.ready.size();
+        counters.cancelled += it->second.waiting.size() + it->second.ready.size();
+        shard(isbn).erase(it);
+        changes++;
+    }
+
+    // Re-creates a hold read back from holds.txt, in file (queue) order
+    void restore(uint32_t reg, uint64_t isbn, time_t placedAt, time_t readyAt, int branch)
+    {
+        if (state(reg, isbn) != State::None)
+            return;
+        Queue &queue = shard(isbn)[isbn];
+        if (readyAt)
+        {
+            queue.ready.push_back({reg, placedAt, readyAt, branch});
+            readyCount++;
+        }
+        else
+        {
+            queue.waiting.push_back({reg, placedAt, 0});
+            waitingCount++;
+        }
+    }
+
+    // Calls fn(isbn, queue) for every title with holds
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (const auto &map : shards)
+            for (const auto &entry : map)
+                fn(entry.first, entry.second);
+    }
+};
+
+#endif
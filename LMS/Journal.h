@@ -0,0 +1,198 @@
+// Write-Ahead Journal
+// Append-only log of catalog and student mutations (journal.log).
+// Each mutation is written to the file immediately, but fsync is batched: the
+// journal is synced once every SYNC_EVERY records or SYNC_INTERVAL, whichever
+// comes first, and always on sync()/close.
+// append() is safe to call from several threads: each record goes out in a
+// single O_APPEND write, and only the thread that crosses the batch threshold
+// pays for the fsync while the others keep appending.
+//
+// Record format (one per line, tab separated):
+//   <epoch seconds> <op> <fields...>
+// Records carry the resulting state (e.g. copies after the change) rather than
+// a bare delta, so replaying the journal on top of a snapshot that already
+// contains some of its records is harmless.
+
+#ifndef LMS_JOURNAL_H
+#define LMS_JOURNAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+inline int syncFile(int fd) { return _commit(fd); }
+inline int truncateFile(int fd) { return _chsize(fd, 0); }
+#else
+#include <unistd.h>
+inline int syncFile(int fd) { return fsync(fd); }
+inline int truncateFile(int fd) { return ftruncate(fd, 0); }
+#endif
+
+class Journal
+{
+private:
+    static const size_t SYNC_EVERY = 64;
+    static constexpr std::chrono::milliseconds SYNC_INTERVAL{200};
+
+    std::string path;
+    int fd = -1;
+    std::atomic<size_t> unsynced{0};
+    std::atomic<size_t> records{0};
+    std::atomic<uint64_t> appended{0}; // Bytes, never reset
+    std::atomic<std::chrono::steady_clock::rep> lastSync{0};
+    std::mutex syncLock;
+
+    static std::chrono::steady_clock::rep now()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+public:
+    Journal() = default;
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    ~Journal()
+    {
+        close();
+    }
+
+    bool open(const std::string &file)
+    {
+        path = file;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        lastSync = now();
+        return fd >= 0;
+    }
+
+    void close()
+    {
+        if (fd < 0)
+            return;
+        sync();
+        ::close(fd);
+        fd = -1;
+    }
+
+    // Number of records appended since the journal was last truncated
+    size_t size() const
+    {
+        return records;
+    }
+
+    // Bytes appended since the journal was opened, across truncations
+    uint64_t bytesAppended() const
+    {
+        return appended.load(std::memory_order_relaxed);
+    }
+
+    void setSize(size_t n)
+    {
+        records = n;
+    }
+
+    // Appends one record built from the given fields
+    void append(char op, const std::vector<std::string> &fields)
+    {
+        if (fd < 0)
+            return;
+
+        std::string line = std::to_string(time(0));
+        line += '\t';
+        line += op;
+        for (const auto &field : fields)
+        {
+            line += '\t';
+            line += field;
+        }
+        line += '\n';
+
+        if (::write(fd, line.data(), line.size()) != (ssize_t)line.size())
+            return;
+
+        records++;
+        appended.fetch_add(line.size(), std::memory_order_relaxed);
+        bool due = ++unsynced >= SYNC_EVERY ||
+                   now() - lastSync >= std::chrono::duration_cast<std::chrono::steady_clock::duration>(SYNC_INTERVAL).count();
+        if (due && syncLock.try_lock())
+        {
+            syncLocked();
+            syncLock.unlock();
+        }
+    }
+
+    void sync()
+    {
+        std::lock_guard<std::mutex> guard(syncLock);
+        syncLocked();
+    }
+
+private:
+    void syncLocked()
+    {
+        if (fd < 0 || unsynced == 0)
+            return;
+        unsynced = 0;
+        syncFile(fd);
+        lastSync = now();
+    }
+
+public:
+    // Drops every record; called once the journal has been folded into the snapshot files
+    // Must not run concurrently with append().
+    void truncate()
+    {
+        std::lock_guard<std::mutex> guard(syncLock);
+        if (fd < 0)
+            return;
+        truncateFile(fd);
+        syncFile(fd);
+        records = 0;
+        unsynced = 0;
+    }
+
+    // Reads back every complete record. A torn last line (no trailing newline)
+    // from a crash mid-write is ignored.
+    static std::vector<std::vector<std::string>> read(const std::string &file)
+    {
+        std::vector<std::vector<std::string>> entries;
+        std::ifstream in(file, std::ios::binary);
+        if (!in)
+            return entries;
+
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size_t start = 0;
+        size_t end;
+        while ((end = content.find('\n', start)) != std::string::npos)
+        {
+            std::vector<std::string> fields;
+            size_t pos = start;
+            while (true)
+            {
+                size_t tab = content.find('\t', pos);
+                if (tab == std::string::npos || tab > end)
+                {
+                    fields.push_back(content.substr(pos, end - pos));
+                    break;
+                }
+                fields.push_back(content.substr(pos, tab - pos));
+                pos = tab + 1;
+            }
+            if (fields.size() >= 2 && fields[1].size() == 1)
+                entries.push_back(std::move(fields));
+            start = end + 1;
+        }
+        return entries;
+    }
+};
+
+#endif
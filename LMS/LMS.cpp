@@ -1,24 +1,47 @@
 // Library Management System
 
 // User Roles & Authentication
-// Librarian password: lib123 | Counter password: counter123
-// Locks out after 5 failed attempts, logs all login attempts (login_log.txt)
+// Each member of staff has an account (accounts.txt: salted PBKDF2 password hashes), either librarian or counter;
+// the first start creates librarian (password lib123) and counter (counter123). Librarians manage accounts.
+// Failed logins are throttled per username and per terminal (5 in a row, then one a minute; throttle.txt),
+// a login opens a session that server clients resume with its token, and every attempt is logged (login_log.txt)
 
 // Data Validation
 // Email: Must end with @gmail.com, @outlook.com, or @lpu.in
 // Phone: 10 digits, starts with 6-9
+// Reg. No, phone and email must each be unique to one student (emails ignoring case)
 // Reg. No: 8-digit number
-// ISBN: 13-digit number
+// ISBN: 13-digit number; new titles must also carry a valid ISBN-13 check digit
 // Book & Author: Letters, numbers, spaces, basic punctuation only
 
 // Functionalities
 // - Librarian: Add/Delete/Update books & students, view logs
+// - Search books by words (or word prefixes) of the title and author; a misspelt search offers the closest titles
 // - Counter Staff: Issue/Return books, update inventory
-// - Students: Max 3 books
+// - Holds: a student can queue for a title with no copies on the shelf; a returned copy is set aside
+//   for the head of the queue (pickup notice, 3 days to collect). Librarians see queue depths per title.
+// - Branches: one catalog with copies counted per branch (stock_<branch>.txt), transfers between
+//   branches and a where-is-it-available query; counters issue and return at their own branch
+// - Circulation analytics: most borrowed titles, most active borrowers, utilization per title and
+//   issues per hour, kept up to date by every issue/return and rebuilt from circulation_log.txt on all cores
+// - Students: Max 3 books for 14 days; Rs. 5 fine per day late, charged by a daily sweep and on return
 
 // File Management
-// - Stores books (books.txt), students (students.txt), issued books (issued_books.txt), and login logs (login_log.txt)
-// - Loads data on start, saves before exit
+// - Stores books (books.txt), branches (branches.txt, stock_<branch>.txt), students (students.txt), open loans (issued_books.txt), hold queues (holds.txt), fines (fines.txt), accounts (accounts.txt),
+//   failed login buckets (throttle.txt), login attempts (login_log.txt)
+//   and issues/returns (circulation_log.txt); the logs are written asynchronously and rotated by size
+// - Every change is appended to journal.log; books.txt/students.txt are rewritten only on compaction
+// - Loads data on start (replaying the journal), compacts before exit
+// - Optional binary snapshot (lms.snap, --binary-snapshot) is mapped at startup instead of parsing the text files
+// - Bulk CSV import/export: --import-books, --import-students, --export-books, --export-students <file.csv>
+// - Batch mode: --batch <file|-> runs line-delimited commands (see Batch.h) without prompts
+// - Server mode: --serve unix:<path> | tcp:<port> serves the batch commands to counter terminals (Linux);
+//   each connection must log in (or resume a session) before other commands unless started with --no-login
+// - History: daily snapshots (history/, written by a forked child) plus the journal records between them;
+//   --restore-as-of <time> <dir> rebuilds the catalog, students and loans as they were at that time
+// - --data-dir <dir> keeps all data files in dir instead of the working directory
+// - --page-cache <MB> keeps the text of books and students on disk (records.pages) behind a page
+//   cache of that size; only the indexes and numeric columns stay in memory
 
 // Error Handling
 // - Displays errors for invalid input, unavailable books, max books issued, incorrect login, etc.
@@ -28,570 +51,149 @@
 
 #include <iostream>
 #include <fstream>
-#include <vector>
-#include <string>
-#include <regex>   // For email validation
-#include <ctime>   // For getting current timestamp
-#include <iomanip> // For table formatting
-#include <limits>
-#include <unordered_map>
-#include <unordered_set>
+#include "LMS.h"
+#include "Batch.h"
+#include "Server.h"
 
-using namespace std;
-
-// Book Record Class
-class Record
-{
-public:
-    string bookName;
-    string author;
-    string isbn;
-    int copies;
-
-    Record(string bName, string auth, string id, int num)
-    {
-        bookName = bName;
-        author = auth;
-        isbn = id;
-        copies = num;
-    }
-};
-
-// Student Class
-class Student
-{
-public:
-    string firstName;
-    string lastName;
-    string regNumber;
-    string phone;
-    string email;
-
-    Student(string fName, string lName, string reg, string ph, string em)
-    {
-        firstName = fName;
-        lastName = lName;
-        regNumber = reg;
-        phone = ph;
-        email = em;
-    }
-};
-
-// Library Management System Class
-class LMS
+int main(int argc, char *argv[])
 {
-private:
-    string librarianPassword = "lib123";
-    string counterPassword = "counter123";
-    int librarianAttempts = 5;
-    int counterAttempts = 5;
-    vector<Record> books;
-    vector<Student> students;
-    unordered_map<string, int> studentBookCount;
-    unordered_map<string, unordered_set<string>> studentIssuedBooks;
-
-public:
-    LMS()
-    {
-        loadBooks();
-        loadStudents();
-    }
-
-    void loadBooks()
-{
-    ifstream file("books.txt");
-    if (!file)
-    {
-        //cout << "Error: Could not open books.txt\n";
-        return;
-    }
-
-    string bName, auth, id;
-    int num;
-
-    while (getline(file, bName, ',')) // Read book name until comma
-    {
-        getline(file, auth, ','); // Read author until comma
-        file >> id >> num;        // Read ISBN and copies
-        file.ignore();            // Ignore newline at end
-
-        books.push_back(Record(bName, auth, id, num));
-        //cout << "Loaded: " << bName << " | " << auth << " | " << id << " | " << num << endl; // Debug Output
-    }
-
-    file.close();
-}
-
-    void loadStudents()
-    {
-        ifstream file("students.txt");
-        if (!file)
-            return;
-        string fName, lName, regNum, phone, email;
-        while (file >> fName >> lName >> regNum >> phone >> email)
-        {
-            students.push_back(Student(fName, lName, regNum, phone, email));
-        }
-        file.close();
-    }
-
-    void saveBooks()
-{
-    ofstream file("books.txt");
-    if (!file)
-    {
-        cout << "Error: Could not open books.txt for writing\n";
-        return;
-    }
-
-    for (auto &book : books)
-    {
-        file << book.bookName << "," << book.author << "," << book.isbn << " " << book.copies << endl;
-        //cout << "Saving: " << book.bookName << " | " << book.author << " | " << book.isbn << " | " << book.copies << endl; // Debug output
-    }
-
-    file.close();
-}
-
-
-    void saveStudents()
-    {
-        ofstream file("students.txt");
-        for (auto &student : students)
-        {
-            file << student.firstName << " " << student.lastName << " " << student.regNumber << " "
-                 << student.phone << " " << student.email << endl;
-        }
-        file.close();
-    }
-
-    void addStudent()
-    {
-        string fName, lName, regNum, phone, email;
-        cout << "\nEnter first name: ";
-        cin >> fName;
-        cout << "Enter last name: ";
-        cin >> lName;
-        cout << "Enter registration number (8 digits): ";
-        cin >> regNum;
-        while (regNum.length() != 8 || !all_of(regNum.begin(), regNum.end(), ::isdigit))
-        {
-            cout << "Invalid registration number! It must be an 8-digit number: ";
-            cin >> regNum;
-        }
-
-        // Check if student already exists
-        for (const auto &student : students)
-        {
-            if (student.regNumber == regNum)
-            {
-                cout << "\nError: A student with this registration number already exists!\n";
-                return;
-            }
-        }
-
-        cout << "Enter phone number (starting with 6, 7, 8, or 9): ";
-        cin >> phone;
-        while (!(phone[0] == '6' || phone[0] == '7' || phone[0] == '8' || phone[0] == '9') || phone.length() != 10)
-        {
-            cout << "Invalid phone number! It must start with 6, 7, 8, or 9 and be 10 digits long: ";
-            cin >> phone;
-        }
-
-        cout << "Enter email address: ";
-        cin >> email;
-        while (!regex_match(email, regex("^[a-zA-Z0-9._%+-]+@(gmail\\.com|outlook\\.com|lpu\\.in)$")))
-        {
-            cout << "Invalid email! It must end with @gmail.com, @outlook.com, or @lpu.in: ";
-            cin >> email;
-        }
-
-        students.push_back(Student(fName, lName, regNum, phone, email));
-        saveStudents();
-        cout << "\nThe student has been successfully registered.\n";
-    }
-
-    void addBook()
+    bool binarySnapshot = false;
+    size_t pageCacheBytes = 0;
+    string dataDir = ".";
+    string batchFile;
+    string serveEndpoint;
+    bool requireLogin = true;
+    string restoreTime, restoreDir;
+    vector<pair<string, string>> bulkJobs; // Non-interactive import/export requests, in order
+    for (int i = 1; i < argc; i++)
     {
-        string bName, auth, id;
-        int num;
-
-        cout << "\nEnter book name: ";
-        cin.ignore();
-        getline(cin, bName);
-        while (!regex_match(bName, regex("^[a-zA-Z0-9 .,-]+$")))
-        {
-            cout << "Invalid book name! Only letters, numbers, spaces, and basic punctuation allowed: ";
-            getline(cin, bName);
-        }
-
-        cout << "Enter author name: ";
-        getline(cin, auth);
-        while (!regex_match(auth, regex("^[a-zA-Z .,-]+$")))
-        {
-            cout << "Invalid author name! Only letters, spaces, and basic punctuation allowed: ";
-            getline(cin, auth);
-        }
-
-        cout << "Enter ISBN (13 digits): ";
-        cin >> id;
-        while (id.length() != 13 || !all_of(id.begin(), id.end(), ::isdigit))
-        {
-            cout << "Invalid ISBN! It must be exactly 13 digits: ";
-            cin >> id;
-        }
-
-        cout << "Enter number of copies: ";
-        num = getIntInput();
-
-        // Check if book already exists
-        for (auto &book : books)
-        {
-            if (book.isbn == id)
+        string arg = argv[i];
+        if (arg == "--binary-snapshot")
+            binarySnapshot = true;
+        else if (arg == "--data-dir" && i + 1 < argc)
+            dataDir = argv[++i];
+        else if (arg == "--page-cache" && i + 1 < argc)
+        {
+            double megabytes = atof(argv[++i]);
+            if (megabytes <= 0)
             {
-                book.copies += num;
-                saveBooks();
-                cout << "\nThe book already exists. Updated copies count.\n";
-                return;
+                cout << "Error: --page-cache expects a size in MB, got " << argv[i] << "\n";
+                return 1;
             }
-        }
-
-        books.push_back(Record(bName, auth, id, num));
-        saveBooks();
-        cout << "\nThe book has been successfully added.\n";
-    }
-
-    void deleteBook()
-    {
-        string id;
-        cout << "\nEnter ISBN to delete: ";
-        cin >> id;
-
-        for (auto it = books.begin(); it != books.end(); ++it)
-        {
-            if (it->isbn == id)
-            {
-                cout << "Enter number of copies to remove: ";
-                int num;
-                num = getIntInput();
-
-                if (num >= it->copies)
-                {
-                    books.erase(it);
-                    cout << "\nAll copies of the book have been removed from the inventory.\n";
-                }
-                else
-                {
-                    it->copies -= num;
-                    cout << "\n"
-                         << num << " copies have been removed. Remaining: " << it->copies << endl;
-                }
-
-                saveBooks();
-                return;
-            }
-        }
-        cout << "\nBook not found in the inventory.\n";
-    }
-
-    void updateBook()
-    {
-        string id;
-        cout << "\nEnter ISBN to update: ";
-        cin >> id;
-        for (auto &book : books)
-        {
-            if (book.isbn == id)
-            {
-                cout << "Enter new number of copies: ";
-                cin >> book.copies;
-                saveBooks();
-                cout << "\nThe book details have been successfully updated.\n";
-                return;
-            }
-        }
-        cout << "\nBook not found in the inventory.\n";
-    }
-
-    void showAllBooks()
-    {
-        if (books.empty())
-        {
-            cout << "\nThe library inventory is currently empty.\n";
-        }
+            pageCacheBytes = (size_t)(megabytes * 1024 * 1024);
+        }
+        else if (arg == "--batch" && i + 1 < argc)
+            batchFile = argv[++i];
+        else if (arg == "--serve" && i + 1 < argc)
+            serveEndpoint = argv[++i];
+        else if (arg == "--no-login")
+            requireLogin = false;
+        else if (arg == "--restore-as-of" && i + 2 < argc)
+        {
+            restoreTime = argv[++i];
+            restoreDir = argv[++i];
+        }
+        else if ((arg == "--import-books" || arg == "--import-students" || arg == "--export-books" ||
+                  arg == "--export-students") &&
+                 i + 1 < argc)
+            bulkJobs.push_back({arg, argv[++i]});
         else
         {
-            cout << "\n===============================\nList of All Books\n===============================\n";
-            cout << left << setw(30) << "Book Name" << setw(25) << "Author" << setw(20) << "ISBN" << setw(10)<< "Copies\n";
-            cout << "---------------------------------------------------------------\n";
-            for (const auto &book : books)
-            {
-                cout << left << setw(30) << book.bookName << setw(25) << book.author << setw(20) << book.isbn << setw(10)<< book.copies << endl;
-            }
+            cout << "Unknown option: " << arg << "\n";
+            return 1;
         }
     }
 
-    void issueBook()
+    // Works on the files alone, so it also runs while the library is down
+    if (!restoreTime.empty())
     {
-        string id;
-        cout << "\nEnter ISBN: ";
-        cin >> id;
-
-        auto bookIt = find_if(books.begin(), books.end(), [&](const Record &b)
-                              { return b.isbn == id && b.copies > 0; });
-
-        if (bookIt == books.end())
-        {
-            cout << "\nThe requested book is not available or not found in the inventory.\n";
-            return;
+        time_t when = HistoryArchive::parseTime(restoreTime);
+        if (when < 0)
+        {
+            cerr << "Error: Expected YYYY-MM-DD[THH:MM[:SS]] or epoch seconds, got " << restoreTime << "\n";
+            return 1;
+        }
+        RestoreReport report;
+        switch (LMS::restoreAsOf(dataDir, when, restoreDir, &report))
+        {
+        case Status::Ok:
+            cout << "Restored " << restoreDir << " as of " << LMS::formatDate(when) << " from the snapshot of "
+                 << LMS::formatDate(report.snapshotAt) << " and " << report.events << " journal records: "
+                 << report.books << " books, " << report.students << " students, " << report.loans << " loans ("
+                 << report.seconds << " s)\n";
+            return 0;
+        case Status::NotFound:
+            cerr << "Error: The history has no snapshot that old\n";
+            return 1;
+        case Status::Duplicate:
+            cerr << "Error: " << restoreDir << " already holds data files\n";
+            return 1;
+        default:
+            cerr << "Error: Could not write to " << restoreDir << "\n";
+            return 1;
         }
-
-        // Get student details
-        string regNum;
-        cout << "Enter student registration number (8 digits): ";
-        cin >> regNum;
-        while (regNum.length() != 8 || !all_of(regNum.begin(), regNum.end(), ::isdigit))
-        {
-            cout << "Invalid registration number! It must be an 8-digit number: ";
-            cin >> regNum;
-        }
-
-        // Check if the student already has 3 books issued
-        if (studentBookCount[regNum] >= 3)
-        {
-            cout << "\nThis student has already issued 3 books and cannot issue more.\n";
-            return;
-        }
-
-        // Check if the student has already issued this book
-        if (studentIssuedBooks[regNum].find(id) != studentIssuedBooks[regNum].end())
-        {
-            cout << "\nThis student has already issued this book.\n";
-            return;
-        }
-
-        // Issue the book
-        bookIt->copies--;
-        studentBookCount[regNum]++;
-        studentIssuedBooks[regNum].insert(id); // Add the book to the student's issued books set
-
-        saveBooks();
-        logIssuedBook(regNum, bookIt->bookName, bookIt->author, bookIt->isbn);
-
-        // Display receipt for the issued book
-        cout << "\nThe book has been successfully issued.\n";
-        cout << "============================================\n";
-        cout << "Receipt for Book Issue\n";
-        cout << "--------------------------------------------\n";
-        cout << "Book Name: " << bookIt->bookName << "\nAuthor: " << bookIt->author << "\nISBN: " << bookIt->isbn << "\n";
-        cout << "Student Registration Number: " << regNum << "\n";
-        cout << "--------------------------------------------\n";
     }
 
-    void logIssuedBook(const string &regNum, const string &bookName, const string &author, const string &isbn)
+    if (!serveEndpoint.empty())
     {
-        ofstream logFile("issued_books.txt", ios::app);
-        if (logFile.is_open())
-        {
-            time_t now = time(0);
-            char *dt = ctime(&now);
-            dt[strlen(dt) - 1] = '\0';
-
-            logFile << regNum << " " << bookName << " " << author << " " << isbn << " " << dt << endl;
-            logFile.close();
-        }
-        else
-        {
-            cout << "Error: Unable to open issued books log file.\n";
-        }
+#ifdef __linux__
+        LMS library(dataDir, binarySnapshot, true, pageCacheBytes);
+        Server server(library, serveEndpoint, requireLogin);
+        cout << "Serving on " << serveEndpoint << " (Ctrl+C to stop)\n";
+        if (!server.run())
+        {
+            cerr << "Error: Could not listen on " << serveEndpoint << "\n";
+            return 1;
+        }
+        return 0;
+#else
+        cerr << "Error: Server mode is only available on Linux\n";
+        return 1;
+#endif
     }
 
-    void returnBook()
+    if (!batchFile.empty())
     {
-        string id;
-        cout << "\nEnter ISBN of the book to return: ";
-        cin >> id;
+        LMS library(dataDir, binarySnapshot, true, pageCacheBytes);
+        ios::sync_with_stdio(false);
 
-        bool bookFound = false;
-        for (auto &book : books)
+        ifstream file;
+        if (batchFile != "-")
         {
-            if (book.isbn == id)
+            file.open(batchFile);
+            if (!file)
             {
-                book.copies++;
-                bookFound = true;
-
-                // Get student details to display
-                string fName, lName, regNum;
-                cout << "\nEnter student first name: ";
-                cin >> fName;
-                cout << "Enter student last name: ";
-                cin >> lName;
-                cout << "Enter student registration number: ";
-                cin >> regNum;
-
-                cout << "\nThe book has been successfully returned.\n";
-                cout << "============================================\n";
-                cout << "Receipt for Book Return\n";
-                cout << "--------------------------------------------\n";
-                cout << "Book Name: " << book.bookName << "\nAuthor: " << book.author << "\nISBN: " << book.isbn << "\n";
-                cout << "Student Name: " << fName << " " << lName << "\nRegistration Number: " << regNum << "\n";
-                cout << "--------------------------------------------\n";
-
-                // Update the issued books log file
-                removeIssuedBookLog(regNum, id);
-
-                saveBooks();
-                saveStudents();
-                return;
+                cerr << "Error: Could not open " << batchFile << "\n";
+                return 1;
             }
         }
 
-        if (!bookFound)
-        {
-            cout << "\nInvalid ISBN. Book not found in the inventory.\n";
-        }
+        BatchSummary summary = runBatch(library, batchFile == "-" ? cin : file, cout);
+        cerr << summary.commands << " commands (" << summary.ok << " OK, " << summary.commands - summary.ok
+             << " failed) in " << summary.seconds << " s, " << (size_t)(summary.commands / max(summary.seconds, 1e-9))
+             << " commands/sec\n";
+        return 0;
     }
 
-    void removeIssuedBookLog(const string &regNum, const string &isbn)
+    if (!bulkJobs.empty())
     {
-        ifstream inFile("issued_books.txt");
-        ofstream outFile("temp.txt");
-
-        if (!inFile || !outFile)
-        {
-            cout << "Error: Unable to open issued books log file.\n";
-            return;
-        }
-
-        string line;
-        bool bookFound = false;
-
-        while (getline(inFile, line))
-        {
-            stringstream ss(line);
-            string student, bookName, author, bookIsbn;
-            getline(ss, student, ' ');
-            getline(ss, bookName, ' ');
-            getline(ss, author, ' ');
-            getline(ss, bookIsbn, ' ');
-
-            if (student == regNum && bookIsbn == isbn)
-            {
-                bookFound = true;
-            }
+        LMS library(dataDir, binarySnapshot, true, pageCacheBytes);
+        for (const auto &job : bulkJobs)
+        {
+            if (job.first == "--import-books")
+                LMS::printReport("Imported", job.second, library.importBooks(job.second));
+            else if (job.first == "--import-students")
+                LMS::printReport("Imported", job.second, library.importStudents(job.second));
+            else if (job.first == "--export-books")
+                LMS::printReport("Exported", job.second, library.exportBooks(job.second));
             else
-            {
-                outFile << line << endl; // Write the line if it's not the returned book
-            }
-        }
-
-        inFile.close();
-        outFile.close();
-
-        if (bookFound)
-        {
-            remove("issued_books.txt");             // Remove the original log file
-            rename("temp.txt", "issued_books.txt"); // Rename the temp file to update the log
-            cout << "\nIssued book log updated successfully.\n";
-        }
-        else
-        {
-            cout << "\nError: No record of this book being issued to this student.\n";
+                LMS::printReport("Exported", job.second, library.exportStudents(job.second));
         }
+        return 0;
     }
 
-    void showAllStudents()
-    {
-        if (students.empty())
-        {
-            cout << "\nNo students have been registered yet.\n";
-        }
-        else
-        {
-            cout << "\n===============================\nList of All Students\n===============================\n";
-            cout << left << setw(25) << "First Name" << setw(25) << "Last Name" << setw(20) << "Reg. Number" << setw(15) << "Phone" << "Email\n";
-            cout << "---------------------------------------------------------------\n";
-            for (const auto &student : students)
-            {
-                cout << left << setw(25) << student.firstName << setw(25) << student.lastName
-                     << setw(20) << student.regNumber << setw(15) << student.phone << student.email << endl;
-            }
-        }
-    }
-
-    bool authenticate(string role)
-    {
-        string password;
-        int &attempts = (role == "Librarian") ? librarianAttempts : counterAttempts;
-
-        while (attempts > 0)
-        {
-            cout << "\nEnter password: ";
-            cin >> password;
-
-            if ((role == "Librarian" && password == librarianPassword) ||
-                (role == "Counter" && password == counterPassword))
-            {
-                cout << "\nWelcome " << role << "!\n";
-                logLoginAttempt(role, true); // Log successful login
-                return true;
-            }
-            else
-            {
-                attempts--;
-                cout << "\nIncorrect password! Attempts left: " << attempts << "\n";
-                logLoginAttempt(role, false); // Log failed login
-            }
-        }
-
-        cout << "\nToo many failed attempts. Access denied.\n";
-        return false;
-    }
-
-    void logLoginAttempt(const string &role, bool success)
-    {
-        ofstream logFile("login_log.txt", ios::app);
-        if (logFile.is_open())
-        {
-            time_t now = time(0);
-            char *dt = ctime(&now);
-            dt[strlen(dt) - 1] = '\0';
-
-            logFile << "Role: " << role << ", Success: " << (success ? "Yes" : "No") << ", Time: " << dt << endl;
-            logFile.close();
-        }
-        else
-        {
-            cout << "Unable to open log file.\n";
-        }
-    }
-
-    // Function to safely read an integer input
-    int getIntInput()
-    {
-        int choice;
-        while (true)
-        {
-            cin >> choice;
-            if (cin.fail())
-            {
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                cout << "Invalid input! Please enter a valid number: ";
-            }
-            else
-            {
-                break;
-            }
-        }
-        return choice;
-    }
-};
-
-int main()
-{
     cout << "\n==============================\n Welcome to the Library Management System!\n==============================\n";
-    LMS library;
+    LMS library(dataDir, binarySnapshot, true, pageCacheBytes);
     int choice;
     do
     {
@@ -605,7 +207,7 @@ int main()
                 int libChoice;
                 do
                 {
-                    cout << "\n1. Add Book\n2. Delete Book\n3. Update Book\n4. Show All Books\n5. Add Student\n6. Show All Students\n7. Logout\nEnter choice: ";
+                    cout << "\n1. Add Book\n2. Delete Book\n3. Update Book\n4. Show All Books\n5. Search Books\n6. Add Student\n7. Show All Students\n8. View Metrics\n9. View Hold Queues\n10. Circulation Analytics\n11. Branches\n12. Accounts\n13. Logout\nEnter choice: ";
                     libChoice = library.getIntInput();
                     switch (libChoice)
                     {
@@ -622,27 +224,47 @@ int main()
                         library.showAllBooks();
                         break;
                     case 5:
-                        library.addStudent();
+                        library.searchBooks();
                         break;
                     case 6:
-                        library.showAllStudents();
+                        library.addStudent();
                         break;
                     case 7:
+                        library.showAllStudents();
+                        break;
+                    case 8:
+                        library.showMetrics();
+                        break;
+                    case 9:
+                        library.showHoldQueues();
+                        break;
+                    case 10:
+                        library.showAnalytics();
+                        break;
+                    case 11:
+                        library.manageBranches();
+                        break;
+                    case 12:
+                        library.manageAccounts();
+                        break;
+                    case 13:
                         break;
                     default:
                         cout << "Invalid option! Please try again.\n";
                     }
-                } while (libChoice != 7);
+                } while (libChoice != 13);
+                library.logoutConsole();
             }
         }
         else if (choice == 2)
         {
             if (library.authenticate("Counter"))
             {
+                library.chooseCounterBranch();
                 int counterChoice;
                 do
                 {
-                    cout << "\n1. Issue Book\n2. Return Book\n3. Show All Books\n4. Show All Students\n5. Logout\nEnter choice: ";
+                    cout << "\n1. Issue Book\n2. Return Book\n3. Show All Books\n4. Search Books\n5. Show All Students\n6. Cancel Hold\n7. Overdue Loans\n8. Pay Fine\n9. Find Student\n10. Find a Copy\n11. Logout\nEnter choice: ";
                     counterChoice = library.getIntInput();
                     switch (counterChoice)
                     {
@@ -656,14 +278,33 @@ int main()
                         library.showAllBooks();
                         break;
                     case 4:
-                        library.showAllStudents();
+                        library.searchBooks();
                         break;
                     case 5:
+                        library.showAllStudents();
+                        break;
+                    case 6:
+                        library.cancelHold();
+                        break;
+                    case 7:
+                        library.showDueLoans();
+                        break;
+                    case 8:
+                        library.payFine();
+                        break;
+                    case 9:
+                        library.findStudent();
+                        break;
+                    case 10:
+                        library.showWhereAvailable();
+                        break;
+                    case 11:
                         break;
                     default:
                         cout << "Invalid option! Please try again.\n";
                     }
-                } while (counterChoice != 5);
+                } while (counterChoice != 11);
+                library.logoutConsole();
             }
         }
         else if (choice != 3)
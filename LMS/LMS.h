@@ -0,0 +1,3994 @@
+// Library Management System - data model and the LMS class
+// See LMS.cpp for an overview of roles, validation rules and data files.
+
+#ifndef LMS_LMS_H
+#define LMS_LMS_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <ctime>   // For getting current timestamp
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <chrono>
+#include <iomanip> // For table formatting
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include "Journal.h"
+#include "Loans.h"
+#include "Holds.h"
+#include "Fines.h"
+#include "Analytics.h"
+#include "Branches.h"
+#include "History.h"
+#include "Snapshot.h"
+#include "Validation.h"
+#include "Csv.h"
+#include "SearchIndex.h"
+#include "Listing.h"
+#include "Tables.h"
+#include "AuditLog.h"
+#include "Accounts.h"
+#include "Metrics.h"
+
+using namespace std;
+
+// ISBN Key
+// A 13-digit ISBN is below 10^13 < 2^44, so it packs losslessly into a 64-bit integer.
+// The catalog index is keyed on this instead of the string to keep lookups cheap.
+const uint64_t INVALID_ISBN_KEY = UINT64_MAX;
+
+inline uint64_t packIsbn(const string &isbn)
+{
+    if (isbn.length() != 13)
+        return INVALID_ISBN_KEY;
+
+    uint64_t key = 0;
+    for (char c : isbn)
+    {
+        if (c < '0' || c > '9')
+            return INVALID_ISBN_KEY;
+        key = key * 10 + (c - '0');
+    }
+    return key;
+}
+
+// Registration numbers are 8 digits, so they pack into 32 bits the same way
+const uint32_t INVALID_REG_KEY = UINT32_MAX;
+
+inline uint32_t packRegNumber(const string &reg)
+{
+    if (reg.length() != 8)
+        return INVALID_REG_KEY;
+
+    uint32_t key = 0;
+    for (char c : reg)
+    {
+        if (c < '0' || c > '9')
+            return INVALID_REG_KEY;
+        key = key * 10 + (c - '0');
+    }
+    return key;
+}
+
+// Phone numbers are 10 digits and pack into 64 bits
+const uint64_t INVALID_PHONE_KEY = UINT64_MAX;
+
+inline uint64_t packPhone(const string &phone)
+{
+    if (phone.length() != 10)
+        return INVALID_PHONE_KEY;
+
+    uint64_t key = 0;
+    for (char c : phone)
+    {
+        if (c < '0' || c > '9')
+            return INVALID_PHONE_KEY;
+        key = key * 10 + (c - '0');
+    }
+    return key;
+}
+
+// Email Key
+// Emails are unique regardless of case. The email index is keyed on a 64-bit
+// FNV-1a hash of the lower-cased address instead of a copy of the text; a
+// lookup confirms each hit against the student's stored email.
+inline uint64_t emailKey(string_view email)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : email)
+    {
+        hash ^= (unsigned char)tolower((unsigned char)c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline string unpackKey(uint64_t key, int digits)
+{
+    string text(digits, '0');
+    for (int i = digits - 1; i >= 0 && key > 0; i--, key /= 10)
+        text[i] = char('0' + key % 10);
+    return text;
+}
+
+// Book Record Class
+class Record
+{
+public:
+    string bookName;
+    string author;
+    string isbn;
+    int copies;
+
+    Record(string bName, string auth, string id, int num)
+        : bookName(std::move(bName)), author(std::move(auth)), isbn(std::move(id)), copies(num)
+    {
+    }
+};
+
+// Student Class
+class Student
+{
+public:
+    string firstName;
+    string lastName;
+    string regNumber;
+    string phone;
+    string email;
+
+    Student(string fName, string lName, string reg, string ph, string em)
+        : firstName(std::move(fName)), lastName(std::move(lName)), regNumber(std::move(reg)), phone(std::move(ph)),
+          email(std::move(em))
+    {
+    }
+};
+
+// A returned or restocked copy set aside for the student at the head of the
+// title's hold queue, to be collected by pickupBy
+struct HoldNotice
+{
+    string regNumber;
+    string studentName; // Empty if the registration number is not on file
+    string email;
+    string isbn;
+    string bookName;
+    time_t pickupBy;
+};
+
+// An open loan, as listed by the overdue and due-soon reports
+struct DueLoan
+{
+    string regNumber;
+    string isbn;
+    string bookName;
+    time_t issuedAt;
+    time_t dueAt;
+    long long daysLate; // Full days past the due date, as of the report
+};
+
+// What a return cost and set in motion
+struct ReturnInfo
+{
+    long long daysLate = 0;
+    long long fine = 0;          // For this loan, all days late included
+    long long balance = 0;       // Everything the student owes after this return
+    vector<HoldNotice> notices;  // Copy set aside for the next student in the hold queue
+};
+
+// What a login returned
+struct LoginInfo
+{
+    string token;                           // Session to present instead of the password
+    AccountRole role = AccountRole::Counter;
+    long long retryAfter = 0;               // Seconds to wait when throttled
+};
+
+// Outcome of one fine sweep
+struct FineSweepReport
+{
+    size_t overdueLoans = 0; // Loans at least a day late
+    size_t charged = 0;      // Loans that were charged for new days
+    long long amount = 0;
+};
+
+// Hold queue of one title, for deciding which titles need more copies
+struct HoldQueueInfo
+{
+    string isbn;
+    string bookName;
+    int copies;       // On the shelf
+    int onLoan;
+    size_t waiting;   // Students in the queue
+    size_t ready;     // Copies set aside, not yet collected
+    time_t oldestHold; // When the longest-waiting student placed the hold
+};
+
+// One title in the circulation report
+struct TitleActivity
+{
+    string isbn;
+    string bookName;
+    uint64_t issues;    // During the report period
+    int copies;         // On the shelf and on loan now
+    int onLoan;
+    double utilization; // Share of the period its copies spent on loan, 0 to 1
+};
+
+// A student in the circulation report. The issue count comes from a heavy
+// hitter counter: it is at most error too high.
+struct BorrowerActivity
+{
+    string regNumber;
+    string studentName; // Empty if the registration number is not on file
+    uint64_t issues;
+    uint64_t error;
+};
+
+struct HourActivity
+{
+    time_t start;
+    uint64_t issues;
+    uint64_t returns;
+};
+
+// Circulation since periodStart: the circulation log when the analytics were
+// last rebuilt from it, otherwise startup
+struct CirculationReport
+{
+    time_t periodStart = 0;
+    uint64_t issues = 0;
+    uint64_t returns = 0;
+    vector<TitleActivity> mostBorrowed;
+    vector<TitleActivity> mostUtilized;
+    vector<BorrowerActivity> mostActive;
+    vector<HourActivity> recentHours;   // Oldest first, ending with the current hour
+    vector<uint64_t> issuesByWeekHour;  // 168 hours from Sunday 00:00, local time
+};
+
+// Copies on the shelf at one branch: of one title, or of the whole catalog
+struct BranchCopies
+{
+    string branch;
+    long long copies;
+};
+
+// What a point-in-time restore started from and rebuilt
+struct RestoreReport
+{
+    time_t snapshotAt = 0; // The history snapshot it was rebuilt from
+    size_t events = 0;     // Journal records replayed on top of it
+    size_t books = 0;
+    size_t students = 0;
+    size_t loans = 0;
+    double seconds = 0;
+};
+
+// Outcome of an API operation
+enum class Status
+{
+    Ok,
+    NotFound,      // No such book, student or hold
+    Unavailable,   // No copies left on the shelf
+    Available,     // Copies are on the shelf, so there is nothing to hold
+    LimitReached,  // Student already has the maximum number of books
+    AlreadyIssued, // Student already has this book
+    NotIssued,     // No loan of this book to this student
+    Duplicate,     // Registration number, phone or email already taken, or hold already placed
+    Invalid,       // Input failed validation
+    Denied,        // Wrong user name or password, or no session allowed to do this
+    Throttled      // Too many failed logins for the user or terminal; try again later
+};
+
+inline const char *statusName(Status status)
+{
+    switch (status)
+    {
+    case Status::Ok:
+        return "OK";
+    case Status::NotFound:
+        return "NOT_FOUND";
+    case Status::Unavailable:
+        return "UNAVAILABLE";
+    case Status::Available:
+        return "AVAILABLE";
+    case Status::LimitReached:
+        return "LIMIT_REACHED";
+    case Status::AlreadyIssued:
+        return "ALREADY_ISSUED";
+    case Status::NotIssued:
+        return "NOT_ISSUED";
+    case Status::Duplicate:
+        return "DUPLICATE";
+    case Status::Denied:
+        return "DENIED";
+    case Status::Throttled:
+        return "THROTTLED";
+    default:
+        return "INVALID";
+    }
+}
+
+// Library Management System Class
+class LMS
+{
+private:
+    string dataDir;
+    // Staff accounts, failed login buckets and open sessions (see Accounts.h).
+    // Password hashing runs outside accountLock, so logins do not queue behind it.
+    mutable mutex accountLock;
+    AccountTable accounts;
+    LoginThrottle throttle;
+    uint64_t savedThrottleVersion = 0; // throttle.version() when throttle.txt was last written
+    SessionTable sessions;
+    string consoleSession; // Session of whoever is logged in at the interactive menus
+    // Books and students are stored column-wise with their text in one
+    // interned pool (see Tables.h); Record and Student are only used to pass
+    // copies of a row in and out of the class
+    StringPool strings;
+    BookTable books;
+    BranchStock branches; // Shelf counts per branch; books.copies is the total (see Branches.h)
+    StudentTable students;
+    unordered_map<uint64_t, size_t> bookIndex;    // Packed ISBN -> position in books
+    SearchIndex searchIndex;                      // Title/author words -> packed ISBNs
+    unordered_map<uint32_t, size_t> studentIndex; // Packed reg. number -> position in students
+    SearchIndex nameIndex;                        // First/last name words -> packed reg. numbers
+    unordered_multimap<uint64_t, uint32_t> emailIndex; // emailKey -> reg. number
+    unordered_multimap<uint64_t, uint32_t> phoneIndex; // Packed phone -> reg. number; a few older records share one
+    LoanTable loans;
+    HoldTable holds;
+    uint64_t savedHoldsVersion = 0; // holds.version() when holds.txt was last written
+    FineLedger fines;
+    uint64_t savedFinesVersion = 0; // fines.version() when fines.txt was last written
+    Analytics analytics;            // Circulation aggregates (see Analytics.h)
+    Journal journal;
+    AuditLog loginLog;       // login_log.txt
+    AuditLog circulationLog; // circulation_log.txt: every issue and return, kept for the analytics
+    mutable Metrics metrics; // Recorded by const readers too (search)
+
+    // Cached sort orders for paged listings. bookVersion and studentVersion
+    // change whenever a record is added or removed (under the exclusive catalog
+    // lock), copiesVersion whenever a shelf count changes.
+    uint64_t bookVersion = 0;
+    uint64_t studentVersion = 0;
+    atomic<uint64_t> copiesVersion{0};
+    SortedView bookViews[4];    // By BookOrder
+    SortedView studentViews[3]; // By StudentOrder
+    bool binarySnapshot = false;
+    // A live library keeps history and sweeps fines; a copy rebuilt by
+    // restoreAsOf only loads and saves its files
+    bool live = true;
+    HistoryArchive history;              // <data dir>/history (see History.h)
+    thread historyReaper;                // Waits for the process writing a history snapshot
+    atomic<bool> historyWriting{false};
+    // Journal size at which to try again after a checkpoint could not move the
+    // journal into the history; 0 while checkpoints succeed
+    atomic<size_t> checkpointRetryAt{0};
+    string counterBranch; // Branch the interactive counter session is at; empty for main
+
+    // Exclusive for structural changes (adding/removing records, checkpoints),
+    // shared for counter operations, which then lock their student and book stripes
+    mutable shared_mutex catalogLock;
+    mutable mutex studentLocks[LoanTable::SHARDS];
+    mutable mutex bookLocks[LoanTable::SHARDS];
+
+    static const int MAX_BOOKS_PER_STUDENT = 3;
+
+    // A copy set aside for a hold goes back on the shelf if not collected within this
+    static const int HOLD_PICKUP_DAYS = 3;
+
+    // Loan period, and the fine for every full day a book is kept past it
+    static const int LOAN_DAYS = 14;
+    static const int FINE_PER_DAY = 5;
+
+    // The circulation log is the history the analytics are rebuilt from, so it
+    // keeps far more than the login log: 32 files of 64 MB, years of loans
+    static const size_t CIRCULATION_LOG_BYTES = 64 * 1024 * 1024;
+    static const int CIRCULATION_LOG_FILES = 32;
+
+    // Rows per page in the interactive listings
+    static const size_t PAGE_SIZE = 25;
+
+    // Fold the journal back into the text files once it holds this many records
+    static const size_t COMPACT_EVERY = 10000;
+
+    mutex &studentLock(uint32_t reg) const
+    {
+        return studentLocks[LoanTable::studentShard(reg)];
+    }
+
+    mutex &bookLock(uint64_t isbn) const
+    {
+        return bookLocks[LoanTable::bookShard(isbn)];
+    }
+
+    // Adds copies to an existing title at branch; returns false if the ISBN is
+    // not in the inventory. Caller holds catalogLock (shared or exclusive).
+    bool restockBook(const string &id, int num, int branch)
+    {
+        uint64_t key = packIsbn(id);
+        auto it = bookIndex.find(key);
+        if (it == bookIndex.end())
+            return false;
+        lock_guard<mutex> bookGuard(bookLock(key));
+        addToShelf(branch, it->second, num);
+        logShelfChange('C', {id, to_string(books.copies(it->second))}, branch, it->second);
+        serveHolds(key, id, it->second, branch, nullptr);
+        return true;
+    }
+
+    // Copies of the book at pos on the shelf at branch b; caller holds its stripe lock
+    int shelfAt(int b, size_t pos) const
+    {
+        return branches.at(b, pos, books.copies(pos));
+    }
+
+    // Puts delta copies on branch b's shelf (or takes them off, if negative)
+    // and adjusts the title's total to match. Caller holds the stripe lock.
+    void addToShelf(int b, size_t pos, int delta)
+    {
+        books.copies(pos) += delta;
+        if (b != BranchStock::MAIN)
+            branches.set(b, pos, shelfAt(b, pos) + delta);
+        copiesChanged();
+    }
+
+    // Journals a change to a title's shelf count. The fields end with the
+    // total; a change at a branch other than main adds the branch's name and
+    // new count, main's own count being whatever the others leave of the total.
+    void logShelfChange(char op, vector<string> fields, int b, size_t pos)
+    {
+        if (b != BranchStock::MAIN)
+        {
+            fields.push_back(branches.name(b));
+            fields.push_back(to_string(shelfAt(b, pos)));
+        }
+        logChange(op, fields);
+    }
+
+    // Sets a branch count read back from the journal; main's follows from the total
+    void restoreShelf(size_t pos, const string &branch, const string &copies)
+    {
+        int b = branches.find(branch);
+        if (b > 0)
+            branches.set(b, pos, stoi(copies));
+    }
+
+    string stockPath(const string &branch) const
+    {
+        return dataPath("stock_" + branch + ".txt");
+    }
+
+    // Looks up a book by ISBN in O(1) and returns its shelf count, or nullptr
+    // if it is not in the inventory. The pointer stays valid while catalogLock is held.
+    int *findCopies(const string &id)
+    {
+        auto it = bookIndex.find(packIsbn(id));
+        return it == bookIndex.end() ? nullptr : &books.copies(it->second);
+    }
+
+    string text(PooledString ref) const
+    {
+        return string(strings.view(ref));
+    }
+
+    Record bookRecord(size_t pos) const
+    {
+        return Record(text(books.nameRef(pos)), text(books.authorRef(pos)), unpackKey(books.isbn(pos), 13),
+                      books.copies(pos));
+    }
+
+    Student studentRecord(size_t pos) const
+    {
+        return Student(text(students.firstNameRef(pos)), text(students.lastNameRef(pos)), unpackKey(students.reg(pos), 8),
+                       unpackKey(students.phone(pos), 10), text(students.emailRef(pos)));
+    }
+
+    void copiesChanged()
+    {
+        copiesVersion.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Adds a title that is not in the inventory yet; ISBNs that do not pack are ignored
+    void insertBook(string_view bName, string_view auth, const string &id, int num)
+    {
+        uint64_t key = packIsbn(id);
+        if (key == INVALID_ISBN_KEY)
+            return;
+        bookVersion++;
+        bookIndex[key] = books.add(strings, key, num, bName, auth);
+        branches.addRow();
+        searchIndex.add(key, bName, auth);
+    }
+
+    // Removes the book at pos by moving the last book into its slot, so only
+    // one index entry has to be fixed up instead of shifting the whole table
+    void removeBookAt(size_t pos)
+    {
+        bookVersion++;
+        uint64_t key = books.isbn(pos);
+        bookIndex.erase(key);
+        holds.dropBook(key);
+        searchIndex.remove(key, strings.view(books.nameRef(pos)), strings.view(books.authorRef(pos)));
+        books.removeAt(strings, pos);
+        branches.removeAt(pos);
+        if (pos != books.size())
+            bookIndex[books.isbn(pos)] = pos;
+    }
+
+    // Applies one journal record on top of the loaded snapshot
+    void applyJournalEntry(const vector<string> &e)
+    {
+        char op = e[1][0];
+        if (op == 'B' && e.size() == 6)
+        {
+            int num = stoi(e[3]);
+            if (int *copies = findCopies(e[2]))
+                *copies = num;
+            else
+                insertBook(e[4], e[5], e[2], num);
+        }
+        else if ((op == 'C' && (e.size() == 4 || e.size() == 6)) ||
+                 ((op == 'I' || op == 'R' || op == 'A' || op == 'U') && (e.size() == 5 || e.size() == 7)))
+        {
+            // Records of a change at a branch other than main end with its name and count
+            size_t total = op == 'C' ? 3 : 4;
+            auto it = bookIndex.find(packIsbn(e[total - 1]));
+            if (it != bookIndex.end())
+            {
+                books.copies(it->second) = stoi(e[total]);
+                if (e.size() > total + 1)
+                    restoreShelf(it->second, e[total + 1], e[total + 2]);
+            }
+            if (op == 'I')
+            {
+                time_t issuedAt = stoll(e[0]);
+                loans.add(packRegNumber(e[2]), packIsbn(e[3]), issuedAt, issuedAt + LOAN_DAYS * 86400);
+                holds.collect(packRegNumber(e[2]), packIsbn(e[3]));
+            }
+            else if (op == 'R')
+                loans.remove(packRegNumber(e[2]), packIsbn(e[3]));
+            else if (op == 'A')
+            {
+                // The copy came from the branch named in the record, if any
+                int from = e.size() > total + 1 ? branches.find(e[total + 1]) : BranchStock::MAIN;
+                holds.promote(packRegNumber(e[2]), packIsbn(e[3]), stoll(e[0]), max(from, (int)BranchStock::MAIN));
+            }
+            else if (op == 'U')
+                holds.cancel(packRegNumber(e[2]), packIsbn(e[3]));
+        }
+        else if (op == 'T' && e.size() == 7)
+        {
+            // A transfer leaves the total alone and sets both branches' counts
+            auto it = bookIndex.find(packIsbn(e[2]));
+            if (it != bookIndex.end())
+            {
+                restoreShelf(it->second, e[3], e[4]);
+                restoreShelf(it->second, e[5], e[6]);
+            }
+        }
+        else if (op == 'H' && e.size() == 4)
+        {
+            holds.place(packRegNumber(e[2]), packIsbn(e[3]), stoll(e[0]));
+        }
+        else if (op == 'F' && e.size() == 4)
+        {
+            fines.set(packRegNumber(e[2]), stoll(e[3]));
+        }
+        else if (op == 'W' && e.size() == 3)
+        {
+            // A sweep only depends on the loans open at that point, which the
+            // replay has just rebuilt, so running it again gives the same charges
+            sweepFinesLocked(stoll(e[2]), false);
+        }
+        else if (op == 'X' && e.size() == 3)
+        {
+            auto it = bookIndex.find(packIsbn(e[2]));
+            if (it != bookIndex.end())
+                removeBookAt(it->second);
+        }
+        else if (op == 'S' && e.size() == 7)
+        {
+            insertStudent(Student(e[2], e[3], e[4], e[5], e[6]));
+        }
+    }
+
+    void replayJournal()
+    {
+        auto entries = Journal::read(dataPath("journal.log"));
+        for (const auto &entry : entries)
+        {
+            try
+            {
+                applyJournalEntry(entry);
+            }
+            catch (const exception &)
+            {
+                // Skip records with unparseable numbers
+            }
+        }
+        journal.open(dataPath("journal.log"));
+        journal.setSize(entries.size());
+    }
+
+    // Records a mutation. Callers hold the locks that order it against other
+    // changes to the same book or student.
+    void logChange(char op, const vector<string> &fields)
+    {
+        journal.append(op, fields);
+    }
+
+    // "<event> <reg. number> <isbn>" line for the circulation log; formatted on
+    // the stack so the request path makes no allocation and no system call
+    void logCirculation(const char *event, const string &regNum, const string &id)
+    {
+        char line[64];
+        int n = snprintf(line, sizeof(line), "%s %.8s %.13s", event, regNum.c_str(), id.c_str());
+        circulationLog.write(string_view(line, min(n, (int)sizeof(line) - 1)));
+    }
+
+    // "FINE_PAID <reg. number> <amount>" line for the circulation log; the
+    // amount has its own field rather than borrowing the 13-character ISBN one
+    void logFinePaid(const string &regNum, long long amount)
+    {
+        char line[64];
+        int n = snprintf(line, sizeof(line), "FINE_PAID %.8s %lld", regNum.c_str(), amount);
+        circulationLog.write(string_view(line, min(n, (int)sizeof(line) - 1)));
+    }
+
+    // Circulation figures of the book at pos; callers hold its stripe lock.
+    // Utilization compares the time on loan with the copies it has now.
+    TitleActivity titleActivityLocked(uint64_t isbn, size_t pos, time_t now) const
+    {
+        int onLoan = (int)loans.borrowers(isbn);
+        int copies = books.copies(pos) + onLoan;
+        const Analytics::TitleStats *stats = analytics.title(isbn);
+        double capacity = (double)copies * max<time_t>(now - analytics.periodStart(), 1);
+        double utilization = copies ? analytics.busySeconds(isbn, onLoan, now) / capacity : 0;
+        return {unpackKey(isbn, 13), text(books.nameRef(pos)), stats ? stats->issues : 0, copies, onLoan,
+                min(utilization, 1.0)};
+    }
+
+    // Sets copies of the book at pos aside for the students at the head of its
+    // hold queue while any are on the shelf, and adds a pickup notice for each
+    // to notices. A copy is taken from branch (where it just arrived) if it
+    // has one, otherwise from the first branch that does; the hold remembers
+    // which, so the copy goes back there if it is not collected. Caller holds
+    // catalogLock and the book's stripe lock. Costs one atomic load when
+    // nobody is waiting for anything.
+    void serveHolds(uint64_t key, const string &id, size_t pos, int branch, vector<HoldNotice> *notices)
+    {
+        uint32_t reg;
+        while (books.copies(pos) > 0 && !holds.noneWaiting())
+        {
+            int from = branch;
+            for (int b = 0; shelfAt(from, pos) <= 0 && b < (int)branches.count(); b++)
+                from = b;
+            if (!holds.allocate(key, time(0), from, reg))
+                break;
+            addToShelf(from, pos, -1);
+            string regNum = unpackKey(reg, 8);
+            logShelfChange('A', {regNum, id, to_string(books.copies(pos))}, from, pos);
+            logCirculation("HOLD_READY", regNum, id);
+            if (!notices)
+                continue;
+
+            HoldNotice notice{regNum, "", "", id, "", time(0) + HOLD_PICKUP_DAYS * 86400};
+            notice.bookName = text(books.nameRef(pos));
+            auto student = studentIndex.find(reg);
+            if (student != studentIndex.end())
+            {
+                notice.studentName = text(students.firstNameRef(student->second)) + " " +
+                                     text(students.lastNameRef(student->second));
+                notice.email = text(students.emailRef(student->second));
+            }
+            notices->push_back(std::move(notice));
+        }
+    }
+
+    // Puts copies that were set aside but not collected in time back on the
+    // shelf (or on to the next student in the queue). Caller holds catalogLock exclusively.
+    void expireHoldsLocked()
+    {
+        if (holds.noneReady())
+            return;
+        time_t cutoff = time(0) - HOLD_PICKUP_DAYS * 86400;
+        vector<pair<uint32_t, uint64_t>> expired;
+        holds.forEach([&](uint64_t isbn, const HoldTable::Queue &queue)
+                      {
+            for (const auto &hold : queue.ready)
+                if (hold.readyAt < cutoff)
+                    expired.push_back({hold.reg, isbn}); });
+        for (const auto &hold : expired)
+        {
+            string regNum = unpackKey(hold.first, 8), id = unpackKey(hold.second, 13);
+            auto it = bookIndex.find(hold.second);
+            int from = BranchStock::MAIN;
+            holds.cancel(hold.first, hold.second, true, &from);
+            if (it == bookIndex.end())
+                continue;
+            // The copy goes back on the shelf of the branch it was taken from
+            addToShelf(from, it->second, 1);
+            logShelfChange('U', {regNum, id, to_string(books.copies(it->second))}, from, it->second);
+            logCirculation("HOLD_EXPIRED", regNum, id);
+            serveHolds(hold.second, id, it->second, from, nullptr);
+        }
+    }
+
+    // Charges every loan at least a day overdue for the days it became late
+    // since the previous sweep (see Fines.h). Caller holds catalogLock exclusively.
+    FineSweepReport sweepFinesLocked(time_t now, bool journaled = true)
+    {
+        FineSweepReport report;
+        loans.forEachDue(0, now - 86400 + 1, [&](uint32_t reg, uint64_t, time_t dueAt)
+                         {
+            report.overdueLoans++;
+            long long days = fines.unchargedDays(dueAt, now);
+            if (days <= 0)
+                return;
+            fines.charge(reg, days * FINE_PER_DAY);
+            report.charged++;
+            report.amount += days * FINE_PER_DAY; });
+        fines.setLastSweepTime(now);
+        if (journaled)
+            logChange('W', {to_string(now)});
+        return report;
+    }
+
+    // The first sweep of each (UTC) day is due
+    bool fineSweepDue() const
+    {
+        return time(0) / 86400 > fines.lastSweepTime() / 86400;
+    }
+
+    // Compacts once the journal grows large enough; called with no locks held
+    void maybeCheckpoint()
+    {
+        if (fineSweepDue())
+            sweepFines();
+        if (!checkpointDue())
+            return;
+        unique_lock<shared_mutex> guard(catalogLock);
+        if (checkpointDue())
+            checkpointLocked();
+    }
+
+    bool checkpointDue() const
+    {
+        size_t size = journal.size();
+        if (size < checkpointRetryAt.load(memory_order_relaxed))
+            return false;
+        return size >= COMPACT_EVERY || historySnapshotDue();
+    }
+
+    bool historySnapshotDue() const
+    {
+        return live && !historyWriting.load(memory_order_relaxed) && history.snapshotDue(time(0), journal.size());
+    }
+
+    // Starts a history snapshot of the state as it is now. A forked child
+    // writes it from its copy-on-write image of memory, so the catalog lock is
+    // held only for the fork, and issues and returns go on while the file is
+    // written. Caller holds catalogLock exclusively: no other thread is
+    // halfway through a change the child would inherit, and the journal has
+    // just been moved into the previous segment.
+    void snapshotHistoryLocked()
+    {
+        if (historyReaper.joinable())
+            historyReaper.join();
+        time_t now = time(0);
+        history.beginSegment(now);
+        string dir = history.directory();
+        auto start = Metrics::Clock::now();
+#ifndef _WIN32
+        pid_t child = fork();
+        if (child == 0)
+            _exit(writeHistorySnapshot(dir, now) ? 0 : 1);
+        if (child > 0)
+        {
+            historyWriting = true;
+            historyReaper = thread([this, child, dir, now, start]
+                                   {
+                int status = 0;
+                waitpid(child, &status, 0);
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                    metrics.recordSave(SaveFile::History, start, fileSize(HistoryArchive::snapshotPath(dir, now)));
+                else
+                    cout << "Error: Could not write the history snapshot in " << dir << "\n";
+                historyWriting = false; });
+            return;
+        }
+#endif
+        // No fork (Windows, or it failed): write it here, under the lock
+        if (writeHistorySnapshot(dir, now))
+            metrics.recordSave(SaveFile::History, start, fileSize(HistoryArchive::snapshotPath(dir, now)));
+        else
+            cout << "Error: Could not write the history snapshot in " << dir << "\n";
+    }
+
+    // Writes the history snapshot taken at at: branch counts first, so a
+    // snapshot on disk always has its stock. Runs in the forked child, so it
+    // must not touch anything another thread of the parent could have held
+    // locked at the fork (metrics, logs, cout).
+    bool writeHistorySnapshot(const string &dir, time_t at) const
+    {
+        if (branches.count() > 1)
+        {
+            DurableWriter stock(HistoryArchive::stockPath(dir, at));
+            for (int b = 1; b < (int)branches.count(); b++)
+                for (size_t pos = 0; pos < books.size(); pos++)
+                    if (int copies = branches.at(b, pos, books.copies(pos)))
+                        stock.append(branches.name(b)).append(' ').appendNumber(books.isbn(pos), 13).append(' ').appendNumber(copies).append('\n');
+            if (!stock.commit())
+                return false;
+        }
+        return writeSnapshot(HistoryArchive::snapshotPath(dir, at));
+    }
+
+    // takeSnapshot starts a history snapshot even if none is due yet
+    void checkpointLocked(bool shutdown = false, bool takeSnapshot = false)
+    {
+        OperationTimer timer(metrics, Op::Checkpoint);
+        expireHoldsLocked();
+        journal.sync();
+        // The records leave journal.log for the history segment they belong to.
+        // If the history cannot take them, nothing is saved and the journal is
+        // kept, so the files and the journal still agree and no record is lost;
+        // the checkpoint is tried again after COMPACT_EVERY more records.
+        if (live && !history.appendEvents(dataPath("journal.log"), journal.size()))
+        {
+            cout << "Error: Could not append the journal to " << dataPath("history") << "; checkpoint skipped\n";
+            checkpointRetryAt = journal.size() + COMPACT_EVERY;
+            return;
+        }
+        checkpointRetryAt = 0;
+        timer.succeeded();
+        if (!binarySnapshot || shutdown)
+        {
+            saveBooks();
+            saveStudents();
+            saveLoans();
+        }
+        // Queues are small and change rarely, so they are kept in text in both modes
+        if (holds.version() != savedHoldsVersion)
+            saveHolds();
+        if (fines.version() != savedFinesVersion)
+            saveFines();
+        if (live)
+            saveThrottle();
+        saveStock();
+        // Written after the text files so its timestamp marks it as the newest copy
+        if (binarySnapshot)
+            saveSnapshot();
+        journal.truncate();
+        if (live && !historyWriting && (takeSnapshot || historySnapshotDue()))
+            snapshotHistoryLocked();
+        compactStrings();
+    }
+
+    // Adds a student unless the registration number is already taken. Phone and
+    // email are indexed but not checked here (see contactConflict), so data
+    // files with older duplicates still load.
+    bool insertStudent(string_view fName, string_view lName, uint32_t reg, uint64_t phone, string_view email)
+    {
+        if (!studentIndex.emplace(reg, students.size()).second)
+            return false;
+        studentVersion++;
+        students.add(strings, reg, phone, fName, lName, email);
+        emailIndex.emplace(emailKey(email), reg);
+        phoneIndex.emplace(phone, reg);
+        nameIndex.add(reg, fName, lName);
+        return true;
+    }
+
+    // Makes room for count students. Grows at least geometrically, so an import
+    // that reserves batch after batch rehashes the indexes O(log n) times
+    // rather than once per batch.
+    void reserveStudents(size_t count)
+    {
+        if (count <= studentIndex.bucket_count() * studentIndex.max_load_factor())
+            return;
+        count = max(count, students.size() * 2);
+        students.reserve(count);
+        studentIndex.reserve(count);
+        emailIndex.reserve(count);
+        phoneIndex.reserve(count);
+    }
+
+    // Registration numbers of the students with this email (normally at most one)
+    vector<uint32_t> studentsWithEmail(string_view email) const
+    {
+        vector<uint32_t> regs;
+        auto range = emailIndex.equal_range(emailKey(email));
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            auto student = studentIndex.find(it->second);
+            if (student != studentIndex.end() && compareNoCase(strings.view(students.emailRef(student->second)), email) == 0)
+                regs.push_back(it->second);
+        }
+        return regs;
+    }
+
+    // Why a new student cannot be registered with this phone and email, or
+    // nullptr if both are free. O(1): one hash probe each.
+    const char *contactConflict(uint64_t phone, string_view email) const
+    {
+        if (phoneIndex.count(phone))
+            return "phone number already registered";
+        if (!studentsWithEmail(email).empty())
+            return "email already registered";
+        return nullptr;
+    }
+
+    // Also returns false if the registration or phone number does not pack
+    bool insertStudent(const Student &student)
+    {
+        uint32_t reg = packRegNumber(student.regNumber);
+        uint64_t phone = packPhone(student.phone);
+        if (reg == INVALID_REG_KEY || phone == INVALID_PHONE_KEY)
+            return false;
+        return insertStudent(student.firstName, student.lastName, reg, phone, student.email);
+    }
+
+    // Re-packs the string pool once rows removed since the last compaction
+    // may have left as much dead text as live text. Caller holds catalogLock
+    // exclusively. Paged text is only re-packed by the next start.
+    void compactStrings()
+    {
+        if (strings.pagedFile() || strings.releasedBytes() * 2 < strings.bytes())
+            return;
+        vector<char> old = strings.takeArena();
+        strings.reserve(old.size() - min(old.size(), strings.releasedBytes()));
+        books.repool(strings, old);
+        students.repool(strings, old);
+    }
+
+    // Total orders on positions in books/students; ties are broken by ISBN or
+    // registration number so a cursor always has exactly one place
+    function<bool(size_t, size_t)> bookLess(BookOrder order) const
+    {
+        auto byTitle = [this](size_t a, size_t b)
+        {
+            if (int c = compareNoCase(strings.view(books.nameRef(a)), strings.view(books.nameRef(b))))
+                return c < 0;
+            return books.isbn(a) < books.isbn(b);
+        };
+        if (order == BookOrder::Author)
+            return [this, byTitle](size_t a, size_t b)
+            {
+                if (int c = compareNoCase(strings.view(books.authorRef(a)), strings.view(books.authorRef(b))))
+                    return c < 0;
+                return byTitle(a, b);
+            };
+        if (order == BookOrder::Copies)
+            return [this, byTitle](size_t a, size_t b)
+            {
+                if (books.copies(a) != books.copies(b))
+                    return books.copies(a) > books.copies(b);
+                return byTitle(a, b);
+            };
+        return byTitle;
+    }
+
+    function<bool(size_t, size_t)> studentLess(StudentOrder order) const
+    {
+        if (order == StudentOrder::Name)
+            return [this](size_t a, size_t b)
+            {
+                if (int c = compareNoCase(strings.view(students.lastNameRef(a)), strings.view(students.lastNameRef(b))))
+                    return c < 0;
+                if (int c = compareNoCase(strings.view(students.firstNameRef(a)), strings.view(students.firstNameRef(b))))
+                    return c < 0;
+                return students.reg(a) < students.reg(b);
+            };
+        return [this](size_t a, size_t b)
+        { return students.reg(a) < students.reg(b); };
+    }
+
+    // Caller holds catalogLock exclusively. Title and author orders only change
+    // when books are added or removed; the copies order also when a count changes.
+    const vector<size_t> &bookView(BookOrder order)
+    {
+        if (order != BookOrder::Copies)
+            return bookViews[(int)order].get(books.size(), bookVersion, bookLess(order));
+
+        // Copies change on every issue and return, so that order is derived from
+        // the cached title order by bucketing on the count alone
+        const vector<size_t> &byTitle = bookView(BookOrder::Title);
+        return bookViews[(int)order].deriveDescending(byTitle, bookVersion + copiesVersion.load(memory_order_relaxed),
+                                                      [this](size_t pos)
+                                                      { return books.copies(pos); });
+    }
+
+    const vector<size_t> &studentView(StudentOrder order)
+    {
+        return studentViews[(int)order].get(students.size(), studentVersion, studentLess(order));
+    }
+
+public:
+    // All data files live in directory. With useBinarySnapshot, periodic
+    // checkpoints write only lms.snap and the text files are exported on
+    // shutdown. A library that is not live keeps no history, sweeps no
+    // fines and loads no accounts, so nothing can log in to it.
+    // With a pageCacheBytes budget the text of books and students is kept in
+    // records.pages, cached in at most that much memory (see PageCache.h).
+    LMS(const string &directory = ".", bool useBinarySnapshot = false, bool isLive = true, size_t pageCacheBytes = 0)
+        : dataDir(directory), loginLog(dataPath("login_log.txt")), circulationLog(dataPath("circulation_log.txt"), AuditLog::TimeFormat::Iso8601, CIRCULATION_LOG_BYTES, CIRCULATION_LOG_FILES),
+          binarySnapshot(useBinarySnapshot), live(isLive)
+    {
+        if (live)
+            history.open(dataPath("history"));
+        if (pageCacheBytes && !strings.usePagedFile(dataPath("records.pages"), pageCacheBytes))
+            cout << "Error: Could not create " << dataPath("records.pages") << "; keeping record text in memory\n";
+        branches.loadNames(dataPath("branches.txt"), 0);
+        searchIndex.beginBulkLoad();
+        nameIndex.beginBulkLoad();
+        if (!loadSnapshot())
+        {
+            loadBooks();
+            loadStudents();
+            loadLoans();
+        }
+        loadStock();
+        loadHolds();
+        loadFines();
+        if (live)
+        {
+            loadAccounts();
+            loadThrottle();
+        }
+        replayJournal();
+        holds.resetStats();
+        fines.resetStats();
+        searchIndex.endBulkLoad();
+        nameIndex.endBulkLoad();
+        if (live && fineSweepDue())
+            sweepFines();
+    }
+
+    ~LMS()
+    {
+        checkpoint(true);
+        if (historyReaper.joinable())
+            historyReaper.join();
+    }
+
+    // Path of a file in the data directory
+    string dataPath(const string &name) const
+    {
+        return dataDir + "/" + name;
+    }
+
+    // Writes the full snapshot files and empties the journal
+    void checkpoint(bool shutdown = false)
+    {
+        unique_lock<shared_mutex> guard(catalogLock);
+        checkpointLocked(shutdown);
+    }
+
+    // Checkpoints and starts a history snapshot now rather than when one is
+    // due, e.g. before a large edit. Unavailable while the previous one is
+    // still being written.
+    Status snapshotHistory()
+    {
+        if (!live)
+            return Status::Invalid;
+        unique_lock<shared_mutex> guard(catalogLock);
+        if (historyWriting)
+            return Status::Unavailable;
+        checkpointLocked(false, true);
+        return Status::Ok;
+    }
+
+    // Times of the history snapshots kept, oldest first
+    vector<time_t> historySnapshots() const
+    {
+        return live ? history.snapshotTimes() : vector<time_t>();
+    }
+
+    // Rebuilds the library in dataDir as it was at time when into targetDir:
+    // the newest history snapshot taken at or before when is loaded and the
+    // journal records logged after it, up to when, are replayed on top, and
+    // the result is saved there as ordinary data files. Holds and fines are
+    // not part of the history, so the copy starts without any.
+    // NotFound if no snapshot is that old; Duplicate if targetDir already
+    // holds data files, which are never overwritten.
+    static Status restoreAsOf(const string &dataDir, time_t when, const string &targetDir,
+                              RestoreReport *report = nullptr)
+    {
+        auto start = chrono::steady_clock::now();
+        HistoryArchive::Plan plan = HistoryArchive::plan(dataDir + "/history", when);
+        if (plan.snapshotAt == 0)
+            return Status::NotFound;
+        for (const char *name : {"books.txt", "students.txt", "issued_books.txt", "lms.snap", "journal.log"})
+            if (fileModifiedTime(targetDir + "/" + name))
+                return Status::Duplicate;
+
+        error_code error;
+        filesystem::create_directories(targetDir, error);
+        if (!filesystem::copy_file(HistoryArchive::snapshotPath(dataDir + "/history", plan.snapshotAt),
+                                   targetDir + "/lms.snap", error))
+            return Status::Invalid;
+
+        // Branches are never removed, so today's list covers every branch the records name
+        filesystem::copy_file(dataDir + "/branches.txt", targetDir + "/branches.txt", error);
+        ifstream stock(HistoryArchive::stockPath(dataDir + "/history", plan.snapshotAt));
+        map<string, string> branchStock;
+        string branch, isbn, copies;
+        while (stock >> branch >> isbn >> copies)
+            branchStock[branch] += isbn + " " + copies + "\n";
+        for (const auto &entry : branchStock)
+        {
+            DurableWriter file(targetDir + "/stock_" + entry.first + ".txt");
+            file.append(entry.second);
+            file.commit();
+        }
+
+        // Records are in time order across the segments and journal.log, which
+        // holds the ones not yet moved into the last segment
+        RestoreReport result;
+        result.snapshotAt = plan.snapshotAt;
+        vector<string> files = plan.eventFiles;
+        files.push_back(dataDir + "/journal.log");
+        DurableWriter journalOut(targetDir + "/journal.log");
+        bool past = false;
+        for (size_t i = 0; i < files.size() && !past; i++)
+        {
+            ifstream in(files[i], ios::binary);
+            string line;
+            while (!past && getline(in, line))
+            {
+                size_t tab = line.find('\t');
+                if (in.eof() || tab == string::npos || tab + 1 >= line.size())
+                    continue; // A torn last line
+                long long at;
+                auto parsed = from_chars(line.data(), line.data() + tab, at);
+                if (parsed.ec != errc() || parsed.ptr != line.data() + tab)
+                    continue; // Not a record, as replayJournal also skips
+                if (at > when)
+                    past = true;
+                else if (line[tab + 1] != 'H' && line[tab + 1] != 'F' && line[tab + 1] != 'W')
+                {
+                    journalOut.append(line).append('\n');
+                    result.events++;
+                }
+            }
+        }
+        if (!journalOut.commit())
+            return Status::Invalid;
+
+        {
+            LMS restored(targetDir, false, false);
+            result.books = restored.bookCount();
+            result.students = restored.studentCount();
+            result.loans = restored.loanCount();
+        }
+        // The text files are the copy now; a stale lms.snap next to them would only confuse
+        remove((targetDir + "/lms.snap").c_str());
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (report)
+            *report = result;
+        return Status::Ok;
+    }
+
+    // The same for this library while it runs, into <data dir>/restores/<name>.
+    // The name is a single path component, so a client of the server can only
+    // write under the data directory; Invalid otherwise. Checkpoints wait
+    // meanwhile, so no records move from journal.log into the history half way
+    // through.
+    Status restoreAsOf(time_t when, const string &name, RestoreReport *report = nullptr)
+    {
+        OperationTimer timer(metrics, Op::Restore);
+        if (!live || name.empty() || name == "." || name == ".." || name.find_first_of("/\\") != string::npos)
+            return Status::Invalid;
+        shared_lock<shared_mutex> guard(catalogLock);
+        Status status = restoreAsOf(dataDir, when, dataPath("restores/" + name), report);
+        if (status == Status::Ok)
+            timer.succeeded();
+        return status;
+    }
+
+    // Loads lms.snap if it exists and is at least as new as every text file
+    bool loadSnapshot()
+    {
+        time_t snapTime = fileModifiedTime(dataPath("lms.snap"));
+        if (snapTime == 0 || snapTime < fileModifiedTime(dataPath("books.txt")) ||
+            snapTime < fileModifiedTime(dataPath("students.txt")) || snapTime < fileModifiedTime(dataPath("issued_books.txt")))
+            return false;
+
+        SnapshotFile snap;
+        if (!snap.open(dataPath("lms.snap")))
+            return false;
+
+        strings.reserve(snap.poolSize());
+        books.reserve(snap.bookCount());
+        branches.reserve(snap.bookCount());
+        bookIndex.reserve(snap.bookCount());
+        const SnapshotBook *bookRows = snap.books();
+        for (size_t i = 0; i < snap.bookCount(); i++)
+        {
+            const SnapshotBook &row = bookRows[i];
+            insertBook(snap.view(row.name), snap.view(row.author), unpackKey(row.isbn, 13), row.copies);
+        }
+
+        reserveStudents(snap.studentCount());
+        const SnapshotStudent *studentRows = snap.students();
+        for (size_t i = 0; i < snap.studentCount(); i++)
+        {
+            const SnapshotStudent &row = studentRows[i];
+            uint64_t phone = packPhone(snap.text(row.phone));
+            if (phone != INVALID_PHONE_KEY)
+                insertStudent(snap.view(row.firstName), snap.view(row.lastName), row.reg, phone, snap.view(row.email));
+        }
+
+        const SnapshotLoan *loanRows = snap.loans();
+        for (size_t i = 0; i < snap.loanCount(); i++)
+        {
+            const SnapshotLoan &row = loanRows[i];
+            loans.add(row.reg, row.isbn, row.issuedAt,
+                      row.issuedAt + (row.loanSeconds ? (time_t)row.loanSeconds : LOAN_DAYS * 86400));
+        }
+        return true;
+    }
+
+    void saveSnapshot()
+    {
+        auto start = Metrics::Clock::now();
+        if (!writeSnapshot(dataPath("lms.snap")))
+            cout << "Error: Could not write lms.snap\n";
+        metrics.recordSave(SaveFile::Snapshot, start, fileSize(dataPath("lms.snap")));
+    }
+
+    bool writeSnapshot(const string &path) const
+    {
+        SnapshotWriter writer;
+        writer.reserve(books.size(), students.size(), loans.size());
+        for (size_t i = 0; i < books.size(); i++)
+            writer.addBook(books.isbn(i), books.copies(i), strings.view(books.nameRef(i)), strings.view(books.authorRef(i)));
+        for (size_t i = 0; i < students.size(); i++)
+            writer.addStudent(students.reg(i), strings.view(students.firstNameRef(i)), strings.view(students.lastNameRef(i)),
+                              unpackKey(students.phone(i), 10), strings.view(students.emailRef(i)));
+        loans.forEach([&](uint32_t reg, const LoanTable::Loan &loan)
+                      { writer.addLoan(reg, loan.isbn, loan.issuedAt, loan.dueAt); });
+        return writer.save(path);
+    }
+
+    void loadBooks()
+{
+    ifstream file(dataPath("books.txt"));
+    if (!file)
+    {
+        //cout << "Error: Could not open books.txt\n";
+        return;
+    }
+
+    string line, bName, auth, id;
+    int num;
+
+    // Each line is "<book name>,<author>,<isbn> <copies>". Book names may contain
+    // commas, so the fields are split from the right.
+    while (getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        size_t space = line.rfind(' ');
+        size_t isbnComma = space == string::npos || space == 0 ? string::npos : line.rfind(',', space - 1);
+        size_t authorComma = isbnComma == string::npos || isbnComma == 0 ? string::npos : line.rfind(',', isbnComma - 1);
+        if (authorComma == string::npos)
+            continue;
+
+        bName = line.substr(0, authorComma);
+        auth = line.substr(authorComma + 1, isbnComma - authorComma - 1);
+        id = line.substr(isbnComma + 1, space - isbnComma - 1);
+        try
+        {
+            num = stoi(line.substr(space + 1));
+        }
+        catch (const exception &)
+        {
+            continue;
+        }
+
+        // Merge duplicate rows so the index holds exactly one record per ISBN
+        if (int *copies = findCopies(id))
+            *copies += num;
+        else
+            insertBook(bName, auth, id, num);
+        //cout << "Loaded: " << bName << " | " << auth << " | " << id << " | " << num << endl; // Debug Output
+    }
+
+    file.close();
+}
+
+    void loadStudents()
+    {
+        ifstream file(dataPath("students.txt"));
+        if (!file)
+            return;
+        string fName, lName, regNum, phone, email;
+        while (file >> fName >> lName >> regNum >> phone >> email)
+        {
+            insertStudent(Student(fName, lName, regNum, phone, email));
+        }
+        file.close();
+    }
+
+    // Rebuilds the loan table with one streaming pass over issued_books.txt.
+    // Lines are "<reg> <isbn> <issued epoch>:<due epoch> <book name>,<author>".
+    // Older lines without the due date get the standard loan period, and the
+    // original "<reg> <book name> <author> <isbn> <ctime>" lines are still understood.
+    void loadLoans()
+    {
+        ifstream file(dataPath("issued_books.txt"));
+        if (!file)
+            return;
+
+        string line, token;
+        vector<string> tokens;
+        while (getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            tokens.clear();
+            istringstream ss(line);
+            while (ss >> token)
+                tokens.push_back(token);
+            if (tokens.size() < 3)
+                continue;
+
+            uint32_t reg = packRegNumber(tokens[0]);
+            uint64_t isbn = packIsbn(tokens[1]);
+            time_t issuedAt = 0, dueAt = 0;
+            size_t colon = tokens[2].find(':');
+            string issued = tokens[2].substr(0, colon), due = colon == string::npos ? "" : tokens[2].substr(colon + 1);
+            if (isbn != INVALID_ISBN_KEY && !issued.empty() && all_of(issued.begin(), issued.end(), ::isdigit) &&
+                all_of(due.begin(), due.end(), ::isdigit))
+            {
+                issuedAt = stoll(issued);
+                if (!due.empty())
+                    dueAt = stoll(due);
+            }
+            else if (tokens.size() >= 7)
+            {
+                // Legacy line: the ISBN sits just before the 5-token ctime() date
+                isbn = packIsbn(tokens[tokens.size() - 6]);
+                tm when = {};
+                istringstream date(line.substr(line.find(tokens[tokens.size() - 5], line.size() - 30)));
+                date >> get_time(&when, "%a %b %d %H:%M:%S %Y");
+                when.tm_isdst = -1;
+                if (!date.fail())
+                    issuedAt = mktime(&when);
+            }
+
+            if (reg != INVALID_REG_KEY && isbn != INVALID_ISBN_KEY)
+                loans.add(reg, isbn, issuedAt, dueAt ? dueAt : issuedAt + LOAN_DAYS * 86400);
+        }
+    }
+
+    void saveLoans()
+    {
+        auto start = Metrics::Clock::now();
+        DurableWriter file(dataPath("issued_books.txt"));
+        loans.forEach([&](uint32_t reg, const LoanTable::Loan &loan)
+                      {
+            auto it = bookIndex.find(loan.isbn);
+            file.appendNumber(reg, 8).append(' ').appendNumber(loan.isbn, 13).append(' ').appendNumber(loan.issuedAt);
+            file.append(':').appendNumber(loan.dueAt);
+            if (it != bookIndex.end())
+                file.append(' ').append(strings.view(books.nameRef(it->second))).append(',').append(strings.view(books.authorRef(it->second)));
+            file.append('\n'); });
+        if (!file.commit())
+            cout << "Error: Could not write issued_books.txt\n";
+        metrics.recordSave(SaveFile::Loans, start, file.size());
+    }
+
+    // First line is the time of the last fine sweep, then "<reg> <balance>" per
+    // student who owes something
+    void loadFines()
+    {
+        ifstream file(dataPath("fines.txt"));
+        long long sweptAt;
+        if (!file || !(file >> sweptAt))
+            return;
+        fines.setLastSweepTime(sweptAt);
+        string regNum;
+        long long amount;
+        while (file >> regNum >> amount)
+        {
+            uint32_t reg = packRegNumber(regNum);
+            if (reg != INVALID_REG_KEY)
+                fines.set(reg, amount);
+        }
+        savedFinesVersion = fines.version();
+    }
+
+    void saveFines()
+    {
+        auto start = Metrics::Clock::now();
+        DurableWriter file(dataPath("fines.txt"));
+        file.appendNumber(fines.lastSweepTime()).append('\n');
+        fines.forEach([&](uint32_t reg, long long amount)
+                      { file.appendNumber(reg, 8).append(' ').appendNumber(amount).append('\n'); });
+        if (file.commit())
+            savedFinesVersion = fines.version();
+        else
+            cout << "Error: Could not write fines.txt\n";
+        metrics.recordSave(SaveFile::Fines, start, file.size());
+    }
+
+    // Lines are "<reg> <isbn> <hold placed epoch> <copy set aside epoch, or 0>",
+    // followed by the branch the copy was taken from when it is not main; each
+    // title's ready holds first and then its queue in order
+    void loadHolds()
+    {
+        ifstream file(dataPath("holds.txt"));
+        if (!file)
+            return;
+        string line, regNum, id, branch;
+        long long placedAt, readyAt;
+        while (getline(file, line))
+        {
+            istringstream fields(line);
+            if (!(fields >> regNum >> id >> placedAt >> readyAt))
+                continue;
+            int b = fields >> branch ? branches.find(branch) : BranchStock::MAIN;
+            uint32_t reg = packRegNumber(regNum);
+            uint64_t isbn = packIsbn(id);
+            if (reg != INVALID_REG_KEY && bookIndex.count(isbn))
+                holds.restore(reg, isbn, placedAt, readyAt, max(b, (int)BranchStock::MAIN));
+        }
+        savedHoldsVersion = holds.version();
+    }
+
+    void saveHolds()
+    {
+        auto start = Metrics::Clock::now();
+        DurableWriter file(dataPath("holds.txt"));
+        auto write = [&](uint64_t isbn, const HoldTable::Hold &hold)
+        {
+            file.appendNumber(hold.reg, 8).append(' ').appendNumber(isbn, 13).append(' ').appendNumber(hold.placedAt);
+            file.append(' ').appendNumber(hold.readyAt);
+            if (hold.readyAt && hold.branch != BranchStock::MAIN)
+                file.append(' ').append(branches.name(hold.branch));
+            file.append('\n');
+        };
+        holds.forEach([&](uint64_t isbn, const HoldTable::Queue &queue)
+                      {
+            for (const auto &hold : queue.ready)
+                write(isbn, hold);
+            for (const auto &hold : queue.waiting)
+                write(isbn, hold); });
+        if (file.commit())
+            savedHoldsVersion = holds.version();
+        else
+            cout << "Error: Could not write holds.txt\n";
+        metrics.recordSave(SaveFile::Holds, start, file.size());
+    }
+
+    // Lines are "<user> <role> <iterations> <salt hex> <PBKDF2 hash hex>". Without
+    // the file, the old shared logins become accounts: librarian (lib123) and
+    // counter (counter123).
+    void loadAccounts()
+    {
+        ifstream file(dataPath("accounts.txt"));
+        if (!file)
+        {
+            accounts.set("librarian", AccountTable::make(AccountRole::Librarian, "lib123"));
+            accounts.set("counter", AccountTable::make(AccountRole::Counter, "counter123"));
+            saveAccounts();
+            return;
+        }
+        string user, role, salt, hash;
+        uint32_t iterations;
+        while (file >> user >> role >> iterations >> salt >> hash)
+        {
+            AccountTable::Account account;
+            account.iterations = iterations;
+            if (AccountTable::validName(user) && parseRole(role, account.role) && iterations > 0 &&
+                fromHex(salt, account.salt, AccountTable::SALT_BYTES) &&
+                fromHex(hash, account.hash.data(), account.hash.size()))
+                accounts.set(user, account);
+        }
+    }
+
+    // Written whenever an account changes; the caller holds accountLock
+    void saveAccounts()
+    {
+        auto start = Metrics::Clock::now();
+        DurableWriter file(dataPath("accounts.txt"));
+        accounts.forEach([&](const string &user, const AccountTable::Account &account)
+                         {
+            file.append(user).append(' ').append(roleName(account.role)).append(' ').appendNumber(account.iterations);
+            file.append(' ').append(toHex(account.salt, AccountTable::SALT_BYTES)).append(' ');
+            file.append(toHex(account.hash.data(), account.hash.size())).append('\n'); });
+        if (!file.commit())
+            cout << "Error: Could not write accounts.txt\n";
+        metrics.recordSave(SaveFile::Accounts, start, file.size());
+    }
+
+    // Lines are "<bucket key hex> <epoch it is full again>" for each user name
+    // or terminal with failed logins that have not been forgiven yet
+    void loadThrottle()
+    {
+        ifstream file(dataPath("throttle.txt"));
+        string key;
+        long long fullAt;
+        time_t now = time(0);
+        while (file >> key >> fullAt)
+        {
+            uint8_t bytes[8];
+            if (fullAt <= now || !fromHex(key, bytes, sizeof(bytes)))
+                continue;
+            uint64_t packed = 0;
+            for (uint8_t byte : bytes)
+                packed = packed << 8 | byte;
+            throttle.set(packed, fullAt);
+        }
+        savedThrottleVersion = throttle.version();
+    }
+
+    // Only when a login has failed or been forgiven since the last save
+    void saveThrottle()
+    {
+        vector<pair<uint64_t, long long>> buckets;
+        uint64_t version;
+        {
+            lock_guard<mutex> guard(accountLock);
+            version = throttle.version();
+            if (version == savedThrottleVersion)
+                return;
+            throttle.prune(time(0));
+            buckets.reserve(throttle.size());
+            throttle.forEach([&](uint64_t key, long long fullAt)
+                             { buckets.push_back({key, fullAt}); });
+        }
+        auto start = Metrics::Clock::now();
+        DurableWriter file(dataPath("throttle.txt"));
+        for (const auto &bucket : buckets)
+        {
+            uint8_t bytes[8];
+            for (int i = 0; i < 8; i++)
+                bytes[i] = (uint8_t)(bucket.first >> (56 - 8 * i));
+            file.append(toHex(bytes, sizeof(bytes))).append(' ').appendNumber(bucket.second).append('\n');
+        }
+        if (file.commit())
+            savedThrottleVersion = version;
+        else
+            cout << "Error: Could not write throttle.txt\n";
+        metrics.recordSave(SaveFile::Throttle, start, file.size());
+    }
+
+    // Reads every branch's stock_<name>.txt, each on its own thread (they only
+    // look titles up in bookIndex), then gives any title whose branch counts
+    // add up to more than its total the difference, so main never goes negative
+    void loadStock()
+    {
+        if (branches.count() == 1)
+            return;
+        branches.loadAll([this](const string &branch)
+                         { return stockPath(branch); },
+                         [this](const string &id)
+                         {
+                             auto it = bookIndex.find(packIsbn(id));
+                             return it == bookIndex.end() ? -1LL : (long long)it->second;
+                         });
+        for (size_t pos = 0; pos < books.size(); pos++)
+            books.copies(pos) = max(books.copies(pos), branches.others(pos));
+    }
+
+    // Rewrites the stock files of the branches that changed since the last
+    // checkpoint, in parallel. Caller holds catalogLock exclusively.
+    void saveStock()
+    {
+        branches.saveChanged([this](const string &branch)
+                             { return stockPath(branch); },
+                             [this](size_t pos)
+                             { return books.isbn(pos); },
+                             [this](const string &branch, bool ok, uint64_t bytes, Metrics::Clock::time_point start)
+                             {
+                                 if (!ok)
+                                     cout << "Error: Could not write " + stockPath(branch) + "\n";
+                                 metrics.recordSave(SaveFile::Stock, start, bytes);
+                             });
+    }
+
+    void saveBooks()
+{
+    auto start = Metrics::Clock::now();
+    DurableWriter file(dataPath("books.txt"));
+    for (size_t i = 0; i < books.size(); i++)
+    {
+        file.append(strings.view(books.nameRef(i))).append(',').append(strings.view(books.authorRef(i))).append(',');
+        file.appendNumber(books.isbn(i), 13).append(' ').appendNumber(books.copies(i)).append('\n');
+    }
+
+    // Until the commit the old books.txt stays in place untouched
+    if (!file.commit())
+        cout << "Error: Could not write books.txt\n";
+    metrics.recordSave(SaveFile::Books, start, file.size());
+}
+
+
+    void saveStudents()
+    {
+        auto start = Metrics::Clock::now();
+        DurableWriter file(dataPath("students.txt"));
+        for (size_t i = 0; i < students.size(); i++)
+        {
+            file.append(strings.view(students.firstNameRef(i))).append(' ').append(strings.view(students.lastNameRef(i)));
+            file.append(' ').appendNumber(students.reg(i), 8).append(' ').appendNumber(students.phone(i), 10).append(' ');
+            file.append(strings.view(students.emailRef(i))).append('\n');
+        }
+        if (!file.commit())
+            cout << "Error: Could not write students.txt\n";
+        metrics.recordSave(SaveFile::Students, start, file.size());
+    }
+
+    struct ImportReport
+    {
+        size_t rows = 0;
+        size_t added = 0;
+        size_t merged = 0;
+        size_t rejected = 0;
+        double seconds = 0;
+    };
+
+    // Rows are validated and applied in batches of this size
+    static const size_t IMPORT_BATCH = 8192;
+
+    static void printReport(const string &what, const string &path, const ImportReport &report)
+    {
+        cout << what << " " << path << ": " << report.rows << " rows";
+        if (what == "Imported")
+            cout << " (" << report.added << " added, " << report.merged << " merged, " << report.rejected << " rejected)";
+        cout << " in " << fixed << setprecision(3) << report.seconds << " s, " << setprecision(0)
+             << report.rows / max(report.seconds, 1e-9) << " rows/sec\n"
+             << defaultfloat;
+    }
+
+    static void reportRejected(ImportReport &report, size_t line, const string &reason)
+    {
+        if (report.rejected++ < 10)
+            cerr << "Line " << line << ": " << reason << "\n";
+    }
+
+    // Streams title,author,isbn,copies rows into the catalog. Copies of an ISBN
+    // that already exists (or repeats within the file) are added to it, like addBook.
+    // Nothing is journaled per row; the catalog is saved once at the end.
+    ImportReport importBooks(const string &path)
+    {
+        ImportReport report;
+        unique_lock<shared_mutex> guard(catalogLock);
+        auto start = chrono::steady_clock::now();
+        CsvReader reader(path);
+        if (!reader.isOpen())
+        {
+            cout << "Error: Could not open " << path << "\n";
+            return report;
+        }
+
+        vector<string> fields;
+        vector<Record> batch;
+        batch.reserve(IMPORT_BATCH);
+        searchIndex.beginBulkLoad();
+        bool more = true;
+        while (more)
+        {
+            batch.clear();
+            while (batch.size() < IMPORT_BATCH && (more = reader.readRow(fields)))
+            {
+                if (reader.lineNumber() == 1 && !fields.empty() && fields[0] == "title")
+                    continue;
+
+                report.rows++;
+                int copies = fields.size() == 4 && isAllDigits(fields[3], fields[3].size()) && fields[3].size() <= 9
+                                 ? stoi(fields[3])
+                                 : 0;
+                if (fields.size() != 4)
+                    reportRejected(report, reader.lineNumber(), "expected 4 fields");
+                else if (!isValidBookName(fields[0]) || !isValidAuthorName(fields[1]))
+                    reportRejected(report, reader.lineNumber(), "invalid book or author name");
+                else if (!isValidIsbn(fields[2]) || (!isValidIsbn13Checksum(fields[2]) && !findCopies(fields[2])))
+                    reportRejected(report, reader.lineNumber(), "invalid ISBN");
+                else if (copies <= 0)
+                    reportRejected(report, reader.lineNumber(), "invalid number of copies");
+                else
+                    batch.push_back(Record(fields[0], fields[1], fields[2], copies));
+            }
+
+            // Geometric growth, as in reserveStudents
+            if (books.size() + batch.size() > bookIndex.bucket_count() * bookIndex.max_load_factor())
+                bookIndex.reserve(max(books.size() + batch.size(), books.size() * 2));
+            for (auto &row : batch)
+            {
+                if (int *copies = findCopies(row.isbn))
+                {
+                    *copies += row.copies;
+                    report.merged++;
+                }
+                else
+                {
+                    insertBook(row.bookName, row.author, row.isbn, row.copies);
+                    report.added++;
+                }
+            }
+        }
+        searchIndex.endBulkLoad();
+        copiesChanged();
+
+        checkpointLocked();
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    // Streams first_name,last_name,reg_number,phone,email rows into the student list.
+    // Registration numbers that already exist are rejected.
+    ImportReport importStudents(const string &path)
+    {
+        ImportReport report;
+        unique_lock<shared_mutex> guard(catalogLock);
+        auto start = chrono::steady_clock::now();
+        CsvReader reader(path);
+        if (!reader.isOpen())
+        {
+            cout << "Error: Could not open " << path << "\n";
+            return report;
+        }
+
+        vector<string> fields;
+        vector<Student> batch;
+        vector<size_t> batchLines;
+        batch.reserve(IMPORT_BATCH);
+        nameIndex.beginBulkLoad();
+        bool more = true;
+        while (more)
+        {
+            batch.clear();
+            batchLines.clear();
+            while (batch.size() < IMPORT_BATCH && (more = reader.readRow(fields)))
+            {
+                if (reader.lineNumber() == 1 && !fields.empty() && fields[0] == "first_name")
+                    continue;
+
+                report.rows++;
+                if (fields.size() != 5)
+                    reportRejected(report, reader.lineNumber(), "expected 5 fields");
+                else if (fields[0].empty() || fields[1].empty() || fields[0].find(' ') != string::npos ||
+                         fields[1].find(' ') != string::npos)
+                    reportRejected(report, reader.lineNumber(), "invalid name");
+                else if (!isValidRegNumber(fields[2]))
+                    reportRejected(report, reader.lineNumber(), "invalid registration number");
+                else if (!isValidPhone(fields[3]))
+                    reportRejected(report, reader.lineNumber(), "invalid phone number");
+                else if (!isValidEmail(fields[4]))
+                    reportRejected(report, reader.lineNumber(), "invalid email");
+                else
+                {
+                    batch.push_back(Student(fields[0], fields[1], fields[2], fields[3], fields[4]));
+                    batchLines.push_back(reader.lineNumber());
+                }
+            }
+
+            // Every check is a hash probe, and rows are checked against the
+            // earlier rows of the file too, so an import stays linear in its size
+            reserveStudents(students.size() + batch.size());
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                if (const char *conflict = contactConflict(packPhone(batch[i].phone), batch[i].email))
+                    reportRejected(report, batchLines[i], conflict);
+                else if (insertStudent(batch[i]))
+                    report.added++;
+                else
+                    reportRejected(report, batchLines[i], "duplicate registration number");
+            }
+        }
+        nameIndex.endBulkLoad();
+
+        checkpointLocked();
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    ImportReport exportBooks(const string &path)
+    {
+        ImportReport report;
+        unique_lock<shared_mutex> guard(catalogLock);
+        auto start = chrono::steady_clock::now();
+        CsvWriter writer(path);
+        if (!writer.isOpen())
+        {
+            cout << "Error: Could not open " << path << " for writing\n";
+            return report;
+        }
+
+        writer.field("title").field("author").field("isbn").field("copies").endRow();
+        for (size_t i = 0; i < books.size(); i++)
+        {
+            writer.field(strings.view(books.nameRef(i))).field(strings.view(books.authorRef(i)));
+            writer.field(unpackKey(books.isbn(i), 13)).field(books.copies(i)).endRow();
+            report.rows++;
+        }
+        if (!writer.close())
+            cout << "Error: Could not write " << path << "\n";
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    ImportReport exportStudents(const string &path)
+    {
+        ImportReport report;
+        unique_lock<shared_mutex> guard(catalogLock);
+        auto start = chrono::steady_clock::now();
+        CsvWriter writer(path);
+        if (!writer.isOpen())
+        {
+            cout << "Error: Could not open " << path << " for writing\n";
+            return report;
+        }
+
+        writer.field("first_name").field("last_name").field("reg_number").field("phone").field("email").endRow();
+        for (size_t i = 0; i < students.size(); i++)
+        {
+            writer.field(strings.view(students.firstNameRef(i))).field(strings.view(students.lastNameRef(i)));
+            writer.field(unpackKey(students.reg(i), 8)).field(unpackKey(students.phone(i), 10));
+            writer.field(strings.view(students.emailRef(i))).endRow();
+            report.rows++;
+        }
+        if (!writer.close())
+            cout << "Error: Could not write " << path << "\n";
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    // Programmatic API
+    // These perform one operation without any prompts or output and report the
+    // outcome as a Status, so the system can be driven by scripts, batch files,
+    // tests and benchmarks. The interactive functions below are wrappers around them.
+    //
+    // The API is safe to call from several threads. Issue, return, restock and
+    // update take the catalog lock shared plus one striped lock per student and
+    // per book (always in that order), so operations on different titles and
+    // students run in parallel, and so do placing and cancelling holds. Adding a
+    // student or title, deleting a title, listings, hold reports and checkpoints
+    // take the catalog lock exclusively.
+
+    Status addStudent(const string &fName, const string &lName, const string &regNum, const string &phone,
+                      const string &email)
+    {
+        OperationTimer timer(metrics, Op::AddStudent);
+        if (fName.empty() || lName.empty() || !isValidRegNumber(regNum) || !isValidPhone(phone) || !isValidEmail(email))
+            return Status::Invalid;
+        {
+            unique_lock<shared_mutex> guard(catalogLock);
+            if (contactConflict(packPhone(phone), email) || !insertStudent(Student(fName, lName, regNum, phone, email)))
+                return Status::Duplicate;
+            logChange('S', {fName, lName, regNum, phone, email});
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Adds a new title, or adds the copies to it if the ISBN is already in the
+    // inventory. The copies go on the shelf at branch (main if empty).
+    Status addBook(const string &bName, const string &auth, const string &id, int num, const string &branch = "")
+    {
+        OperationTimer timer(metrics, Op::AddBook);
+        if (num <= 0 || !isValidIsbn(id))
+            return Status::Invalid;
+
+        bool restocked = false;
+        int b;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            b = branches.find(branch);
+            if (b < 0)
+                return Status::NotFound;
+            restocked = restockBook(id, num, b);
+        }
+        if (!restocked)
+        {
+            if (!isValidBookName(bName) || !isValidAuthorName(auth) || !isValidIsbn13Checksum(id))
+                return Status::Invalid;
+
+            unique_lock<shared_mutex> guard(catalogLock);
+            if (!restockBook(id, num, b)) // Another thread may have added it meanwhile
+            {
+                insertBook(bName, auth, id, num);
+                logChange('B', {id, to_string(num), bName, auth});
+                if (b != BranchStock::MAIN)
+                {
+                    size_t pos = bookIndex[packIsbn(id)];
+                    branches.set(b, pos, num);
+                    logShelfChange('C', {id, to_string(num)}, b, pos);
+                }
+            }
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Removes num copies; the title is dropped from the inventory once none are left
+    Status deleteBook(const string &id, int num)
+    {
+        OperationTimer timer(metrics, Op::DeleteBook);
+        if (num <= 0)
+            return Status::Invalid;
+        {
+            unique_lock<shared_mutex> guard(catalogLock);
+            auto it = bookIndex.find(packIsbn(id));
+            if (it == bookIndex.end())
+                return Status::NotFound;
+
+            size_t pos = it->second;
+            if (num >= books.copies(pos))
+            {
+                removeBookAt(pos);
+                logChange('X', {id});
+            }
+            else
+            {
+                // Copies come off the main shelf first, then off the other branches in turn
+                for (int b = 0; num > 0 && b < (int)branches.count(); b++)
+                {
+                    int taken = min(num, shelfAt(b, pos));
+                    if (taken <= 0)
+                        continue;
+                    addToShelf(b, pos, -taken);
+                    logShelfChange('C', {id, to_string(books.copies(pos))}, b, pos);
+                    num -= taken;
+                }
+            }
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Sets the number of copies on the shelf at branch (main if empty)
+    Status updateBook(const string &id, int num, const string &branch = "")
+    {
+        OperationTimer timer(metrics, Op::UpdateBook);
+        if (num < 0)
+            return Status::Invalid;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            uint64_t key = packIsbn(id);
+            auto it = bookIndex.find(key);
+            int b = branches.find(branch);
+            if (it == bookIndex.end() || b < 0)
+                return Status::NotFound;
+
+            size_t pos = it->second;
+            lock_guard<mutex> bookGuard(bookLock(key));
+            addToShelf(b, pos, num - shelfAt(b, pos));
+            logShelfChange('C', {id, to_string(books.copies(pos))}, b, pos);
+            serveHolds(key, id, pos, b, nullptr);
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Issues a copy from the shelf at branch (main if empty); Unavailable if
+    // that branch has none, even when another one does (see whereAvailable)
+    Status issueBook(const string &regNum, const string &id, const string &branch = "")
+    {
+        OperationTimer timer(metrics, Op::Issue);
+        if (!isValidRegNumber(regNum))
+            return Status::Invalid;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            uint32_t reg = packRegNumber(regNum);
+            uint64_t key = packIsbn(id);
+            auto it = bookIndex.find(key);
+            int b = branches.find(branch);
+            if (it == bookIndex.end() || b < 0)
+                return Status::NotFound;
+
+            size_t pos = it->second;
+            lock_guard<mutex> studentGuard(studentLock(reg));
+            lock_guard<mutex> bookGuard(bookLock(key));
+
+            // A copy set aside for this student's hold is already off the shelf
+            bool setAside = !holds.noneReady() && holds.state(reg, key) == HoldTable::State::Ready;
+            if (!setAside && shelfAt(b, pos) <= 0)
+                return Status::Unavailable;
+
+            // Check if the student already has 3 books issued
+            if (loans.count(reg) >= MAX_BOOKS_PER_STUDENT)
+                return Status::LimitReached;
+
+            // Check if the student has already issued this book
+            if (loans.has(reg, key))
+                return Status::AlreadyIssued;
+
+            if (setAside)
+            {
+                holds.collect(reg, key);
+                b = BranchStock::MAIN; // No shelf count changes
+            }
+            else
+                addToShelf(b, pos, -1);
+            time_t now = time(0);
+            loans.add(reg, key, now, now + LOAN_DAYS * 86400);
+            logShelfChange('I', {regNum, id, to_string(books.copies(pos))}, b, pos);
+            logCirculation("ISSUE", regNum, id);
+            analytics.recordIssue(reg, key, now);
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // A late return is fined for the days not yet charged by a sweep, and the
+    // copy goes to the head of the title's hold queue if anyone is waiting,
+    // otherwise on the shelf at branch (main if empty). info (if given)
+    // receives the fine and any pickup notice.
+    Status returnBook(const string &regNum, const string &id, ReturnInfo *info = nullptr, const string &branch = "")
+    {
+        OperationTimer timer(metrics, Op::Return);
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            uint32_t reg = packRegNumber(regNum);
+            uint64_t key = packIsbn(id);
+            auto it = bookIndex.find(key);
+            int b = branches.find(branch);
+            if (it == bookIndex.end() || b < 0)
+                return Status::NotFound;
+
+            size_t pos = it->second;
+            lock_guard<mutex> studentGuard(studentLock(reg));
+            lock_guard<mutex> bookGuard(bookLock(key));
+
+            // Close the loan; the copy only goes back on the shelf if it was actually issued
+            const LoanTable::Loan *loan = loans.find(reg, key);
+            if (!loan)
+                return Status::NotIssued;
+            time_t now = time(0), dueAt = loan->dueAt;
+            loans.remove(reg, key);
+
+            long long unpaidDays = fines.unchargedDays(dueAt, now);
+            if (unpaidDays > 0)
+                logChange('F', {regNum, to_string(fines.charge(reg, unpaidDays * FINE_PER_DAY))});
+            if (info)
+            {
+                info->daysLate = FineLedger::daysLate(dueAt, now);
+                info->fine = info->daysLate * FINE_PER_DAY;
+                info->balance = fines.balance(reg);
+            }
+
+            addToShelf(b, pos, 1);
+            logShelfChange('R', {regNum, id, to_string(books.copies(pos))}, b, pos);
+            logCirculation("RETURN", regNum, id);
+            analytics.recordReturn(key, now);
+            serveHolds(key, id, pos, b, info ? &info->notices : nullptr);
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Queues the student for a title with no copies on the shelf. position (if
+    // given) receives the student's 1-based place in the queue.
+    Status placeHold(const string &regNum, const string &id, size_t *position = nullptr)
+    {
+        OperationTimer timer(metrics, Op::PlaceHold);
+        if (!isValidRegNumber(regNum))
+            return Status::Invalid;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            int *copies = findCopies(id);
+            if (!copies)
+                return Status::NotFound;
+
+            uint32_t reg = packRegNumber(regNum);
+            uint64_t key = packIsbn(id);
+            lock_guard<mutex> studentGuard(studentLock(reg));
+            lock_guard<mutex> bookGuard(bookLock(key));
+            if (*copies > 0)
+                return Status::Available;
+            if (loans.has(reg, key))
+                return Status::AlreadyIssued;
+
+            size_t place = holds.place(reg, key, time(0));
+            if (place == 0)
+                return Status::Duplicate;
+            if (position)
+                *position = place;
+            logChange('H', {regNum, id});
+            logCirculation("HOLD", regNum, id);
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Withdraws a hold; a copy already set aside for it goes to the next student
+    // in the queue, or back on the shelf
+    Status cancelHold(const string &regNum, const string &id)
+    {
+        OperationTimer timer(metrics, Op::CancelHold);
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            int *copies = findCopies(id);
+            if (!copies)
+                return Status::NotFound;
+
+            uint32_t reg = packRegNumber(regNum);
+            uint64_t key = packIsbn(id);
+            lock_guard<mutex> bookGuard(bookLock(key));
+            int from = BranchStock::MAIN;
+            HoldTable::State removed = holds.cancel(reg, key, false, &from);
+            if (removed == HoldTable::State::None)
+                return Status::NotFound;
+            // A copy that was set aside goes back on the shelf it was taken from
+            size_t pos = bookIndex.find(key)->second;
+            if (removed == HoldTable::State::Ready)
+                addToShelf(from, pos, 1);
+            logShelfChange('U', {regNum, id, to_string(*copies)}, from, pos);
+            logCirculation("HOLD_CANCEL", regNum, id);
+            serveHolds(key, id, pos, from, nullptr);
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Moves num copies of a title from one branch's shelf to another's. Both
+    // counts change under the book's stripe lock and go to the journal in one
+    // record, so no reader and no replay ever sees the copies in both places
+    // or in neither. The total does not change.
+    Status transferCopies(const string &id, const string &from, const string &to, int num)
+    {
+        OperationTimer timer(metrics, Op::Transfer);
+        if (num <= 0)
+            return Status::Invalid;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            uint64_t key = packIsbn(id);
+            auto it = bookIndex.find(key);
+            int source = branches.find(from), target = branches.find(to);
+            if (it == bookIndex.end() || source < 0 || target < 0)
+                return Status::NotFound;
+            if (source == target)
+                return Status::Invalid;
+
+            size_t pos = it->second;
+            lock_guard<mutex> bookGuard(bookLock(key));
+            if (shelfAt(source, pos) < num)
+                return Status::Unavailable;
+            addToShelf(source, pos, -num);
+            addToShelf(target, pos, num);
+            logChange('T', {id, branches.name(source), to_string(shelfAt(source, pos)), branches.name(target),
+                            to_string(shelfAt(target, pos))});
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Copies of a title on the shelf at each branch, main first. Every
+    // branch's count of a title sits under that title's one stripe lock, so
+    // this is a single consistent read rather than a query per branch, and a
+    // transfer in progress is never half seen.
+    Status whereAvailable(const string &id, vector<BranchCopies> &where) const
+    {
+        where.clear();
+        shared_lock<shared_mutex> guard(catalogLock);
+        uint64_t key = packIsbn(id);
+        auto it = bookIndex.find(key);
+        if (it == bookIndex.end())
+            return Status::NotFound;
+        lock_guard<mutex> bookGuard(bookLock(key));
+        for (size_t b = 0; b < branches.count(); b++)
+            where.push_back({branches.name((int)b), shelfAt((int)b, it->second)});
+        return Status::Ok;
+    }
+
+    // Opens a branch with no copies. Branches are never removed, so indexes
+    // into BranchStock taken under a shared lock stay valid.
+    Status addBranch(const string &name)
+    {
+        if (!BranchStock::isValidName(name))
+            return Status::Invalid;
+        unique_lock<shared_mutex> guard(catalogLock);
+        if (branches.find(name) >= 0)
+            return Status::Duplicate;
+        if (branches.add(name, books.size()) < 0)
+            return Status::Invalid;
+        if (!branches.saveNames(dataPath("branches.txt")))
+            cout << "Error: Could not write branches.txt\n";
+        return Status::Ok;
+    }
+
+    // Copies on the shelf at each branch across the whole catalog, main first
+    vector<BranchCopies> branchTotals()
+    {
+        unique_lock<shared_mutex> guard(catalogLock);
+        vector<long long> sums = branches.totals(books.size(), [this](size_t pos)
+                                                 { return books.copies(pos); });
+        vector<BranchCopies> totals;
+        for (size_t b = 0; b < sums.size(); b++)
+            totals.push_back({branches.name((int)b), sums[b]});
+        return totals;
+    }
+
+    vector<string> branchNames() const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        vector<string> names;
+        for (size_t b = 0; b < branches.count(); b++)
+            names.push_back(branches.name((int)b));
+        return names;
+    }
+
+    // Titles with the longest hold queues first (ties: the longest-waiting
+    // student first), at most limit of them
+    vector<HoldQueueInfo> holdQueues(size_t limit = 20) const
+    {
+        vector<HoldQueueInfo> queues;
+        unique_lock<shared_mutex> guard(catalogLock);
+        holds.forEach([&](uint64_t isbn, const HoldTable::Queue &queue)
+                      {
+            auto it = bookIndex.find(isbn);
+            if (it == bookIndex.end())
+                return;
+            time_t oldest = queue.waiting.empty() ? 0 : queue.waiting.front().placedAt;
+            for (const auto &hold : queue.ready)
+                oldest = oldest ? min(oldest, hold.placedAt) : hold.placedAt;
+            queues.push_back({unpackKey(isbn, 13), text(books.nameRef(it->second)), books.copies(it->second),
+                              (int)loans.borrowers(isbn), queue.waiting.size(), queue.ready.size(), oldest}); });
+        auto deeper = [](const HoldQueueInfo &a, const HoldQueueInfo &b)
+        {
+            if (a.waiting != b.waiting)
+                return a.waiting > b.waiting;
+            return a.oldestHold < b.oldestHold;
+        };
+        size_t keep = min(limit, queues.size());
+        partial_sort(queues.begin(), queues.begin() + keep, queues.end(), deeper);
+        queues.resize(keep);
+        return queues;
+    }
+
+    // Copies set aside and waiting to be collected, soonest deadline first
+    vector<HoldNotice> pendingPickups() const
+    {
+        vector<HoldNotice> pickups;
+        unique_lock<shared_mutex> guard(catalogLock);
+        holds.forEach([&](uint64_t isbn, const HoldTable::Queue &queue)
+                      {
+            auto book = bookIndex.find(isbn);
+            for (const auto &hold : queue.ready)
+            {
+                HoldNotice notice{unpackKey(hold.reg, 8), "", "", unpackKey(isbn, 13), "",
+                                  hold.readyAt + HOLD_PICKUP_DAYS * 86400};
+                if (book != bookIndex.end())
+                    notice.bookName = text(books.nameRef(book->second));
+                auto student = studentIndex.find(hold.reg);
+                if (student != studentIndex.end())
+                {
+                    notice.studentName = text(students.firstNameRef(student->second)) + " " +
+                                         text(students.lastNameRef(student->second));
+                    notice.email = text(students.emailRef(student->second));
+                }
+                pickups.push_back(std::move(notice));
+            } });
+        sort(pickups.begin(), pickups.end(), [](const HoldNotice &a, const HoldNotice &b)
+             { return a.pickupBy < b.pickupBy; });
+        return pickups;
+    }
+
+    // Lifetime hold counts since startup (see HoldTable::Counters)
+    const HoldTable::Counters &holdStats() const
+    {
+        return holds.stats();
+    }
+
+    // Open loans due in [from, to), earliest due first, at most limit of them.
+    // Walks only the due-date buckets in that range (see Loans.h).
+    vector<DueLoan> dueLoans(time_t from, time_t to, size_t limit = SIZE_MAX) const
+    {
+        vector<DueLoan> due;
+        time_t now = time(0);
+        unique_lock<shared_mutex> guard(catalogLock);
+        loans.forEachDue(from, to, [&](uint32_t reg, uint64_t isbn, time_t dueAt)
+                         {
+            const LoanTable::Loan *loan = loans.find(reg, isbn);
+            auto book = bookIndex.find(isbn);
+            due.push_back({unpackKey(reg, 8), unpackKey(isbn, 13), book == bookIndex.end() ? "" : text(books.nameRef(book->second)),
+                           loan ? loan->issuedAt : 0, dueAt, FineLedger::daysLate(dueAt, now)}); });
+        auto earlier = [](const DueLoan &a, const DueLoan &b)
+        {
+            if (a.dueAt != b.dueAt)
+                return a.dueAt < b.dueAt;
+            return a.regNumber < b.regNumber;
+        };
+        size_t keep = min(limit, due.size());
+        partial_sort(due.begin(), due.begin() + keep, due.end(), earlier);
+        due.resize(keep);
+        return due;
+    }
+
+    // Loans past their due date now, most overdue first
+    vector<DueLoan> overdueLoans(size_t limit = SIZE_MAX) const
+    {
+        return dueLoans(0, time(0), limit);
+    }
+
+    size_t overdueCount() const
+    {
+        size_t count = 0;
+        unique_lock<shared_mutex> guard(catalogLock);
+        loans.forEachDue(0, time(0), [&](uint32_t, uint64_t, time_t)
+                         { count++; });
+        return count;
+    }
+
+    // Outstanding fines of the student
+    long long fineBalance(const string &regNum) const
+    {
+        uint32_t reg = packRegNumber(regNum);
+        lock_guard<mutex> studentGuard(studentLock(reg));
+        return fines.balance(reg);
+    }
+
+    // Takes a payment towards the student's fines. remaining (if given)
+    // receives what is still owed afterwards.
+    Status payFine(const string &regNum, long long amount, long long *remaining = nullptr)
+    {
+        OperationTimer timer(metrics, Op::PayFine);
+        if (!isValidRegNumber(regNum) || amount <= 0)
+            return Status::Invalid;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            uint32_t reg = packRegNumber(regNum);
+            lock_guard<mutex> studentGuard(studentLock(reg));
+            long long owed = fines.balance(reg);
+            if (owed == 0)
+                return Status::NotFound;
+            if (amount > owed)
+                return Status::Invalid;
+            long long left = fines.pay(reg, amount);
+            if (remaining)
+                *remaining = left;
+            logChange('F', {regNum, to_string(left)});
+            logFinePaid(regNum, amount);
+        }
+        maybeCheckpoint();
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Brings fines up to date now; also runs by itself with the first change of each day
+    FineSweepReport sweepFines()
+    {
+        OperationTimer timer(metrics, Op::FineSweep);
+        timer.succeeded();
+        unique_lock<shared_mutex> guard(catalogLock);
+        return sweepFinesLocked(time(0));
+    }
+
+    // Circulation since the analytics period started: the limit most borrowed
+    // titles, most utilized titles and most active borrowers, and the issues
+    // and returns of the last hours hours. The top lists come from the heavy
+    // hitter counters; utilization is worked out for the titles that circulated
+    // in the period or are on loan, not for the whole catalog.
+    CirculationReport circulationReport(size_t limit = 10, int hours = 24) const
+    {
+        CirculationReport report;
+        time_t now = time(0);
+        unique_lock<shared_mutex> guard(catalogLock);
+        report.periodStart = analytics.periodStart();
+        report.issues = analytics.issues();
+        report.returns = analytics.returns();
+
+        for (const auto &counter : analytics.topTitleCounters(limit))
+        {
+            auto it = bookIndex.find(counter.key);
+            if (it != bookIndex.end())
+                report.mostBorrowed.push_back(titleActivityLocked(counter.key, it->second, now));
+        }
+        sort(report.mostBorrowed.begin(), report.mostBorrowed.end(), [](const TitleActivity &a, const TitleActivity &b)
+             { return a.issues > b.issues; });
+
+        // Only titles with loans in the period or out now have been on loan at all
+        unordered_set<uint64_t> circulated;
+        loans.forEach([&](uint32_t, const LoanTable::Loan &loan)
+                      { circulated.insert(loan.isbn); });
+        analytics.forEachTitle([&](uint64_t isbn, const Analytics::TitleStats &)
+                               { circulated.insert(isbn); });
+        for (uint64_t isbn : circulated)
+        {
+            auto it = bookIndex.find(isbn);
+            if (it != bookIndex.end())
+                report.mostUtilized.push_back(titleActivityLocked(isbn, it->second, now));
+        }
+        size_t keep = min(limit, report.mostUtilized.size());
+        partial_sort(report.mostUtilized.begin(), report.mostUtilized.begin() + keep, report.mostUtilized.end(),
+                     [](const TitleActivity &a, const TitleActivity &b)
+                     {
+                         if (a.utilization != b.utilization)
+                             return a.utilization > b.utilization;
+                         return a.issues > b.issues;
+                     });
+        report.mostUtilized.resize(keep);
+
+        for (const auto &counter : analytics.topBorrowerCounters(limit))
+        {
+            BorrowerActivity borrower{unpackKey(counter.key, 8), "", counter.count, counter.error};
+            auto it = studentIndex.find((uint32_t)counter.key);
+            if (it != studentIndex.end())
+                borrower.studentName = text(students.firstNameRef(it->second)) + " " + text(students.lastNameRef(it->second));
+            report.mostActive.push_back(std::move(borrower));
+        }
+
+        int64_t current = analytics.localHour(now);
+        for (int64_t hour = current - min(max(hours, 1), Analytics::HOUR_SLOTS) + 1; hour <= current; hour++)
+            report.recentHours.push_back({analytics.hourStart(hour), analytics.issuesInHour(hour), analytics.returnsInHour(hour)});
+        for (int hour = 0; hour < Analytics::WEEK_HOURS; hour++)
+            report.issuesByWeekHour.push_back(analytics.issuesInHourOfWeek(hour));
+        return report;
+    }
+
+    // Issues of one title since the analytics period started and the share of
+    // that time its copies were on loan
+    optional<TitleActivity> titleActivity(const string &id) const
+    {
+        time_t now = time(0);
+        shared_lock<shared_mutex> guard(catalogLock);
+        uint64_t key = packIsbn(id);
+        auto it = bookIndex.find(key);
+        if (it == bookIndex.end())
+            return nullopt;
+        lock_guard<mutex> bookGuard(bookLock(key));
+        return titleActivityLocked(key, it->second, now);
+    }
+
+    // Recomputes the analytics from circulation_log.txt and its rotated files
+    // on threads threads (0 = one per core). Counter operations carry on
+    // meanwhile: the files are read as far as they went when the rebuild
+    // started, and the events logged since are added under the catalog lock
+    // just before the result replaces the running aggregates.
+    Analytics::RebuildStats rebuildAnalytics(unsigned threads = 0)
+    {
+        OperationTimer timer(metrics, Op::RebuildAnalytics);
+        vector<Analytics::HistoryFile> history;
+        uint64_t rotations;
+        {
+            unique_lock<shared_mutex> guard(catalogLock);
+            circulationLog.flush();
+            rotations = circulationLog.rotationCount();
+            for (const string &path : circulationLog.files())
+                history.push_back({path, fileSize(path)});
+        }
+
+        auto rebuilt = make_unique<Analytics>();
+        Analytics::RebuildStats stats;
+        rebuilt->rebuild(history, threads, time(0), &stats);
+
+        {
+            unique_lock<shared_mutex> guard(catalogLock);
+            circulationLog.flush();
+            // The file that was current has been renamed to .1, .2, ... by any
+            // rotations since; read it from where the rebuild stopped, then
+            // every newer file
+            uint64_t rotated = circulationLog.rotationCount() - rotations;
+            const string &current = circulationLog.filePath();
+            for (uint64_t i = min<uint64_t>(rotated, CIRCULATION_LOG_FILES - 1) + 1; i-- > 0;)
+            {
+                string path = i == 0 ? current : current + "." + to_string(i);
+                Analytics::scanEvents(path, i == rotated ? history.back().size : 0, fileSize(path),
+                                      [&](const Analytics::Event &event)
+                                      {
+                                          rebuilt->record(event);
+                                          stats.events++;
+                                      });
+            }
+            analytics.replaceWith(*rebuilt);
+        }
+        timer.succeeded();
+        return stats;
+    }
+
+    // Returns a copy of the book's record, taken under its lock
+    optional<Record> getBook(const string &id) const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        auto it = bookIndex.find(packIsbn(id));
+        if (it == bookIndex.end())
+            return nullopt;
+        lock_guard<mutex> bookGuard(bookLock(it->first));
+        return bookRecord(it->second);
+    }
+
+    // Books whose title or author contains every word of query (the last one may
+    // be unfinished), at most limit of them, sorted by title. See SearchIndex.h.
+    vector<Record> searchBooks(const string &query, size_t limit = 20) const
+    {
+        OperationTimer timer(metrics, Op::Search);
+        timer.succeeded();
+        vector<Record> results;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            vector<uint64_t> keys = searchIndex.search(query, limit, [&](uint64_t key, string_view &name, string_view &author)
+                                                       {
+                auto it = bookIndex.find(key);
+                if (it == bookIndex.end())
+                    return false;
+                name = strings.view(books.nameRef(it->second));
+                author = strings.view(books.authorRef(it->second));
+                return true; });
+            results.reserve(keys.size());
+            for (uint64_t key : keys)
+            {
+                lock_guard<mutex> bookGuard(bookLock(key));
+                results.push_back(bookRecord(bookIndex.find(key)->second));
+            }
+        }
+        sort(results.begin(), results.end(), [](const Record &a, const Record &b)
+             { return a.bookName < b.bookName; });
+        return results;
+    }
+
+    // Books whose title or author has a word within a few typos of every word
+    // of query, at most limit of them, closest first and then by title; each
+    // record is paired with its distance. See SearchIndex::fuzzySearch.
+    vector<pair<Record, int>> fuzzySearchBooks(const string &query, size_t limit = 20) const
+    {
+        OperationTimer timer(metrics, Op::FuzzySearch);
+        timer.succeeded();
+        vector<pair<Record, int>> results;
+        {
+            shared_lock<shared_mutex> guard(catalogLock);
+            vector<SearchIndex::FuzzyMatch> matches = searchIndex.fuzzySearch(query, limit);
+            results.reserve(matches.size());
+            for (const auto &match : matches)
+            {
+                lock_guard<mutex> bookGuard(bookLock(match.key));
+                results.emplace_back(bookRecord(bookIndex.find(match.key)->second), match.distance);
+            }
+        }
+        sort(results.begin(), results.end(), [](const pair<Record, int> &a, const pair<Record, int> &b)
+             { return a.second != b.second ? a.second < b.second : a.first.bookName < b.first.bookName; });
+        return results;
+    }
+
+    // Students whose first or last name is within a few typos of every word of
+    // name, closest first and then by registration number
+    vector<pair<Student, int>> fuzzyFindStudents(const string &name, size_t limit = 20) const
+    {
+        OperationTimer timer(metrics, Op::FuzzySearch);
+        timer.succeeded();
+        vector<pair<Student, int>> results;
+        shared_lock<shared_mutex> guard(catalogLock);
+        for (const auto &match : nameIndex.fuzzySearch(name, limit))
+        {
+            auto it = studentIndex.find((uint32_t)match.key);
+            if (it != studentIndex.end())
+                results.emplace_back(studentRecord(it->second), match.distance);
+        }
+        sort(results.begin(), results.end(), [](const pair<Student, int> &a, const pair<Student, int> &b)
+             { return a.second != b.second ? a.second < b.second : a.first.regNumber < b.first.regNumber; });
+        return results;
+    }
+
+    optional<Student> getStudent(const string &regNum) const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        auto it = studentIndex.find(packRegNumber(regNum));
+        if (it == studentIndex.end())
+            return nullopt;
+        return studentRecord(it->second);
+    }
+
+    // Students matching a registration number, phone number or email, whichever
+    // the key looks like. A phone number can match several older records.
+    vector<Student> findStudents(const string &key) const
+    {
+        vector<Student> found;
+        shared_lock<shared_mutex> guard(catalogLock);
+        vector<uint32_t> regs;
+        if (key.find('@') != string::npos)
+            regs = studentsWithEmail(key);
+        else if (isValidRegNumber(key))
+            regs.push_back(packRegNumber(key));
+        else
+        {
+            auto range = phoneIndex.equal_range(packPhone(key));
+            for (auto it = range.first; it != range.second; ++it)
+                regs.push_back(it->second);
+        }
+        for (uint32_t reg : regs)
+        {
+            auto it = studentIndex.find(reg);
+            if (it != studentIndex.end())
+                found.push_back(studentRecord(it->second));
+        }
+        sort(found.begin(), found.end(), [](const Student &a, const Student &b)
+             { return a.regNumber < b.regNumber; });
+        return found;
+    }
+
+    // The student's open loans, earliest due first
+    vector<DueLoan> studentLoans(const string &regNum) const
+    {
+        vector<DueLoan> result;
+        uint32_t reg = packRegNumber(regNum);
+        time_t now = time(0);
+        shared_lock<shared_mutex> guard(catalogLock);
+        lock_guard<mutex> studentGuard(studentLock(reg));
+        if (const vector<LoanTable::Loan> *open = loans.loansOf(reg))
+            for (const auto &loan : *open)
+            {
+                auto book = bookIndex.find(loan.isbn);
+                result.push_back({regNum, unpackKey(loan.isbn, 13),
+                                  book == bookIndex.end() ? "" : text(books.nameRef(book->second)), loan.issuedAt,
+                                  loan.dueAt, FineLedger::daysLate(loan.dueAt, now)});
+            }
+        sort(result.begin(), result.end(), [](const DueLoan &a, const DueLoan &b)
+             { return a.dueAt < b.dueAt; });
+        return result;
+    }
+
+    // Number of books the student currently has issued
+    int issuedCount(const string &regNum) const
+    {
+        uint32_t reg = packRegNumber(regNum);
+        lock_guard<mutex> studentGuard(studentLock(reg));
+        return loans.count(reg);
+    }
+
+    // Number of copies of the book currently out on loan
+    int onLoanCount(const string &id) const
+    {
+        uint64_t key = packIsbn(id);
+        lock_guard<mutex> bookGuard(bookLock(key));
+        return (int)loans.borrowers(key);
+    }
+
+    size_t bookCount() const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        return books.size();
+    }
+
+    size_t studentCount() const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        return students.size();
+    }
+
+    size_t loanCount() const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        return loans.size();
+    }
+
+    // Approximate heap bytes held by the book and student rows and their text
+    size_t storageBytes() const
+    {
+        shared_lock<shared_mutex> guard(catalogLock);
+        return books.memoryUsage() + students.memoryUsage() + strings.memoryUsage();
+    }
+
+    // The paged text of books and students, or nullptr when it is all in
+    // memory (see PageCache.h); for its hit and miss counts
+    const PagedFile *pageCache() const
+    {
+        return strings.pagedFile();
+    }
+
+    // Checks user's password for a login from terminal (any name for where the
+    // attempt came from: "console", a peer address, ...). Ok opens a session and
+    // fills info; Denied for an unknown user and a wrong password alike;
+    // Throttled, with info->retryAfter, after too many failures for the user or
+    // the terminal. Every attempt is written to login_log.txt.
+    Status login(const string &user, const string &password, const string &terminal, LoginInfo *info = nullptr)
+    {
+        OperationTimer timer(metrics, Op::Login);
+        time_t now = time(0);
+        uint64_t userKey = LoginThrottle::key('u', user);
+        uint64_t terminalKey = LoginThrottle::key('t', terminal);
+        AccountTable::Account account;
+        bool known;
+        {
+            lock_guard<mutex> guard(accountLock);
+            long long wait = max(throttle.wait(userKey, LoginThrottle::USER, now),
+                                 throttle.wait(terminalKey, LoginThrottle::TERMINAL, now));
+            if (wait > 0)
+            {
+                if (info)
+                    info->retryAfter = wait;
+                logLoginAttempt(user, terminal, Status::Throttled);
+                return Status::Throttled;
+            }
+            // Counted as a failure up front, so concurrent guesses cannot all pass the check above
+            throttle.take(userKey, LoginThrottle::USER, now);
+            throttle.take(terminalKey, LoginThrottle::TERMINAL, now);
+            const AccountTable::Account *found = accounts.find(user);
+            known = found != nullptr;
+            if (known)
+                account = *found;
+        }
+
+        bool matches = AccountTable::verify(known ? &account : nullptr, password);
+        lock_guard<mutex> guard(accountLock);
+        if (!matches)
+        {
+            logLoginAttempt(user, terminal, Status::Denied);
+            return Status::Denied;
+        }
+        throttle.reset(userKey);
+        throttle.give(terminalKey, LoginThrottle::TERMINAL, now);
+        string token = sessions.open(user, account.role, terminal, now);
+        if (info)
+        {
+            info->token = token;
+            info->role = account.role;
+        }
+        logLoginAttempt(user, terminal, Status::Ok);
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    // Ok if token is a live session, from any terminal, and restarts its idle
+    // time; Denied otherwise. A hash lookup, so it can run on every request.
+    Status resume(const string &token, AccountRole *role = nullptr, string *user = nullptr)
+    {
+        lock_guard<mutex> guard(accountLock);
+        const SessionTable::Session *session = sessions.touch(token, time(0));
+        if (!session)
+            return Status::Denied;
+        if (role)
+            *role = session->role;
+        if (user)
+            *user = session->user;
+        return Status::Ok;
+    }
+
+    Status logout(const string &token)
+    {
+        lock_guard<mutex> guard(accountLock);
+        return sessions.close(token) ? Status::Ok : Status::NotFound;
+    }
+
+    // Invalid for a bad user name or password (see AccountTable); Duplicate if the user exists
+    Status addAccount(const string &user, AccountRole role, const string &password)
+    {
+        if (!AccountTable::validName(user) || !AccountTable::validPassword(password))
+            return Status::Invalid;
+        {
+            lock_guard<mutex> guard(accountLock);
+            if (accounts.find(user))
+                return Status::Duplicate;
+        }
+        AccountTable::Account account = AccountTable::make(role, password);
+        lock_guard<mutex> guard(accountLock);
+        if (accounts.find(user))
+            return Status::Duplicate;
+        accounts.set(user, account);
+        saveAccounts();
+        return Status::Ok;
+    }
+
+    // Also ends the user's open sessions, so whoever else knew the old password is logged out
+    Status setPassword(const string &user, const string &password)
+    {
+        if (!AccountTable::validPassword(password))
+            return Status::Invalid;
+        AccountRole role;
+        {
+            lock_guard<mutex> guard(accountLock);
+            const AccountTable::Account *found = accounts.find(user);
+            if (!found)
+                return Status::NotFound;
+            role = found->role;
+        }
+        AccountTable::Account account = AccountTable::make(role, password);
+        lock_guard<mutex> guard(accountLock);
+        if (!accounts.find(user))
+            return Status::NotFound;
+        accounts.set(user, account);
+        sessions.closeUser(user);
+        saveAccounts();
+        return Status::Ok;
+    }
+
+    // User names and roles, by name
+    vector<pair<string, AccountRole>> accountList() const
+    {
+        vector<pair<string, AccountRole>> list;
+        {
+            lock_guard<mutex> guard(accountLock);
+            accounts.forEach([&](const string &user, const AccountTable::Account &account)
+                             { list.push_back({user, account.role}); });
+        }
+        sort(list.begin(), list.end());
+        return list;
+    }
+
+    // Every metric in the Prometheus text format (see Metrics.h)
+    string metricsText() const
+    {
+        ostringstream extra;
+        extra << "# HELP lms_journal_bytes_total Bytes appended to journal.log.\n"
+              << "# TYPE lms_journal_bytes_total counter\n"
+              << "lms_journal_bytes_total " << journal.bytesAppended() << "\n"
+              << "# HELP lms_audit_events_total Audit log events written, and dropped (queue full past the wait, "
+                 "or write failed).\n"
+              << "# TYPE lms_audit_events_total counter\n";
+        const pair<const char *, const AuditLog *> logs[] = {{"login", &loginLog}, {"circulation", &circulationLog}};
+        for (const auto &log : logs)
+            extra << "lms_audit_events_total{log=\"" << log.first << "\",outcome=\"written\"} " << log.second->writtenCount()
+                  << "\nlms_audit_events_total{log=\"" << log.first << "\",outcome=\"dropped\"} "
+                  << log.second->droppedCount() << "\n";
+        extra << "# HELP lms_books Titles in the inventory.\n# TYPE lms_books gauge\nlms_books " << bookCount() << "\n"
+              << "# HELP lms_students Registered students.\n# TYPE lms_students gauge\nlms_students " << studentCount()
+              << "\n"
+              << "# HELP lms_storage_bytes Heap bytes held by book and student rows.\n# TYPE lms_storage_bytes gauge\n"
+              << "lms_storage_bytes " << storageBytes() << "\n";
+        {
+            lock_guard<mutex> guard(accountLock);
+            extra << "# HELP lms_sessions Open login sessions.\n# TYPE lms_sessions gauge\n"
+                  << "lms_sessions " << sessions.size() << "\n"
+                  << "# HELP lms_login_throttle_buckets User names and terminals with failed logins not yet forgiven.\n"
+                  << "# TYPE lms_login_throttle_buckets gauge\n"
+                  << "lms_login_throttle_buckets " << throttle.size() << "\n";
+        }
+        if (const PagedFile *paged = strings.pagedFile())
+            extra << "# HELP lms_page_cache_lookups_total Reads of record text pages, by whether the page was cached.\n"
+                  << "# TYPE lms_page_cache_lookups_total counter\n"
+                  << "lms_page_cache_lookups_total{result=\"hit\"} " << paged->hits() << "\n"
+                  << "lms_page_cache_lookups_total{result=\"miss\"} " << paged->misses() << "\n"
+                  << "# HELP lms_page_cache_evictions_total Cached pages dropped to stay within the budget.\n"
+                  << "# TYPE lms_page_cache_evictions_total counter\n"
+                  << "lms_page_cache_evictions_total " << paged->evictions() << "\n"
+                  << "# HELP lms_page_cache_errors_total Pages of records.pages that could not be written or read.\n"
+                  << "# TYPE lms_page_cache_errors_total counter\n"
+                  << "lms_page_cache_errors_total " << paged->errors() << "\n"
+                  << "# HELP lms_page_cache_budget_bytes Memory the page cache may use.\n"
+                  << "# TYPE lms_page_cache_budget_bytes gauge\n"
+                  << "lms_page_cache_budget_bytes " << paged->budget() << "\n"
+                  << "# HELP lms_paged_bytes Record text in records.pages.\n# TYPE lms_paged_bytes gauge\n"
+                  << "lms_paged_bytes " << paged->size() << "\n";
+
+        const HoldTable::Counters &holdCounts = holds.stats();
+        extra << "# HELP lms_holds Holds by state (waiting in a queue, or copy set aside for pickup).\n"
+              << "# TYPE lms_holds gauge\n"
+              << "lms_holds{state=\"waiting\"} " << holds.waitingTotal() << "\n"
+              << "lms_holds{state=\"ready\"} " << holds.readyTotal() << "\n"
+              << "# HELP lms_hold_events_total Hold queue events since startup.\n"
+              << "# TYPE lms_hold_events_total counter\n";
+        const pair<const char *, const atomic<uint64_t> *> holdEvents[] = {
+            {"placed", &holdCounts.placed},       {"allocated", &holdCounts.allocated},
+            {"fulfilled", &holdCounts.fulfilled}, {"cancelled", &holdCounts.cancelled},
+            {"expired", &holdCounts.expired}};
+        for (const auto &event : holdEvents)
+            extra << "lms_hold_events_total{event=\"" << event.first << "\"} " << event.second->load() << "\n";
+        extra << "# HELP lms_loans_overdue Open loans past their due date.\n# TYPE lms_loans_overdue gauge\n"
+              << "lms_loans_overdue " << overdueCount() << "\n"
+              << "# HELP lms_fines_outstanding Fines owed by all students.\n# TYPE lms_fines_outstanding gauge\n"
+              << "lms_fines_outstanding " << fines.outstanding() << "\n"
+              << "# HELP lms_fines_total Fines charged and paid since startup.\n# TYPE lms_fines_total counter\n"
+              << "lms_fines_total{event=\"charged\"} " << fines.charged() << "\n"
+              << "lms_fines_total{event=\"paid\"} " << fines.paid() << "\n";
+        extra << "# HELP lms_hold_wait_seconds_total Time from placing a hold to a copy being set aside, summed.\n"
+              << "# TYPE lms_hold_wait_seconds_total counter\n"
+              << "lms_hold_wait_seconds_total " << holdCounts.waitSeconds.load() << "\n";
+        return metrics.toPrometheus(extra.str());
+    }
+
+    // Writes metricsText() to path, for a node exporter textfile collector or a
+    // scrape by hand. The file is replaced atomically, so a collector never reads half of it.
+    bool writeMetrics(const string &path) const
+    {
+        DurableWriter file(path);
+        file.append(metricsText());
+        return file.commit();
+    }
+
+    // Paged listings. A page holds up to pageSize rows that come after the
+    // cursor (the ISBN or registration number of the previous page's last row,
+    // or "" for the first page). Sort orders are cached between calls, so a page
+    // costs O(pageSize) unless the data changed since the order was built.
+    // Returns NotFound if the cursor record no longer exists.
+    Status listBooks(BookOrder order, bool availableOnly, const string &after, size_t pageSize, vector<Record> &page)
+    {
+        OperationTimer timer(metrics, Op::ListBooks);
+        page.clear();
+        unique_lock<shared_mutex> guard(catalogLock);
+        const vector<size_t> *view = nullptr;
+        if (order != BookOrder::Catalog)
+            view = &bookView(order);
+
+        size_t start = 0;
+        if (!after.empty())
+        {
+            auto it = bookIndex.find(packIsbn(after));
+            if (it == bookIndex.end())
+                return Status::NotFound;
+            start = it->second + 1;
+            if (view)
+                start = upper_bound(view->begin(), view->end(), it->second, bookLess(order)) - view->begin();
+        }
+
+        for (size_t i = start; i < books.size() && page.size() < pageSize; i++)
+        {
+            size_t pos = view ? (*view)[i] : i;
+            if (!availableOnly || books.copies(pos) > 0)
+                page.push_back(bookRecord(pos));
+        }
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    Status listStudents(StudentOrder order, const string &after, size_t pageSize, vector<Student> &page)
+    {
+        OperationTimer timer(metrics, Op::ListStudents);
+        page.clear();
+        unique_lock<shared_mutex> guard(catalogLock);
+        const vector<size_t> *view = nullptr;
+        if (order != StudentOrder::Catalog)
+            view = &studentView(order);
+
+        size_t start = 0;
+        if (!after.empty())
+        {
+            auto it = studentIndex.find(packRegNumber(after));
+            if (it == studentIndex.end())
+                return Status::NotFound;
+            start = it->second + 1;
+            if (view)
+                start = upper_bound(view->begin(), view->end(), it->second, studentLess(order)) - view->begin();
+        }
+
+        for (size_t i = start; i < students.size() && page.size() < pageSize; i++)
+            page.push_back(studentRecord(view ? (*view)[i] : i));
+        timer.succeeded();
+        return Status::Ok;
+    }
+
+    void addStudent()
+    {
+        string fName, lName, regNum, phone, email;
+        cout << "\nEnter first name: ";
+        cin >> fName;
+        cout << "Enter last name: ";
+        cin >> lName;
+        cout << "Enter registration number (8 digits): ";
+        cin >> regNum;
+        while (!isValidRegNumber(regNum))
+        {
+            cout << "Invalid registration number! It must be an 8-digit number: ";
+            cin >> regNum;
+        }
+
+        // Check if student already exists
+        if (getStudent(regNum))
+        {
+            cout << "\nError: A student with this registration number already exists!\n";
+            return;
+        }
+
+        cout << "Enter phone number (starting with 6, 7, 8, or 9): ";
+        cin >> phone;
+        while (!isValidPhone(phone) || !findStudents(phone).empty())
+        {
+            if (isValidPhone(phone))
+                cout << "This phone number is already registered to another student. Enter a different one: ";
+            else
+                cout << "Invalid phone number! It must start with 6, 7, 8, or 9 and be 10 digits long: ";
+            cin >> phone;
+        }
+
+        cout << "Enter email address: ";
+        cin >> email;
+        while (!isValidEmail(email) || !findStudents(email).empty())
+        {
+            if (isValidEmail(email))
+                cout << "This email is already registered to another student. Enter a different one: ";
+            else
+                cout << "Invalid email! It must end with @gmail.com, @outlook.com, or @lpu.in: ";
+            cin >> email;
+        }
+
+        // Another counter may have registered the same details meanwhile
+        if (addStudent(fName, lName, regNum, phone, email) != Status::Ok)
+        {
+            cout << "\nError: The registration number, phone number or email is already registered.\n";
+            return;
+        }
+        cout << "\nThe student has been successfully registered.\n";
+    }
+
+    void addBook()
+    {
+        string bName, auth, id;
+        int num;
+
+        cout << "\nEnter book name: ";
+        cin.ignore();
+        getline(cin, bName);
+        while (!isValidBookName(bName))
+        {
+            cout << "Invalid book name! Only letters, numbers, spaces, and basic punctuation allowed: ";
+            getline(cin, bName);
+        }
+
+        cout << "Enter author name: ";
+        getline(cin, auth);
+        while (!isValidAuthorName(auth))
+        {
+            cout << "Invalid author name! Only letters, spaces, and basic punctuation allowed: ";
+            getline(cin, auth);
+        }
+
+        cout << "Enter ISBN (13 digits): ";
+        cin >> id;
+        // Titles already in the inventory are restocked even if they predate the check digit rule
+        while (!isValidIsbn13Checksum(id) && !(isValidIsbn(id) && getBook(id)))
+        {
+            cout << "Invalid ISBN! It must be exactly 13 digits with a valid ISBN-13 check digit: ";
+            cin >> id;
+        }
+
+        cout << "Enter number of copies: ";
+        num = getIntInput();
+        string branch = askBranch("Which branch are the copies for?");
+
+        bool exists = getBook(id).has_value();
+        if (addBook(bName, auth, id, num, branch) != Status::Ok)
+            cout << "\nInvalid number of copies.\n";
+        else if (exists)
+            cout << "\nThe book already exists. Updated copies count.\n";
+        else
+            cout << "\nThe book has been successfully added.\n";
+    }
+
+    void deleteBook()
+    {
+        string id;
+        cout << "\nEnter ISBN to delete: ";
+        cin >> id;
+
+        if (!getBook(id))
+        {
+            cout << "\nBook not found in the inventory.\n";
+            return;
+        }
+
+        cout << "Enter number of copies to remove: ";
+        int num;
+        num = getIntInput();
+
+        if (deleteBook(id, num) != Status::Ok)
+            cout << "\nInvalid number of copies.\n";
+        else if (optional<Record> book = getBook(id))
+            cout << "\n"
+                 << num << " copies have been removed. Remaining: " << book->copies << endl;
+        else
+            cout << "\nAll copies of the book have been removed from the inventory.\n";
+    }
+
+    void updateBook()
+    {
+        string id;
+        cout << "\nEnter ISBN to update: ";
+        cin >> id;
+        if (!getBook(id))
+        {
+            cout << "\nBook not found in the inventory.\n";
+            return;
+        }
+
+        string branch = askBranch("Which branch's copies are being updated?");
+        cout << "Enter new number of copies: ";
+        if (updateBook(id, getIntInput(), branch) != Status::Ok)
+        {
+            cout << "\nInvalid number of copies.\n";
+            return;
+        }
+        cout << "\nThe book details have been successfully updated.\n";
+    }
+
+    // Lets the user pick a branch; returns its name, or "" (main) when the
+    // library has only the one
+    string askBranch(const string &question)
+    {
+        vector<string> names = branchNames();
+        if (names.size() == 1)
+            return "";
+        cout << "\n" << question << "\n";
+        for (size_t b = 0; b < names.size(); b++)
+            cout << b + 1 << ". " << names[b] << "\n";
+        cout << "Enter choice: ";
+        int choice = getIntInput();
+        while (choice < 1 || choice > (int)names.size())
+        {
+            cout << "Invalid choice! Enter 1 to " << names.size() << ": ";
+            choice = getIntInput();
+        }
+        return choice == 1 ? "" : names[choice - 1];
+    }
+
+    // Asked at counter login: issues and returns at this counter use its branch's shelf
+    void chooseCounterBranch()
+    {
+        counterBranch = askBranch("Which branch is this counter at?");
+        if (!counterBranch.empty())
+            cout << "\nCounter is at the " << counterBranch << " branch.\n";
+    }
+
+    // Copies of a title on the shelf at every branch
+    void showWhereAvailable()
+    {
+        string id;
+        cout << "\nEnter ISBN: ";
+        cin >> id;
+        optional<Record> book = getBook(id);
+        vector<BranchCopies> where;
+        if (!book || whereAvailable(id, where) != Status::Ok)
+        {
+            cout << "\nBook not found in the inventory.\n";
+            return;
+        }
+
+        TextTable table;
+        table.cell("\n===============================\n" + book->bookName + "\n===============================\n");
+        table.cell("Branch", 25).cell("Copies on Shelf").endRow();
+        table.cell("----------------------------------------").endRow();
+        for (const auto &branch : where)
+            table.cell(branch.branch, 25).cell(branch.copies).endRow();
+        table.flush(cout);
+    }
+
+    // Branches with the copies on each one's shelf; adding a branch and
+    // moving copies between them
+    void manageBranches()
+    {
+        int choice;
+        do
+        {
+            cout << "\n1. List Branches\n2. Add Branch\n3. Transfer Copies\n4. Find a Copy\n5. Back\nEnter choice: ";
+            choice = getIntInput();
+            if (choice == 1)
+            {
+                TextTable table;
+                table.cell("\n===============================\nBranches\n===============================\n");
+                table.cell("Branch", 25).cell("Copies on Shelf").endRow();
+                table.cell("----------------------------------------").endRow();
+                for (const auto &branch : branchTotals())
+                    table.cell(branch.branch, 25).cell(branch.copies).endRow();
+                table.flush(cout);
+            }
+            else if (choice == 2)
+            {
+                string name;
+                cout << "\nEnter branch name (letters, digits and '-', up to " << BranchStock::MAX_NAME_LENGTH << "): ";
+                cin >> name;
+                switch (addBranch(name))
+                {
+                case Status::Ok:
+                    cout << "\nThe branch has been added. Transfer copies to stock it.\n";
+                    break;
+                case Status::Duplicate:
+                    cout << "\nA branch with this name already exists.\n";
+                    break;
+                default:
+                    cout << "\nInvalid branch name, or the maximum of " << BranchStock::MAX_BRANCHES
+                         << " branches is reached.\n";
+                }
+            }
+            else if (choice == 3)
+            {
+                string id;
+                cout << "\nEnter ISBN: ";
+                cin >> id;
+                string from = askBranch("Transfer from which branch?");
+                string to = askBranch("Transfer to which branch?");
+                cout << "Enter number of copies: ";
+                switch (transferCopies(id, from, to, getIntInput()))
+                {
+                case Status::Ok:
+                    cout << "\nThe copies have been transferred.\n";
+                    break;
+                case Status::NotFound:
+                    cout << "\nBook not found in the inventory.\n";
+                    break;
+                case Status::Unavailable:
+                    cout << "\nThe branch does not have that many copies on the shelf.\n";
+                    break;
+                default:
+                    cout << "\nInvalid transfer: pick two different branches and a positive number of copies.\n";
+                }
+            }
+            else if (choice == 4)
+                showWhereAvailable();
+            else if (choice != 5)
+                cout << "Invalid option! Please try again.\n";
+        } while (choice != 5);
+    }
+
+    // Asks whether to show the next page; true to continue
+    bool askNextPage()
+    {
+        cout << "\n1. Next page\n2. Stop\nEnter choice: ";
+        return getIntInput() == 1;
+    }
+
+    void showAllBooks()
+    {
+        if (bookCount() == 0)
+        {
+            cout << "\nThe library inventory is currently empty.\n";
+            return;
+        }
+
+        cout << "\nSort by:\n1. Catalog order\n2. Title\n3. Author\n4. Copies available\nEnter choice: ";
+        int sortChoice = getIntInput();
+        BookOrder order = sortChoice >= 2 && sortChoice <= 4 ? (BookOrder)(sortChoice - 1) : BookOrder::Catalog;
+        cout << "Show only books with copies available? (1 = Yes, 0 = No): ";
+        bool availableOnly = getIntInput() == 1;
+
+        TextTable table;
+        table.cell("\n===============================\nList of All Books\n===============================\n");
+        table.cell("Book Name", 30).cell("Author", 25).cell("ISBN", 20).cell("Copies").endRow();
+        table.cell("---------------------------------------------------------------").endRow();
+
+        vector<Record> page;
+        string cursor;
+        size_t shown = 0;
+        while (true)
+        {
+            // Fetch one extra row to know whether another page follows
+            if (listBooks(order, availableOnly, cursor, PAGE_SIZE + 1, page) != Status::Ok)
+            {
+                cout << "\nThe inventory changed while listing. Please start again.\n";
+                return;
+            }
+            bool more = page.size() > PAGE_SIZE;
+            if (more)
+                page.pop_back();
+
+            for (const auto &book : page)
+                table.cell(book.bookName, 30).cell(book.author, 25).cell(book.isbn, 20).cell(book.copies).endRow();
+            shown += page.size();
+            if (shown == 0)
+                table.cell("No books match.").endRow();
+            table.flush(cout);
+
+            if (!more || !askNextPage())
+                return;
+            cursor = page.back().isbn;
+        }
+    }
+
+    void searchBooks()
+    {
+        const size_t LIMIT = 50;
+        string query;
+        cout << "\nEnter words from the title or author: ";
+        cin.ignore();
+        getline(cin, query);
+
+        vector<Record> results = searchBooks(query, LIMIT + 1);
+        if (results.empty())
+        {
+            // Perhaps a word is misspelt: offer the closest titles instead
+            vector<pair<Record, int>> close = fuzzySearchBooks(query, 10);
+            if (close.empty())
+            {
+                cout << "\nNo books match your search.\n";
+                return;
+            }
+            cout << "\nNo books match your search exactly. Did you mean:\n";
+            for (const auto &match : close)
+                results.push_back(match.first);
+        }
+
+        cout << "\n===============================\nSearch Results\n===============================\n";
+        cout << left << setw(30) << "Book Name" << setw(25) << "Author" << setw(20) << "ISBN" << setw(10)<< "Copies\n";
+        cout << "---------------------------------------------------------------\n";
+        for (size_t i = 0; i < results.size() && i < LIMIT; i++)
+        {
+            const Record &book = results[i];
+            cout << left << setw(30) << book.bookName << setw(25) << book.author << setw(20) << book.isbn << setw(10)<< book.copies << endl;
+        }
+        if (results.size() > LIMIT)
+            cout << "\nShowing the first " << LIMIT << " matches. Add more words to narrow the search.\n";
+    }
+
+    void issueBook()
+    {
+        string id;
+        cout << "\nEnter ISBN: ";
+        cin >> id;
+
+        // A title with no copies on the shelf may still have one set aside for this student's hold
+        optional<Record> book = getBook(id);
+        if (!book)
+        {
+            cout << "\nThe requested book is not available or not found in the inventory.\n";
+            return;
+        }
+
+        // Get student details
+        string regNum;
+        cout << "Enter student registration number (8 digits): ";
+        cin >> regNum;
+        while (!isValidRegNumber(regNum))
+        {
+            cout << "Invalid registration number! It must be an 8-digit number: ";
+            cin >> regNum;
+        }
+
+        switch (issueBook(regNum, id, counterBranch))
+        {
+        case Status::Ok:
+            break;
+        case Status::LimitReached:
+            cout << "\nThis student has already issued 3 books and cannot issue more.\n";
+            return;
+        case Status::AlreadyIssued:
+            cout << "\nThis student has already issued this book.\n";
+            return;
+        case Status::Unavailable:
+            if (!showOtherBranches(id))
+                offerHold(regNum, id);
+            return;
+        default:
+            cout << "\nThe requested book is not available or not found in the inventory.\n";
+            return;
+        }
+
+        // Display receipt for the issued book
+        cout << "\nThe book has been successfully issued.\n";
+        cout << "============================================\n";
+        cout << "Receipt for Book Issue\n";
+        cout << "--------------------------------------------\n";
+        cout << "Book Name: " << book->bookName << "\nAuthor: " << book->author << "\nISBN: " << book->isbn << "\n";
+        cout << "Student Registration Number: " << regNum << "\n";
+        cout << "Due Date: " << formatDate(time(0) + LOAN_DAYS * 86400) << "\n";
+        cout << "--------------------------------------------\n";
+    }
+
+    void returnBook()
+    {
+        string id;
+        cout << "\nEnter ISBN of the book to return: ";
+        cin >> id;
+
+        optional<Record> book = getBook(id);
+        if (!book)
+        {
+            cout << "\nInvalid ISBN. Book not found in the inventory.\n";
+            return;
+        }
+
+        // The name on the receipt comes from the student's record, not from retyping it
+        optional<Student> student = askStudent();
+        if (!student)
+            return;
+        const string &regNum = student->regNumber;
+
+        ReturnInfo info;
+        if (returnBook(regNum, id, &info, counterBranch) != Status::Ok)
+        {
+            cout << "\nError: No record of this book being issued to this student.\n";
+            return;
+        }
+
+        cout << "\nThe book has been successfully returned.\n";
+        cout << "============================================\n";
+        cout << "Receipt for Book Return\n";
+        cout << "--------------------------------------------\n";
+        cout << "Book Name: " << book->bookName << "\nAuthor: " << book->author << "\nISBN: " << book->isbn << "\n";
+        cout << "Student Name: " << student->firstName << " " << student->lastName << "\nRegistration Number: " << regNum
+             << "\n";
+        if (info.daysLate > 0)
+            cout << "Days Overdue: " << info.daysLate << "\nFine: Rs. " << info.fine << "\n";
+        if (info.balance > 0)
+            cout << "Total Fines Owed: Rs. " << info.balance << "\n";
+        cout << "--------------------------------------------\n";
+        for (const auto &notice : info.notices)
+            printPickupNotice(notice);
+    }
+
+    // Looks a student up by registration number, phone number or email, or
+    // failing those by a first or last name (allowing typos), and shows who
+    // was found. A registration number with no student record (loans
+    // can predate registration) is accepted with a warning.
+    optional<Student> askStudent()
+    {
+        string key;
+        cout << "Enter student registration number, phone number, email or name: ";
+        cin >> key;
+        vector<Student> found = findStudents(key);
+        bool byName = false;
+        if (found.empty() && any_of(key.begin(), key.end(), ::isalpha) && key.find('@') == string::npos)
+        {
+            for (auto &match : fuzzyFindStudents(key, 10))
+                found.push_back(match.first);
+            byName = true;
+        }
+        if (found.empty())
+        {
+            if (isValidRegNumber(key) && issuedCount(key) > 0)
+            {
+                cout << "\nNo student record for " << key << "; continuing with the registration number.\n";
+                return Student("", "", key, "", "");
+            }
+            cout << "\nNo student matches " << key << ".\n";
+            return nullopt;
+        }
+        if (found.size() > 1 || byName)
+        {
+            cout << (byName ? "\nStudents with a similar name:\n" : "\nSeveral students share this phone number:\n");
+            for (const auto &student : found)
+                cout << "  " << student.regNumber << "  " << student.firstName << " " << student.lastName << "\n";
+            cout << "Enter the registration number: ";
+            cin >> key;
+            auto match = find_if(found.begin(), found.end(), [&](const Student &student)
+                                 { return student.regNumber == key; });
+            if (match == found.end())
+            {
+                cout << "\nNo matching student.\n";
+                return nullopt;
+            }
+            return *match;
+        }
+        cout << "Student: " << found[0].firstName << " " << found[0].lastName << " (" << found[0].regNumber << ")\n";
+        return found[0];
+    }
+
+    // Record, open loans and fines of a student found by any of the three keys or by name
+    void findStudent()
+    {
+        cout << "\n";
+        optional<Student> student = askStudent();
+        if (!student || student->firstName.empty())
+            return;
+
+        TextTable table;
+        table.cell("\n===============================\nStudent\n===============================\n");
+        table.cell("Name: " + student->firstName + " " + student->lastName).endRow();
+        table.cell("Registration Number: " + student->regNumber).endRow();
+        table.cell("Phone: " + student->phone).endRow();
+        table.cell("Email: " + student->email).endRow();
+        table.cell("Fines Owed: Rs. " + to_string(fineBalance(student->regNumber))).endRow();
+
+        vector<DueLoan> open = studentLoans(student->regNumber);
+        table.cell("\nBooks Issued (" + to_string(open.size()) + " of " + to_string(MAX_BOOKS_PER_STUDENT) + ")").endRow();
+        for (const auto &loan : open)
+        {
+            table.cell("  ").cell(loan.bookName, 30).cell(loan.isbn, 16).cell("due " + formatDate(loan.dueAt));
+            if (loan.daysLate > 0)
+                table.cell("  (" + to_string(loan.daysLate) + " days late)");
+            table.endRow();
+        }
+        table.flush(cout);
+    }
+
+    // Shown when a returned copy is set aside for the next student in the hold queue
+    static void printPickupNotice(const HoldNotice &notice)
+    {
+        cout << "\nThis copy is on hold. Keep it at the counter.\n";
+        cout << "============================================\n";
+        cout << "Pickup Notice\n";
+        cout << "--------------------------------------------\n";
+        cout << "Book Name: " << notice.bookName << "\nISBN: " << notice.isbn << "\n";
+        cout << "Reserved For: " << (notice.studentName.empty() ? "(unknown student)" : notice.studentName) << " ("
+             << notice.regNumber << ")\n";
+        if (!notice.email.empty())
+            cout << "Email: " << notice.email << "\n";
+        cout << "Collect By: " << formatDate(notice.pickupBy) << "\n";
+        cout << "--------------------------------------------\n";
+    }
+
+    static string formatDate(time_t when)
+    {
+        char text[32];
+        tm local = {};
+#ifdef _WIN32
+        localtime_s(&local, &when);
+#else
+        localtime_r(&when, &local);
+#endif
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &local);
+        return text;
+    }
+
+    // When this counter's branch has no copies of a title, lists the branches
+    // that do; false if none has any
+    bool showOtherBranches(const string &id)
+    {
+        vector<BranchCopies> where;
+        whereAvailable(id, where);
+        string list;
+        for (const auto &branch : where)
+            if (branch.copies > 0)
+                list += (list.empty() ? "" : ", ") + branch.branch + " (" + to_string(branch.copies) + ")";
+        if (list.empty())
+            return false;
+        cout << "\nNo copies of this book are on the shelf at this branch.\nAvailable at: " << list << "\n";
+        return true;
+    }
+
+    // Asked when a title has no copies on the shelf
+    void offerHold(const string &regNum, const string &id)
+    {
+        cout << "\nNo copies of this book are on the shelf.\nPlace a hold for this student? (1 = Yes, 0 = No): ";
+        if (getIntInput() != 1)
+            return;
+
+        size_t position = 0;
+        switch (placeHold(regNum, id, &position))
+        {
+        case Status::Ok:
+            cout << "\nHold placed. The student is number " << position << " in the queue for this book.\n";
+            break;
+        case Status::Duplicate:
+            cout << "\nThis student already has a hold on this book.\n";
+            break;
+        case Status::Available:
+            cout << "\nA copy is back on the shelf. Issue it instead.\n";
+            break;
+        default:
+            cout << "\nError: Could not place the hold.\n";
+        }
+    }
+
+    void cancelHold()
+    {
+        string id, regNum;
+        cout << "\nEnter ISBN: ";
+        cin >> id;
+        cout << "Enter student registration number: ";
+        cin >> regNum;
+        if (cancelHold(regNum, id) == Status::Ok)
+            cout << "\nThe hold has been cancelled.\n";
+        else
+            cout << "\nError: This student has no hold on this book.\n";
+    }
+
+    // Loans overdue now, most overdue first, then the ones due tomorrow
+    void showDueLoans()
+    {
+        const size_t LIMIT = 50;
+        time_t now = time(0);
+        tm day = {};
+#ifdef _WIN32
+        localtime_s(&day, &now);
+#else
+        localtime_r(&now, &day);
+#endif
+        day.tm_hour = day.tm_min = day.tm_sec = 0;
+        day.tm_mday++;
+        day.tm_isdst = -1;
+        time_t tomorrow = mktime(&day);
+        day.tm_mday++;
+        day.tm_isdst = -1;
+        time_t dayAfter = mktime(&day);
+
+        auto print = [&](const string &title, const vector<DueLoan> &rows, bool late)
+        {
+            TextTable table;
+            table.cell("\n===============================\n" + title + "\n===============================\n");
+            table.cell("Book Name", 30).cell("ISBN", 16).cell("Reg. Number", 14).cell("Due", 18);
+            table.cell(late ? "Days Late" : "").endRow();
+            table.cell("--------------------------------------------------------------------------------------------").endRow();
+            for (size_t i = 0; i < rows.size() && i < LIMIT; i++)
+            {
+                const DueLoan &loan = rows[i];
+                table.cell(loan.bookName, 30).cell(loan.isbn, 16).cell(loan.regNumber, 14).cell(formatDate(loan.dueAt), 18);
+                if (late)
+                    table.cell(loan.daysLate);
+                table.endRow();
+            }
+            if (rows.empty())
+                table.cell("None.").endRow();
+            else if (rows.size() > LIMIT)
+                table.cell("... and " + to_string(rows.size() - LIMIT) + " more").endRow();
+            table.flush(cout);
+        };
+        print("Overdue Loans", dueLoans(0, now, LIMIT + 1), true);
+        print("Due Tomorrow", dueLoans(tomorrow, dayAfter, LIMIT + 1), false);
+    }
+
+    void payFine()
+    {
+        string regNum;
+        cout << "\nEnter student registration number: ";
+        cin >> regNum;
+        long long owed = fineBalance(regNum);
+        if (owed == 0)
+        {
+            cout << "\nThis student has no outstanding fines.\n";
+            return;
+        }
+        cout << "Outstanding fines: Rs. " << owed << "\nEnter amount paid: ";
+        long long remaining = 0;
+        if (payFine(regNum, getIntInput(), &remaining) != Status::Ok)
+        {
+            cout << "\nError: The amount must be between 1 and " << owed << ".\n";
+            return;
+        }
+        cout << "\nPayment recorded. Remaining fines: Rs. " << remaining << "\n";
+    }
+
+    // Longest queues (the titles that need more copies), hold activity since
+    // startup, and the copies waiting at the counter to be collected
+    void showHoldQueues()
+    {
+        const size_t LIMIT = 20;
+        vector<HoldQueueInfo> queues = holdQueues(LIMIT);
+        time_t now = time(0);
+
+        TextTable table;
+        table.cell("\n===============================\nHold Queues (longest first)\n===============================\n");
+        table.cell("Book Name", 30).cell("ISBN", 16).cell("Waiting", 10).cell("Ready", 8).cell("Copies", 8);
+        table.cell("On Loan", 10).cell("Oldest (days)").endRow();
+        table.cell("--------------------------------------------------------------------------------------------").endRow();
+        for (const auto &queue : queues)
+        {
+            table.cell(queue.bookName, 30).cell(queue.isbn, 16).cell((long long)queue.waiting, 10);
+            table.cell((long long)queue.ready, 8).cell(queue.copies, 8).cell(queue.onLoan, 10);
+            table.cell((long long)(now - queue.oldestHold) / 86400).endRow();
+        }
+        if (queues.empty())
+            table.cell("No holds are waiting.").endRow();
+        table.flush(cout);
+
+        const HoldTable::Counters &counts = holdStats();
+        uint64_t allocated = counts.allocated.load();
+        cout << "\nSince startup: " << counts.placed.load() << " placed, " << allocated << " copies set aside, "
+             << counts.fulfilled.load() << " collected, " << counts.cancelled.load() << " cancelled, "
+             << counts.expired.load() << " expired\n";
+        if (allocated)
+            cout << "Average wait for a copy: " << fixed << setprecision(1)
+                 << counts.waitSeconds.load() / (double)allocated / 3600 << " hours\n"
+                 << defaultfloat;
+
+        vector<HoldNotice> pickups = pendingPickups();
+        if (pickups.empty())
+            return;
+        TextTable pending;
+        pending.cell("\n===============================\nAwaiting Pickup\n===============================\n");
+        pending.cell("Book Name", 30).cell("ISBN", 16).cell("Student", 25).cell("Reg. Number", 14).cell("Collect By").endRow();
+        pending.cell("--------------------------------------------------------------------------------------------").endRow();
+        for (const auto &pickup : pickups)
+        {
+            pending.cell(pickup.bookName, 30).cell(pickup.isbn, 16).cell(pickup.studentName, 25);
+            pending.cell(pickup.regNumber, 14).cell(formatDate(pickup.pickupBy)).endRow();
+        }
+        pending.flush(cout);
+    }
+
+    // Most borrowed and most utilized titles, most active borrowers, the last
+    // day hour by hour and the busiest hours of the week; offers to rebuild the
+    // figures from the whole circulation history
+    void showAnalytics()
+    {
+        const size_t LIMIT = 10;
+        CirculationReport report = circulationReport(LIMIT, 24);
+        cout << "\n===============================\nCirculation Analytics\n===============================\n"
+             << "Since " << formatDate(report.periodStart) << ": " << report.issues << " issues, " << report.returns
+             << " returns\n";
+
+        auto titleTable = [](const char *heading, const vector<TitleActivity> &titles)
+        {
+            TextTable table;
+            table.cell(string("\n") + heading + "\n");
+            table.cell("Book Name", 30).cell("ISBN", 16).cell("Issues", 8).cell("Copies", 8).cell("On Loan", 10);
+            table.cell("Utilization").endRow();
+            table.cell("--------------------------------------------------------------------------------------------").endRow();
+            for (const auto &title : titles)
+            {
+                table.cell(title.bookName, 30).cell(title.isbn, 16).cell((long long)title.issues, 8).cell(title.copies, 8);
+                table.cell(title.onLoan, 10).cell(to_string((int)(title.utilization * 100 + 0.5)) + "%").endRow();
+            }
+            if (titles.empty())
+                table.cell("No books have been issued in this period.").endRow();
+            table.flush(cout);
+        };
+        titleTable("Most Borrowed Titles", report.mostBorrowed);
+        titleTable("Most Utilized Titles (share of the period on loan)", report.mostUtilized);
+
+        TextTable borrowers;
+        borrowers.cell("\nMost Active Borrowers\n");
+        borrowers.cell("Student", 25).cell("Reg. Number", 14).cell("Issues").endRow();
+        borrowers.cell("--------------------------------------------------------").endRow();
+        for (const auto &borrower : report.mostActive)
+        {
+            string issues = to_string(borrower.issues);
+            if (borrower.error)
+                issues = to_string(borrower.issues - borrower.error) + "-" + issues;
+            borrowers.cell(borrower.studentName, 25).cell(borrower.regNumber, 14).cell(issues).endRow();
+        }
+        borrowers.flush(cout);
+
+        TextTable hourly;
+        hourly.cell("\nLast 24 Hours\n");
+        hourly.cell("Hour", 20).cell("Issues", 10).cell("Returns").endRow();
+        hourly.cell("--------------------------------------").endRow();
+        for (const auto &hour : report.recentHours)
+            hourly.cell(formatDate(hour.start), 20).cell((long long)hour.issues, 10).cell((long long)hour.returns).endRow();
+        hourly.flush(cout);
+
+        static const char *DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        vector<int> busiest(Analytics::WEEK_HOURS);
+        for (int hour = 0; hour < Analytics::WEEK_HOURS; hour++)
+            busiest[hour] = hour;
+        partial_sort(busiest.begin(), busiest.begin() + 5, busiest.end(), [&](int a, int b)
+                     { return report.issuesByWeekHour[a] > report.issuesByWeekHour[b]; });
+        cout << "\nBusiest hours of the week:";
+        for (int i = 0; i < 5 && report.issuesByWeekHour[busiest[i]]; i++)
+            cout << (i ? ", " : " ") << DAYS[busiest[i] / 24] << " " << setw(2) << setfill('0') << busiest[i] % 24
+                 << ":00 (" << report.issuesByWeekHour[busiest[i]] << ")" << setfill(' ');
+        cout << "\n\nRebuild these figures from the whole circulation history? (1 = Yes, 0 = No): ";
+        if (getIntInput() != 1)
+            return;
+        Analytics::RebuildStats stats = rebuildAnalytics();
+        cout << "\nRead " << stats.events << " issues and returns from " << stats.files << " files ("
+             << stats.bytes / (1024 * 1024) << " MB) in " << fixed << setprecision(2) << stats.seconds << " s on "
+             << stats.threads << (stats.threads == 1 ? " thread.\n" : " threads.\n")
+             << defaultfloat;
+    }
+
+    void showAllStudents()
+    {
+        if (studentCount() == 0)
+        {
+            cout << "\nNo students have been registered yet.\n";
+            return;
+        }
+
+        cout << "\nSort by:\n1. Registration order\n2. Name\n3. Registration number\nEnter choice: ";
+        int sortChoice = getIntInput();
+        StudentOrder order = sortChoice >= 2 && sortChoice <= 3 ? (StudentOrder)(sortChoice - 1) : StudentOrder::Catalog;
+
+        TextTable table;
+        table.cell("\n===============================\nList of All Students\n===============================\n");
+        table.cell("First Name", 25).cell("Last Name", 25).cell("Reg. Number", 20).cell("Phone", 15).cell("Email").endRow();
+        table.cell("---------------------------------------------------------------").endRow();
+
+        vector<Student> page;
+        string cursor;
+        while (true)
+        {
+            if (listStudents(order, cursor, PAGE_SIZE + 1, page) != Status::Ok)
+            {
+                cout << "\nThe student list changed while listing. Please start again.\n";
+                return;
+            }
+            bool more = page.size() > PAGE_SIZE;
+            if (more)
+                page.pop_back();
+
+            for (const auto &student : page)
+                table.cell(student.firstName, 25).cell(student.lastName, 25).cell(student.regNumber, 20).cell(student.phone, 15).cell(student.email).endRow();
+            table.flush(cout);
+
+            if (!more || !askNextPage())
+                return;
+            cursor = page.back().regNumber;
+        }
+    }
+
+    // Latency per operation since startup, time spent saving each file, and
+    // an optional dump of everything to metrics.prom in the data directory
+    void showMetrics()
+    {
+        auto micros = [](uint64_t nanos)
+        {
+            ostringstream text;
+            text << fixed << setprecision(1) << nanos / 1000.0;
+            return text.str();
+        };
+
+        TextTable table;
+        table.cell("\n===============================\nOperation Metrics (latency in microseconds)\n===============================\n");
+        table.cell("Operation", 16).cell("Calls", 10).cell("Errors", 10).cell("Mean", 12).cell("p50", 12).cell("p99", 12);
+        table.cell("p99.9", 12).cell("Max").endRow();
+        table.cell("------------------------------------------------------------------------------------------------").endRow();
+        for (int i = 0; i < (int)Op::Count; i++)
+        {
+            const Metrics::Operation &op = metrics.operation((Op)i);
+            uint64_t calls = op.latency.count();
+            table.cell(opName((Op)i), 16).cell((long long)calls, 10).cell((long long)op.errors.load(), 10);
+            table.cell(micros(calls ? op.latency.sum() / calls : 0), 12).cell(micros(op.latency.quantile(0.5)), 12);
+            table.cell(micros(op.latency.quantile(0.99)), 12).cell(micros(op.latency.quantile(0.999)), 12);
+            table.cell(micros(op.latency.max())).endRow();
+        }
+
+        table.cell("\n===============================\nFile Saves\n===============================\n");
+        table.cell("File", 20).cell("Saves", 10).cell("Bytes", 16).cell("Time (ms)").endRow();
+        table.cell("----------------------------------------------------------").endRow();
+        for (int i = 0; i < (int)SaveFile::Count; i++)
+        {
+            const Metrics::Save &save = metrics.save((SaveFile)i);
+            table.cell(saveFileName((SaveFile)i), 20).cell((long long)save.count.load(), 10);
+            table.cell((long long)save.bytes.load(), 16).cell(micros(save.nanos.load() / 1000)).endRow();
+        }
+        table.cell("Journal", 20).cell("", 10).cell((long long)journal.bytesAppended(), 16).endRow();
+        if (const PagedFile *paged = strings.pagedFile())
+        {
+            uint64_t lookups = paged->hits() + paged->misses();
+            ostringstream hitRate;
+            hitRate << fixed << setprecision(1) << (lookups ? 100.0 * paged->hits() / lookups : 100.0) << "%";
+            table.cell("\n===============================\nPage Cache (record text)\n===============================\n");
+            table.cell("Budget: " + to_string(paged->budget() / 1024) + " KB for " + to_string(paged->size() / 1024) +
+                       " KB of text").endRow();
+            table.cell("Lookups: " + to_string(lookups) + ", hit rate " + hitRate.str() + ", evictions " +
+                       to_string(paged->evictions())).endRow();
+        }
+        table.flush(cout);
+
+        cout << "\n1. Write metrics.prom (Prometheus format)\n2. Back\nEnter choice: ";
+        if (getIntInput() != 1)
+            return;
+        if (writeMetrics(dataPath("metrics.prom")))
+            cout << "\nMetrics written to " << dataPath("metrics.prom") << "\n";
+        else
+            cout << "\nError: Could not write " << dataPath("metrics.prom") << "\n";
+    }
+
+    // Logs in at the console for the Librarian or Counter menu. Librarian
+    // accounts may also work a counter. Asks again after a wrong password
+    // until the throttle refuses (see Accounts.h).
+    bool authenticate(string role)
+    {
+        string user, password;
+        while (true)
+        {
+            cout << "\nEnter username: ";
+            cin >> user;
+            cout << "Enter password: ";
+            if (!(cin >> password))
+                return false; // Input closed
+
+            LoginInfo info;
+            switch (login(user, password, "console", &info))
+            {
+            case Status::Ok:
+                if (role == "Librarian" && info.role != AccountRole::Librarian)
+                {
+                    logout(info.token);
+                    cout << "\nThis is a counter account; it cannot open the Librarian menu.\n";
+                    return false;
+                }
+                consoleSession = info.token;
+                cout << "\nWelcome " << user << "!\n";
+                return true;
+            case Status::Throttled:
+                cout << "\nToo many failed attempts. Try again in " << info.retryAfter << " seconds.\n";
+                return false;
+            default:
+                cout << "\nIncorrect username or password!\n";
+            }
+        }
+    }
+
+    // Ends the console session opened by authenticate
+    void logoutConsole()
+    {
+        if (!consoleSession.empty())
+            logout(consoleSession);
+        consoleSession.clear();
+        cout << "\nLogged out.\n";
+    }
+
+    void manageAccounts()
+    {
+        int choice;
+        do
+        {
+            cout << "\n1. List Accounts\n2. Add Account\n3. Change Password\n4. Back\nEnter choice: ";
+            choice = getIntInput();
+            if (choice == 1)
+            {
+                TextTable table;
+                table.cell("\n===============================\nAccounts\n===============================\n");
+                table.cell("Username", 34).cell("Role").endRow();
+                table.cell("----------------------------------------").endRow();
+                for (const auto &account : accountList())
+                    table.cell(account.first, 34).cell(roleName(account.second)).endRow();
+                table.flush(cout);
+            }
+            else if (choice == 2)
+            {
+                string user, password;
+                cout << "\nEnter username (letters, digits, '.', '_' or '-', up to 32): ";
+                cin >> user;
+                cout << "1. Librarian\n2. Counter\nEnter role: ";
+                AccountRole role = getIntInput() == 1 ? AccountRole::Librarian : AccountRole::Counter;
+                cout << "Enter password (6 to 64 characters, no spaces): ";
+                cin >> password;
+                switch (addAccount(user, role, password))
+                {
+                case Status::Ok:
+                    cout << "\nThe account has been added.\n";
+                    break;
+                case Status::Duplicate:
+                    cout << "\nAn account with this username already exists.\n";
+                    break;
+                default:
+                    cout << "\nInvalid username or password.\n";
+                }
+            }
+            else if (choice == 3)
+            {
+                string user, password;
+                cout << "\nEnter username: ";
+                cin >> user;
+                cout << "Enter new password (6 to 64 characters, no spaces): ";
+                cin >> password;
+                switch (setPassword(user, password))
+                {
+                case Status::Ok:
+                    cout << "\nThe password has been changed and the account's sessions ended.\n";
+                    break;
+                case Status::NotFound:
+                    cout << "\nNo account with this username.\n";
+                    break;
+                default:
+                    cout << "\nInvalid password.\n";
+                }
+            }
+            else if (choice != 4)
+                cout << "Invalid option! Please try again.\n";
+        } while (choice != 4);
+    }
+
+    // Queued to the background log writer (see AuditLog.h); it only waits, briefly, if the writer is a full ring behind
+    void logLoginAttempt(const string &user, const string &terminal, Status outcome)
+    {
+        loginLog.write("User: " + user + ", Terminal: " + terminal + ", Success: " +
+                       (outcome == Status::Ok ? "Yes" : outcome == Status::Throttled ? "No (throttled)" : "No"));
+    }
+
+    // Function to safely read an integer input
+    int getIntInput()
+    {
+        int choice;
+        while (true)
+        {
+            cin >> choice;
+            if (cin.fail())
+            {
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                cout << "Invalid input! Please enter a valid number: ";
+            }
+            else
+            {
+                break;
+            }
+        }
+        return choice;
+    }
+};
+
+#endif
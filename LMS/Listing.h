@@ -0,0 +1,159 @@
+// Listings
+// TextTable formats rows into one reusable buffer with fixed-width columns
+// and writes it out in a single call, instead of a setw chain and a flush per row.
+// SortedView caches a sort order of the catalog so paging through it costs
+// O(page size); the order is rebuilt only after the data it depends on changed.
+
+#ifndef LMS_LISTING_H
+#define LMS_LISTING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class BookOrder
+{
+    Catalog, // Order the books are stored in
+    Title,
+    Author,  // Then by title
+    Copies   // Most copies on the shelf first, then by title
+};
+
+enum class StudentOrder
+{
+    Catalog,     // Order of registration
+    Name,        // Last name, then first name
+    Registration // Registration number
+};
+
+// Case-insensitive comparison of names and titles: <0, 0 or >0 like strcmp
+inline int compareNoCase(std::string_view a, std::string_view b)
+{
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; i++)
+    {
+        int x = (unsigned char)a[i], y = (unsigned char)b[i];
+        if (x >= 'A' && x <= 'Z')
+            x += 'a' - 'A';
+        if (y >= 'A' && y <= 'Z')
+            y += 'a' - 'A';
+        if (x != y)
+            return x - y;
+    }
+    return a.size() < b.size() ? -1 : a.size() > b.size();
+}
+
+class TextTable
+{
+private:
+    std::string buffer;
+
+public:
+    TextTable()
+    {
+        buffer.reserve(64 * 1024);
+    }
+
+    // Appends text padded to width; longer text is kept whole, as setw does
+    TextTable &cell(const std::string &text, size_t width = 0)
+    {
+        buffer += text;
+        if (text.size() < width)
+            buffer.append(width - text.size(), ' ');
+        return *this;
+    }
+
+    TextTable &cell(long long value, size_t width = 0)
+    {
+        return cell(std::to_string(value), width);
+    }
+
+    TextTable &endRow()
+    {
+        buffer += '\n';
+        return *this;
+    }
+
+    // Writes everything formatted so far in one call and empties the buffer
+    void flush(std::ostream &out)
+    {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+};
+
+// A cached permutation of record positions, valid for one data version
+class SortedView
+{
+private:
+    std::vector<size_t> order;
+    uint64_t builtFor = 0;
+    bool built = false;
+
+public:
+    // Returns the positions 0..count-1 sorted with less, re-sorting only if
+    // version differs from the one the cached order was built for
+    template <class Less>
+    const std::vector<size_t> &get(size_t count, uint64_t version, Less less)
+    {
+        if (!built || builtFor != version || order.size() != count)
+        {
+            order.resize(count);
+            for (size_t i = 0; i < count; i++)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), less);
+            builtFor = version;
+            built = true;
+        }
+        return order;
+    }
+
+    // Like get, but reorders base (already sorted by the secondary keys) by
+    // descending key(position) while keeping base's order among equal keys.
+    // Small key ranges are bucketed in O(n) instead of sorted.
+    template <class Key>
+    const std::vector<size_t> &deriveDescending(const std::vector<size_t> &base, uint64_t version, Key key)
+    {
+        if (built && builtFor == version && order.size() == base.size())
+            return order;
+
+        long long low = 0, high = 0;
+        for (size_t i = 0; i < base.size(); i++)
+        {
+            long long k = key(base[i]);
+            low = i == 0 ? k : std::min(low, k);
+            high = i == 0 ? k : std::max(high, k);
+        }
+        order.resize(base.size());
+        if (high - low < 65536)
+        {
+            std::vector<size_t> start(high - low + 2, 0); // Bucket of key k holds index high - k
+            for (size_t pos : base)
+                start[high - key(pos) + 1]++;
+            for (size_t b = 1; b < start.size(); b++)
+                start[b] += start[b - 1];
+            for (size_t pos : base)
+                order[start[high - key(pos)]++] = pos;
+        }
+        else
+        {
+            order = base;
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                             { return key(a) > key(b); });
+        }
+        builtFor = version;
+        built = true;
+        return order;
+    }
+
+    void invalidate()
+    {
+        built = false;
+    }
+};
+
+#endif
@@ -0,0 +1,215 @@
+// Loan Table
+// In-memory view of every book currently issued, indexed both by student
+// (registration number) and by book (ISBN) so issue, return and the 3-book
+// limit check never touch issued_books.txt.
+// Keys are the packed integer forms of the registration number and ISBN.
+//
+// Both indexes are split into SHARDS shards, chosen by studentShard(reg) and
+// bookShard(isbn). The table does no locking itself: a caller that holds a lock
+// per student shard and per book shard may modify loans of different students
+// and books from several threads at once.
+//
+// Every loan has a due date, and a third index orders loans by it: per student
+// shard, a sorted map from hour bucket to the loans due in that hour. "What is
+// overdue" and "what falls due tomorrow" walk only the buckets in that range,
+// and a return removes its entry from a bucket of a few dozen loans.
+
+#ifndef LMS_LOANS_H
+#define LMS_LOANS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+class LoanTable
+{
+public:
+    struct Loan
+    {
+        uint64_t isbn;
+        time_t issuedAt;
+        time_t dueAt;
+    };
+
+    // Width of a due-date bucket
+    static const time_t DUE_BUCKET_SECONDS = 3600;
+
+    static const size_t SHARDS = 64;
+
+    // Fibonacci hashing: the top 6 bits of the product pick one of the 64 shards
+    static size_t studentShard(uint32_t reg)
+    {
+        return (uint32_t)(reg * 2654435761u) >> 26;
+    }
+
+    static size_t bookShard(uint64_t isbn)
+    {
+        return (isbn * 0x9E3779B97F4A7C15ull) >> 58;
+    }
+
+private:
+    typedef std::unordered_map<uint32_t, std::vector<Loan>> StudentMap;
+    typedef std::unordered_map<uint64_t, std::unordered_set<uint32_t>> BookMap;
+
+    struct DueEntry
+    {
+        uint64_t isbn;
+        time_t dueAt;
+        uint32_t reg;
+    };
+    typedef std::map<time_t, std::vector<DueEntry>> DueMap; // Bucket -> loans due in it
+
+    // A student holds at most a handful of loans, so a small vector beats a set here
+    StudentMap byStudentShards[SHARDS];
+    BookMap byBookShards[SHARDS];
+    DueMap byDueShards[SHARDS]; // By studentShard, like byStudentShards
+    std::atomic<size_t> total{0};
+
+    static time_t dueBucket(time_t dueAt)
+    {
+        return dueAt >= 0 ? dueAt / DUE_BUCKET_SECONDS : -1;
+    }
+
+    void removeDue(uint32_t reg, uint64_t isbn, time_t dueAt)
+    {
+        DueMap &due = byDueShards[studentShard(reg)];
+        auto bucket = due.find(dueBucket(dueAt));
+        if (bucket == due.end())
+            return;
+        auto &entries = bucket->second;
+        for (size_t i = 0; i < entries.size(); i++)
+            if (entries[i].reg == reg && entries[i].isbn == isbn)
+            {
+                entries[i] = entries.back();
+                entries.pop_back();
+                break;
+            }
+        if (entries.empty())
+            due.erase(bucket);
+    }
+
+    StudentMap &byStudent(uint32_t reg) { return byStudentShards[studentShard(reg)]; }
+    const StudentMap &byStudent(uint32_t reg) const { return byStudentShards[studentShard(reg)]; }
+    BookMap &byBook(uint64_t isbn) { return byBookShards[bookShard(isbn)]; }
+    const BookMap &byBook(uint64_t isbn) const { return byBookShards[bookShard(isbn)]; }
+
+public:
+    size_t size() const
+    {
+        return total;
+    }
+
+    // Number of books the student currently has issued
+    int count(uint32_t reg) const
+    {
+        auto it = byStudent(reg).find(reg);
+        return it == byStudent(reg).end() ? 0 : (int)it->second.size();
+    }
+
+    bool has(uint32_t reg, uint64_t isbn) const
+    {
+        auto it = byStudent(reg).find(reg);
+        if (it == byStudent(reg).end())
+            return false;
+        for (const auto &loan : it->second)
+            if (loan.isbn == isbn)
+                return true;
+        return false;
+    }
+
+    // Number of copies of a book currently out on loan
+    size_t borrowers(uint64_t isbn) const
+    {
+        auto it = byBook(isbn).find(isbn);
+        return it == byBook(isbn).end() ? 0 : it->second.size();
+    }
+
+    // Records a new loan; returns false if the student already has this book
+    bool add(uint32_t reg, uint64_t isbn, time_t issuedAt, time_t dueAt)
+    {
+        if (has(reg, isbn))
+            return false;
+        byStudent(reg)[reg].push_back({isbn, issuedAt, dueAt});
+        byBook(isbn)[isbn].insert(reg);
+        byDueShards[studentShard(reg)][dueBucket(dueAt)].push_back({isbn, dueAt, reg});
+        total++;
+        return true;
+    }
+
+    // The loan of isbn to reg, or nullptr if there is none
+    const Loan *find(uint32_t reg, uint64_t isbn) const
+    {
+        auto it = byStudent(reg).find(reg);
+        if (it == byStudent(reg).end())
+            return nullptr;
+        for (const auto &loan : it->second)
+            if (loan.isbn == isbn)
+                return &loan;
+        return nullptr;
+    }
+
+    // Closes a loan; returns false if there was no such loan
+    bool remove(uint32_t reg, uint64_t isbn)
+    {
+        auto it = byStudent(reg).find(reg);
+        if (it == byStudent(reg).end())
+            return false;
+
+        auto &loans = it->second;
+        for (size_t i = 0; i < loans.size(); i++)
+        {
+            if (loans[i].isbn != isbn)
+                continue;
+
+            removeDue(reg, isbn, loans[i].dueAt);
+            loans[i] = loans.back();
+            loans.pop_back();
+            if (loans.empty())
+                byStudent(reg).erase(it);
+
+            auto bookIt = byBook(isbn).find(isbn);
+            bookIt->second.erase(reg);
+            if (bookIt->second.empty())
+                byBook(isbn).erase(bookIt);
+
+            total--;
+            return true;
+        }
+        return false;
+    }
+
+    const std::vector<Loan> *loansOf(uint32_t reg) const
+    {
+        auto it = byStudent(reg).find(reg);
+        return it == byStudent(reg).end() ? nullptr : &it->second;
+    }
+
+    // Calls fn(reg, loan) for every open loan
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (const auto &shard : byStudentShards)
+            for (const auto &entry : shard)
+                for (const auto &loan : entry.second)
+                    fn(entry.first, loan);
+    }
+
+    // Calls fn(reg, isbn, dueAt) for every loan due in [from, to), in no
+    // particular order. Needs every student shard, so callers exclude writers.
+    template <typename Fn>
+    void forEachDue(time_t from, time_t to, Fn fn) const
+    {
+        for (const auto &due : byDueShards)
+            for (auto bucket = due.lower_bound(dueBucket(from)); bucket != due.end() && bucket->first <= dueBucket(to - 1);
+                 ++bucket)
+                for (const auto &entry : bucket->second)
+                    if (entry.dueAt >= from && entry.dueAt < to)
+                        fn(entry.reg, entry.isbn, entry.dueAt);
+    }
+};
+
+#endif
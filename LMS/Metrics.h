@@ -0,0 +1,313 @@
+// Metrics
+// Always-on counters and latency histograms for the LMS operations, plus the
+// bytes and time spent saving each data file. Recording is a few relaxed
+// atomic additions (no locks, no allocation), so it stays enabled in production.
+//
+// LatencyHistogram is HDR-style: values (nanoseconds) fall into log-linear
+// buckets, 16 per power of two, so every bucket is within ~6% of the values in
+// it from 32 ns up to hours, in a fixed 976-slot array.
+//
+// toPrometheus() renders everything in the Prometheus text exposition format
+// (lms_operations_total, lms_operation_duration_seconds histogram,
+// lms_save_bytes_total, ...).
+
+#ifndef LMS_METRICS_H
+#define LMS_METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKETS = 16; // Per power of two
+    static const int BUCKETS = 976;     // Covers every uint64_t
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sumNanos{0};
+    std::atomic<uint64_t> maxNanos{0};
+
+public:
+    static int bucketOf(uint64_t nanos)
+    {
+        if (nanos < 2 * SUB_BUCKETS)
+            return (int)nanos;
+        int msb = 63 - __builtin_clzll(nanos);
+        int shift = msb - 4;
+        return shift * SUB_BUCKETS + (int)(nanos >> shift);
+    }
+
+    // Largest value that falls into bucket
+    static uint64_t bucketUpperBound(int bucket)
+    {
+        if (bucket < 2 * SUB_BUCKETS)
+            return (uint64_t)bucket;
+        int shift = bucket / SUB_BUCKETS - 1;
+        uint64_t sub = (uint64_t)(bucket % SUB_BUCKETS + SUB_BUCKETS);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t nanos)
+    {
+        counts[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sumNanos.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t seen = maxNanos.load(std::memory_order_relaxed);
+        while (nanos > seen && !maxNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uint64_t count() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    uint64_t sum() const
+    {
+        return sumNanos.load(std::memory_order_relaxed);
+    }
+
+    uint64_t max() const
+    {
+        return maxNanos.load(std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket holding the q-quantile (0 <= q <= 1)
+    uint64_t quantile(double q) const
+    {
+        uint64_t n = count();
+        if (n == 0)
+            return 0;
+        uint64_t rank = (uint64_t)(q * (n - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++)
+        {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(bucketUpperBound(b), max());
+        }
+        return max();
+    }
+
+    // Number of values <= nanos (exact at bucket boundaries)
+    uint64_t countAtMost(uint64_t nanos) const
+    {
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS && bucketUpperBound(b) <= nanos; b++)
+            seen += counts[b].load(std::memory_order_relaxed);
+        return seen;
+    }
+};
+
+enum class Op
+{
+    Issue,
+    Return,
+    AddBook,
+    DeleteBook,
+    UpdateBook,
+    AddStudent,
+    Search,
+    ListBooks,
+    ListStudents,
+    Checkpoint,
+    PlaceHold,
+    CancelHold,
+    PayFine,
+    FineSweep,
+    RebuildAnalytics,
+    Transfer,
+    Restore,
+    FuzzySearch,
+    Login,
+    Count
+};
+
+inline const char *opName(Op op)
+{
+    static const char *names[] = {"issue",       "return", "add_book",   "delete_book",   "update_book",
+                                  "add_student", "search", "list_books", "list_students", "checkpoint",
+                                  "place_hold",  "cancel_hold", "pay_fine",   "fine_sweep",    "rebuild_analytics",
+                                  "transfer",    "restore",     "fuzzy_search", "login"};
+    return names[(int)op];
+}
+
+// Data files written by a checkpoint (accounts.txt whenever an account changes)
+enum class SaveFile
+{
+    Books,
+    Students,
+    Loans,
+    Holds,
+    Fines,
+    Snapshot,
+    Stock,
+    History,
+    Accounts,
+    Throttle,
+    Count
+};
+
+inline const char *saveFileName(SaveFile file)
+{
+    static const char *names[] = {"books.txt", "students.txt", "issued_books.txt", "holds.txt", "fines.txt", "lms.snap",
+                                  "stock_*.txt", "history/snapshot-*.snap", "accounts.txt",
+                                  "throttle.txt"};
+    return names[(int)file];
+}
+
+class Metrics
+{
+public:
+    struct Operation
+    {
+        std::atomic<uint64_t> errors{0}; // Calls that did not return Status::Ok
+        LatencyHistogram latency;       // Every call
+    };
+
+    struct Save
+    {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> nanos{0};
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    Operation operations[(int)Op::Count];
+    Save saves[(int)SaveFile::Count];
+
+public:
+    static uint64_t nanosSince(Clock::time_point start)
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    void recordOperation(Op op, Clock::time_point start, bool ok = true)
+    {
+        Operation &o = operations[(int)op];
+        o.latency.record(nanosSince(start));
+        if (!ok)
+            o.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void recordSave(SaveFile file, Clock::time_point start, uint64_t bytes)
+    {
+        Save &s = saves[(int)file];
+        s.nanos.fetch_add(nanosSince(start), std::memory_order_relaxed);
+        s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        s.count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const Operation &operation(Op op) const
+    {
+        return operations[(int)op];
+    }
+
+    const Save &save(SaveFile file) const
+    {
+        return saves[(int)file];
+    }
+
+    // Prometheus text format. extra is appended as is (gauges and counters
+    // owned by other components, already formatted).
+    std::string toPrometheus(const std::string &extra = "") const
+    {
+        // Histogram bucket bounds in seconds (1-2.5-5 steps from 1 us to 10 s)
+        static const double bounds[] = {1e-6,   2.5e-6, 5e-6,   1e-5,   2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3,
+                                        5e-3,   1e-2,   2.5e-2, 5e-2,   0.1,    0.25, 0.5,  1,      2.5,  5,    10};
+        std::string out;
+        char line[256];
+        auto add = [&](int n)
+        { out.append(line, n); };
+
+        out += "# HELP lms_operations_total LMS API calls by operation and outcome.\n"
+               "# TYPE lms_operations_total counter\n";
+        for (int i = 0; i < (int)Op::Count; i++)
+        {
+            const Operation &o = operations[i];
+            uint64_t errors = o.errors.load(std::memory_order_relaxed);
+            add(snprintf(line, sizeof(line), "lms_operations_total{op=\"%s\",outcome=\"ok\"} %llu\n", opName((Op)i),
+                         (unsigned long long)(o.latency.count() - errors)));
+            add(snprintf(line, sizeof(line), "lms_operations_total{op=\"%s\",outcome=\"error\"} %llu\n",
+                         opName((Op)i), (unsigned long long)errors));
+        }
+
+        out += "# HELP lms_operation_duration_seconds Latency of LMS API calls.\n"
+               "# TYPE lms_operation_duration_seconds histogram\n";
+        for (int i = 0; i < (int)Op::Count; i++)
+        {
+            const LatencyHistogram &h = operations[i].latency;
+            for (double bound : bounds)
+                add(snprintf(line, sizeof(line), "lms_operation_duration_seconds_bucket{op=\"%s\",le=\"%g\"} %llu\n",
+                             opName((Op)i), bound, (unsigned long long)h.countAtMost((uint64_t)(bound * 1e9))));
+            add(snprintf(line, sizeof(line), "lms_operation_duration_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu\n",
+                         opName((Op)i), (unsigned long long)h.count()));
+            add(snprintf(line, sizeof(line), "lms_operation_duration_seconds_sum{op=\"%s\"} %.9f\n", opName((Op)i),
+                         h.sum() / 1e9));
+            add(snprintf(line, sizeof(line), "lms_operation_duration_seconds_count{op=\"%s\"} %llu\n", opName((Op)i),
+                         (unsigned long long)h.count()));
+        }
+
+        const char *saveMetrics[][3] = {
+            {"lms_saves_total", "counter", "Times each data file was written."},
+            {"lms_save_bytes_total", "counter", "Bytes written to each data file."},
+            {"lms_save_seconds_total", "counter", "Time spent writing each data file."}};
+        for (int m = 0; m < 3; m++)
+        {
+            add(snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", saveMetrics[m][0], saveMetrics[m][2],
+                         saveMetrics[m][0], saveMetrics[m][1]));
+            for (int f = 0; f < (int)SaveFile::Count; f++)
+            {
+                const Save &s = saves[f];
+                if (m == 2)
+                    add(snprintf(line, sizeof(line), "%s{file=\"%s\"} %.9f\n", saveMetrics[m][0],
+                                 saveFileName((SaveFile)f), s.nanos.load(std::memory_order_relaxed) / 1e9));
+                else
+                    add(snprintf(line, sizeof(line), "%s{file=\"%s\"} %llu\n", saveMetrics[m][0],
+                                 saveFileName((SaveFile)f),
+                                 (unsigned long long)(m == 0 ? s.count : s.bytes).load(std::memory_order_relaxed)));
+            }
+        }
+        return out + extra;
+    }
+};
+
+// Times one call from construction to destruction. The call counts as an
+// error unless succeeded() is called, so early error returns need no extra code.
+class OperationTimer
+{
+private:
+    Metrics &metrics;
+    Op op;
+    Metrics::Clock::time_point start;
+    bool ok = false;
+
+public:
+    OperationTimer(Metrics &m, Op operation) : metrics(m), op(operation), start(Metrics::Clock::now())
+    {
+    }
+
+    OperationTimer(const OperationTimer &) = delete;
+    OperationTimer &operator=(const OperationTimer &) = delete;
+
+    ~OperationTimer()
+    {
+        metrics.recordOperation(op, start, ok);
+    }
+
+    void succeeded()
+    {
+        ok = true;
+    }
+};
+
+#endif
@@ -0,0 +1,269 @@
+// Paged Record Text
+// Where StringPool keeps the text of books and students (titles, authors,
+// names, emails) when it should not all stay in memory. The text is appended
+// to a scratch file in PAGE_BYTES pages, and reads go through an LRU cache
+// holding at most budget bytes of pages; only the page being filled is always
+// resident. The indexes and the fixed-width columns (ISBNs, copies, ...) stay
+// in memory, so issue and return never touch the file; titles and names are
+// paged in for lookups, listings and checkpoints.
+//
+// The file is unlinked as soon as it is created: the data files stay the
+// durable copy, and the text is paged in again from them at the next start.
+// Reads may come from several threads at once (under the shared catalog
+// lock), so the cache has a mutex of its own.
+
+#ifndef LMS_PAGECACHE_H
+#define LMS_PAGECACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+class PagedFile
+{
+public:
+    static const size_t PAGE_BYTES = 4096;
+
+private:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct Frame
+    {
+        uint64_t page;
+        uint32_t newer, older;
+        std::vector<char> data;
+    };
+
+    int fd = -1;
+    uint64_t length = 0;            // Bytes appended; the page being filled is length / PAGE_BYTES
+    std::vector<char> tail;         // That page's bytes so far
+    size_t maxFrames = 1;
+
+    mutable std::mutex lock;
+    mutable std::vector<Frame> frames;
+    mutable std::unordered_map<uint64_t, uint32_t> cached; // Page -> frame
+    mutable uint32_t newest = NONE, oldest = NONE;
+    mutable std::atomic<uint64_t> hitCount{0}, missCount{0}, evictionCount{0}, errorCount{0};
+
+    void detach(uint32_t f) const
+    {
+        Frame &frame = frames[f];
+        (frame.newer == NONE ? newest : frames[frame.newer].older) = frame.older;
+        (frame.older == NONE ? oldest : frames[frame.older].newer) = frame.newer;
+    }
+
+    void pushNewest(uint32_t f) const
+    {
+        frames[f].newer = NONE;
+        frames[f].older = newest;
+        (newest == NONE ? oldest : frames[newest].newer) = f;
+        newest = f;
+    }
+
+    // A frame for page: a new one while under budget, else the least
+    // recently used one. The caller fills it. Caller holds lock.
+    uint32_t claimFrame(uint64_t page) const
+    {
+        uint32_t f;
+        if (frames.size() < maxFrames)
+        {
+            f = (uint32_t)frames.size();
+            frames.push_back({page, NONE, NONE, std::vector<char>(PAGE_BYTES)});
+        }
+        else
+        {
+            f = oldest;
+            detach(f);
+            cached.erase(frames[f].page);
+            frames[f].page = page;
+            evictionCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        cached[page] = f;
+        pushNewest(f);
+        return f;
+    }
+
+    // The bytes of a full page, read in if it is not cached. Caller holds lock.
+    const char *page(uint64_t number) const
+    {
+        auto it = cached.find(number);
+        if (it != cached.end())
+        {
+            hitCount.fetch_add(1, std::memory_order_relaxed);
+            if (it->second != newest)
+            {
+                detach(it->second);
+                pushNewest(it->second);
+            }
+            return frames[it->second].data.data();
+        }
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        char *data = frames[claimFrame(number)].data.data();
+        size_t done = 0;
+#ifndef _WIN32
+        while (done < PAGE_BYTES)
+        {
+            ssize_t got = ::pread(fd, data + done, PAGE_BYTES - done, (off_t)(number * PAGE_BYTES + done));
+            if (got <= 0)
+                break;
+            done += (size_t)got;
+        }
+#endif
+        if (done < PAGE_BYTES)
+        {
+            errorCount.fetch_add(1, std::memory_order_relaxed);
+            memset(data + done, 0, PAGE_BYTES - done);
+        }
+        return data;
+    }
+
+    // Writes out the full tail page and keeps it cached, as it was just used
+    void flushTail()
+    {
+        uint64_t number = length / PAGE_BYTES - 1;
+        size_t done = 0;
+#ifndef _WIN32
+        while (done < PAGE_BYTES)
+        {
+            ssize_t put = ::pwrite(fd, tail.data() + done, PAGE_BYTES - done, (off_t)(number * PAGE_BYTES + done));
+            if (put <= 0)
+                break;
+            done += (size_t)put;
+        }
+#endif
+        if (done < PAGE_BYTES)
+            errorCount.fetch_add(1, std::memory_order_relaxed);
+        memcpy(frames[claimFrame(number)].data.data(), tail.data(), PAGE_BYTES);
+    }
+
+public:
+    PagedFile() = default;
+    PagedFile(const PagedFile &) = delete;
+    PagedFile &operator=(const PagedFile &) = delete;
+
+    ~PagedFile()
+    {
+#ifndef _WIN32
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    }
+
+    // Creates the scratch file at path with a cache of budgetBytes (at least
+    // one page). Returns false if it cannot be created (or on Windows).
+    bool open(const std::string &path, size_t budgetBytes)
+    {
+#ifdef _WIN32
+        (void)path;
+        (void)budgetBytes;
+        return false;
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+            return false;
+        ::unlink(path.c_str());
+        maxFrames = std::max<size_t>(1, budgetBytes / PAGE_BYTES);
+        tail.resize(PAGE_BYTES);
+        return true;
+#endif
+    }
+
+    // Appends text; it is read back at offset size() as it was before the call
+    void append(std::string_view text)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        while (!text.empty())
+        {
+            size_t used = length % PAGE_BYTES;
+            size_t n = std::min(text.size(), PAGE_BYTES - used);
+            memcpy(tail.data() + used, text.data(), n);
+            length += n;
+            text.remove_prefix(n);
+            if (length % PAGE_BYTES == 0)
+                flushTail();
+        }
+    }
+
+    // Copies size bytes at offset into out
+    void read(uint64_t offset, size_t size, std::string &out) const
+    {
+        out.resize(size);
+        std::lock_guard<std::mutex> guard(lock);
+        size_t done = 0;
+        while (done < size)
+        {
+            uint64_t at = offset + done;
+            uint64_t number = at / PAGE_BYTES;
+            size_t within = at % PAGE_BYTES;
+            size_t n = std::min(size - done, PAGE_BYTES - within);
+            const char *data = number == length / PAGE_BYTES ? tail.data() : page(number);
+            memcpy(&out[done], data + within, n);
+            done += n;
+        }
+    }
+
+    uint64_t size() const
+    {
+        return length;
+    }
+
+    size_t budget() const
+    {
+        return maxFrames * PAGE_BYTES;
+    }
+
+    // Heap use: cached pages and the tail page, plus the cache's bookkeeping
+    size_t memoryUsage() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return (frames.size() + 1) * PAGE_BYTES + frames.capacity() * sizeof(Frame) +
+               cached.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void *));
+    }
+
+    uint64_t hits() const
+    {
+        return hitCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t misses() const
+    {
+        return missCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t evictions() const
+    {
+        return evictionCount.load(std::memory_order_relaxed);
+    }
+
+    // Pages that could not be fully written or read back (read as zeros)
+    uint64_t errors() const
+    {
+        return errorCount.load(std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        length = 0;
+        frames.clear();
+        cached.clear();
+        newest = oldest = NONE;
+#ifndef _WIN32
+        if (fd >= 0 && ::ftruncate(fd, 0) != 0)
+            errorCount.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+};
+
+#endif
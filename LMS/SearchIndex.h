@@ -0,0 +1,590 @@
+// Title/Author Search
+// Inverted index from lower-cased word tokens of book titles and authors to
+// the packed ISBNs of the books containing them. Tokens are kept in an
+// ordered map, so every dictionary entry that starts with a query word is one
+// contiguous range ("pot" finds "potter" and "pottery").
+//
+// A query matches a book when each of its words is a word of the book's title
+// or author; the last query word may also be the start of a word (unless the
+// query ends with a space), so results can be shown while the user is still
+// typing. The query word with the fewest
+// postings drives the search, its candidates are checked against the other
+// words by binary search in their (sorted) posting lists, and the search stops
+// as soon as the result limit is reached.
+//
+// For misspelled queries there is also a typo-tolerant search. Every
+// dictionary word is listed under each of its trigrams (three-letter pieces
+// of "$word$"), so the words within a few edits of a query word are found by
+// counting shared trigrams over a few short lists, and only those are checked
+// with a bounded edit distance, instead of comparing the query against every
+// title. The same class indexes student names (first and last name in place
+// of title and author).
+
+#ifndef LMS_SEARCHINDEX_H
+#define LMS_SEARCHINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+class SearchIndex
+{
+public:
+    // A key found by fuzzySearch and the number of edits (insertions,
+    // deletions, substitutions or swaps of adjacent letters) between the query
+    // words and the closest words of its text
+    struct FuzzyMatch
+    {
+        uint64_t key;
+        int distance;
+    };
+
+private:
+    // A query word matching more dictionary entries than this is checked
+    // against the book's text instead of by binary search in each list
+    static const size_t MAX_PROBE_LISTS = 16;
+
+    // Token -> ISBN keys of the books containing it, sorted (except during a bulk load)
+    std::map<std::string, std::vector<uint64_t>> terms;
+    bool bulkLoading = false;
+
+    typedef std::map<std::string, std::vector<uint64_t>>::const_iterator TermIterator;
+    typedef std::map<std::string, std::vector<uint64_t>>::value_type Term;
+
+    // Trigram code -> ids of the dictionary entries containing it (in no
+    // order). Map nodes never move, so an id stands for an entry's address;
+    // ids of removed entries are reused.
+    static const uint32_t GRAM_LETTERS = 37; // '$', a-z and 0-9
+    std::vector<std::vector<uint32_t>> grams;
+    std::vector<const Term *> termById;
+    std::unordered_map<const Term *, uint32_t> termIds;
+    std::vector<uint32_t> freeIds;
+
+    // A fuzzy query word matches no more than this many dictionary words, the closest ones
+    static const size_t MAX_VARIANTS = 32;
+
+    // A dictionary word close to a query word
+    struct Variant
+    {
+        const std::vector<uint64_t> *keys;
+        int distance;
+    };
+
+    // A posting list being intersected with the driving word's keys. Those
+    // arrive in ascending order, so the cursor only ever moves forward.
+    struct Probe
+    {
+        const std::vector<uint64_t> *list;
+        size_t cursor;
+    };
+    typedef std::vector<Probe> PostingLists;
+
+    static bool hasPrefix(const std::string &token, const std::string &prefix)
+    {
+        return token.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    static bool isWordChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    }
+
+    static char lower(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+    }
+
+    static void addTokens(std::string_view text, std::vector<std::string> &tokens)
+    {
+        std::string token;
+        for (char c : text)
+        {
+            if (isWordChar(c))
+                token += lower(c);
+            else if (!token.empty())
+            {
+                tokens.push_back(token);
+                token.clear();
+            }
+        }
+        if (!token.empty())
+            tokens.push_back(token);
+    }
+
+    // Distinct tokens of a book's title and author
+    static std::vector<std::string> bookTokens(std::string_view name, std::string_view author)
+    {
+        std::vector<std::string> tokens;
+        addTokens(name, tokens);
+        addTokens(author, tokens);
+        std::sort(tokens.begin(), tokens.end());
+        tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+        return tokens;
+    }
+
+    // True if some word of text starts with prefix (lower case), without allocating
+    static bool hasWordWithPrefix(std::string_view text, const std::string &prefix)
+    {
+        for (size_t i = 0; i + prefix.size() <= text.size(); i++)
+        {
+            if (!isWordChar(text[i]) || (i > 0 && isWordChar(text[i - 1])))
+                continue;
+            size_t j = 0;
+            while (j < prefix.size() && lower(text[i + j]) == prefix[j])
+                j++;
+            if (j == prefix.size())
+                return true;
+        }
+        return false;
+    }
+
+    // Total postings under prefix, counting no further than cap
+    size_t postingsUpTo(const std::string &prefix, size_t cap) const
+    {
+        size_t total = 0;
+        for (TermIterator it = terms.lower_bound(prefix); it != terms.end() && total <= cap && hasPrefix(it->first, prefix);
+             ++it)
+            total += it->second.size();
+        return total;
+    }
+
+    // Posting lists of every token starting with prefix; empty if there are more than MAX_PROBE_LISTS
+    PostingLists probeLists(const std::string &prefix) const
+    {
+        PostingLists lists;
+        for (TermIterator it = terms.lower_bound(prefix); it != terms.end() && hasPrefix(it->first, prefix); ++it)
+        {
+            if (lists.size() == MAX_PROBE_LISTS)
+                return {};
+            lists.push_back({&it->second, 0});
+        }
+        return lists;
+    }
+
+    // Gallops the cursor forward to the first key >= key; true if key is in the list
+    static bool advanceTo(Probe &probe, uint64_t key)
+    {
+        const std::vector<uint64_t> &list = *probe.list;
+        size_t low = probe.cursor;
+        size_t step = 1;
+        while (low + step < list.size() && list[low + step] < key)
+        {
+            low += step;
+            step *= 2;
+        }
+        size_t high = std::min(low + step + 1, list.size());
+        probe.cursor = std::lower_bound(list.begin() + low, list.begin() + high, key) - list.begin();
+        return probe.cursor < list.size() && list[probe.cursor] == key;
+    }
+
+    static bool inAnyList(PostingLists &lists, uint64_t key)
+    {
+        bool found = false;
+        for (auto &probe : lists)
+            found = advanceTo(probe, key) || found;
+        return found;
+    }
+
+    static uint32_t gramLetter(char c)
+    {
+        return c == '$' ? 0 : c <= '9' ? 27 + (c - '0') : 1 + (c - 'a');
+    }
+
+    // Distinct trigram codes of "$word$"
+    static std::vector<uint32_t> wordGrams(const std::string &word)
+    {
+        std::string padded = "$" + word + "$";
+        std::vector<uint32_t> codes;
+        for (size_t i = 0; i + 3 <= padded.size(); i++)
+            codes.push_back((gramLetter(padded[i]) * GRAM_LETTERS + gramLetter(padded[i + 1])) * GRAM_LETTERS +
+                            gramLetter(padded[i + 2]));
+        std::sort(codes.begin(), codes.end());
+        codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+        return codes;
+    }
+
+    void addGrams(const Term *term)
+    {
+        if (grams.empty())
+            grams.resize(GRAM_LETTERS * GRAM_LETTERS * GRAM_LETTERS);
+        uint32_t id = (uint32_t)termById.size();
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+            termById[id] = term;
+        }
+        else
+            termById.push_back(term);
+        termIds[term] = id;
+        for (uint32_t code : wordGrams(term->first))
+            grams[code].push_back(id);
+    }
+
+    void removeGrams(const Term *term)
+    {
+        auto entry = termIds.find(term);
+        if (entry == termIds.end())
+            return;
+        uint32_t id = entry->second;
+        for (uint32_t code : wordGrams(term->first))
+        {
+            std::vector<uint32_t> &list = grams[code];
+            auto pos = std::find(list.begin(), list.end(), id);
+            if (pos != list.end())
+            {
+                *pos = list.back();
+                list.pop_back();
+            }
+        }
+        termById[id] = nullptr;
+        freeIds.push_back(id);
+        termIds.erase(entry);
+    }
+
+    // Edits allowed for a query word of this length: short words must match exactly
+    static int maxDistance(size_t length)
+    {
+        return length <= 3 ? 0 : length <= 7 ? 1 : 2;
+    }
+
+    // Optimal string alignment distance between a and b (edits plus swaps of
+    // adjacent letters), or limit + 1 as soon as it is known to exceed limit
+    static int boundedDistance(const std::string &a, const std::string &b, int limit)
+    {
+        if ((int)a.size() - (int)b.size() > limit || (int)b.size() - (int)a.size() > limit)
+            return limit + 1;
+        std::vector<int> before(b.size() + 1), previous(b.size() + 1), current(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); j++)
+            previous[j] = (int)j;
+        for (size_t i = 1; i <= a.size(); i++)
+        {
+            current[0] = (int)i;
+            int rowMin = current[0];
+            for (size_t j = 1; j <= b.size(); j++)
+            {
+                int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+                current[j] = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+                if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                    current[j] = std::min(current[j], before[j - 2] + 1);
+                rowMin = std::min(rowMin, current[j]);
+            }
+            if (rowMin > limit)
+                return limit + 1;
+            std::swap(before, previous);
+            std::swap(previous, current);
+        }
+        return std::min(previous[b.size()], limit + 1);
+    }
+
+    // Dictionary words within maxDistance of word, closest first. A word k
+    // edits away still shares all but at most 3k of the query's trigrams, so
+    // only words sharing that many are compared. A swap of two letters can
+    // change four trigrams of a short word, so swapped spellings are also
+    // looked up directly.
+    std::vector<Variant> variants(const std::string &word) const
+    {
+        std::vector<Variant> found;
+        int limit = maxDistance(word.size());
+        std::vector<const Term *> candidates;
+        if (limit > 0 && !grams.empty())
+        {
+            std::vector<uint32_t> codes = wordGrams(word);
+            size_t needed = codes.size() > 3 * (size_t)limit ? codes.size() - 3 * limit : 1;
+            std::vector<uint8_t> shared(termById.size());
+            for (uint32_t code : codes)
+                for (uint32_t id : grams[code])
+                    if (++shared[id] == needed)
+                    {
+                        const Term *term = termById[id];
+                        if (term->first.size() + limit >= word.size() && term->first.size() <= word.size() + limit)
+                            candidates.push_back(term);
+                    }
+        }
+        auto lookUp = [&](const std::string &spelling)
+        {
+            TermIterator it = terms.find(spelling);
+            if (it != terms.end())
+                candidates.push_back(&*it);
+        };
+        lookUp(word);
+        for (size_t i = 0; limit > 0 && i + 1 < word.size(); i++)
+        {
+            std::string swapped = word;
+            std::swap(swapped[i], swapped[i + 1]);
+            lookUp(swapped);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        for (const Term *term : candidates)
+        {
+            int distance = boundedDistance(word, term->first, limit);
+            if (distance <= limit)
+                found.push_back({&term->second, distance});
+        }
+        std::sort(found.begin(), found.end(), [](const Variant &a, const Variant &b)
+                  { return a.distance != b.distance ? a.distance < b.distance : a.keys->size() > b.keys->size(); });
+        if (found.size() > MAX_VARIANTS)
+            found.resize(MAX_VARIANTS);
+        return found;
+    }
+
+public:
+    // Splits text into lower-cased alphanumeric words
+    static std::vector<std::string> tokenize(std::string_view text)
+    {
+        std::vector<std::string> tokens;
+        addTokens(text, tokens);
+        return tokens;
+    }
+
+    // While loading a whole catalog, postings are appended unsorted and
+    // sorted once at the end instead of being kept sorted on every insert
+    void beginBulkLoad()
+    {
+        bulkLoading = true;
+    }
+
+    void endBulkLoad()
+    {
+        for (auto &term : terms)
+            std::sort(term.second.begin(), term.second.end());
+        bulkLoading = false;
+    }
+
+    void add(uint64_t key, std::string_view name, std::string_view author)
+    {
+        for (const auto &token : bookTokens(name, author))
+        {
+            auto term = terms.try_emplace(token);
+            if (term.second)
+                addGrams(&*term.first);
+            std::vector<uint64_t> &postings = term.first->second;
+            if (bulkLoading || postings.empty() || postings.back() < key)
+                postings.push_back(key);
+            else
+                postings.insert(std::lower_bound(postings.begin(), postings.end(), key), key);
+        }
+    }
+
+    void remove(uint64_t key, std::string_view name, std::string_view author)
+    {
+        for (const auto &token : bookTokens(name, author))
+        {
+            auto it = terms.find(token);
+            if (it == terms.end())
+                continue;
+            std::vector<uint64_t> &postings = it->second;
+            auto pos = bulkLoading ? std::find(postings.begin(), postings.end(), key)
+                                   : std::lower_bound(postings.begin(), postings.end(), key);
+            if (pos != postings.end() && *pos == key)
+                postings.erase(pos);
+            if (postings.empty())
+            {
+                removeGrams(&*it);
+                terms.erase(it);
+            }
+        }
+    }
+
+    void clear()
+    {
+        terms.clear();
+        grams.clear();
+        termById.clear();
+        termIds.clear();
+        freeIds.clear();
+    }
+
+    size_t termCount() const
+    {
+        return terms.size();
+    }
+
+    // Returns up to limit ISBN keys of books matching query.
+    // lookup(key, name, author) must set the book's title and author and return
+    // false if there is no such book; it is only used for a last word with very
+    // many completions.
+    template <class Lookup>
+    std::vector<uint64_t> search(const std::string &query, size_t limit, Lookup lookup) const
+    {
+        std::vector<uint64_t> results;
+        std::vector<std::string> words = tokenize(query);
+        if (words.empty() || limit == 0)
+            return results;
+        // Only the last word is matched as a prefix, and only if it is still being typed
+        size_t last = isWordChar(query.back()) ? words.size() - 1 : words.size();
+
+        // Drive the search from the word with the fewest postings. Whole words are
+        // counted first, so they cap the scan over the prefix word's completions.
+        size_t best = last;
+        size_t bestCount = SIZE_MAX;
+        std::vector<PostingLists> probes(words.size());
+        for (size_t i = 0; i < last; i++)
+        {
+            TermIterator it = terms.find(words[i]);
+            if (it == terms.end())
+                return results;
+            probes[i].push_back({&it->second, 0});
+            if (it->second.size() < bestCount)
+            {
+                best = i;
+                bestCount = it->second.size();
+            }
+        }
+        if (last > 0 && last < words.size())
+        {
+            if (postingsUpTo(words[last], bestCount) < bestCount)
+                best = last;
+            else
+                probes[last] = probeLists(words[last]);
+        }
+
+        auto matchesOthers = [&](uint64_t key)
+        {
+            for (size_t i = 0; i < words.size(); i++)
+            {
+                if (i == best)
+                    continue;
+                if (!probes[i].empty())
+                {
+                    if (!inAnyList(probes[i], key))
+                        return false;
+                    continue;
+                }
+                std::string_view name, author;
+                if (!lookup(key, name, author) || !(hasWordWithPrefix(name, words[i]) || hasWordWithPrefix(author, words[i])))
+                    return false;
+            }
+            return true;
+        };
+
+        // Walk the driving word's posting lists (several if it is the prefix word)
+        const std::string &driver = words[best];
+        TermIterator first = best == last ? terms.lower_bound(driver) : terms.find(driver);
+        if (first == terms.end())
+            return results;
+        bool oneTerm = best != last || std::next(first) == terms.end() || !hasPrefix(std::next(first)->first, driver);
+        std::unordered_set<uint64_t> seen; // A book can hold several tokens with the same prefix
+        for (TermIterator it = first; it != terms.end() && hasPrefix(it->first, driver); ++it)
+        {
+            for (auto &lists : probes) // Each driving list starts again from its smallest key
+                for (auto &probe : lists)
+                    probe.cursor = 0;
+            for (uint64_t key : it->second)
+            {
+                if ((!oneTerm && !seen.insert(key).second) || !matchesOthers(key))
+                    continue;
+                results.push_back(key);
+                if (results.size() == limit)
+                    return results;
+            }
+            if (oneTerm)
+                break;
+        }
+        return results;
+    }
+
+    // Returns up to limit keys whose text has, for every query word, a word
+    // within a few edits of it (none for words of up to 3 letters, one up to 7,
+    // two beyond), fewest edits in total first. Not for use during a bulk load.
+    std::vector<FuzzyMatch> fuzzySearch(const std::string &query, size_t limit) const
+    {
+        std::vector<FuzzyMatch> results;
+        std::vector<std::string> words = tokenize(query);
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        if (words.empty() || limit == 0)
+            return results;
+
+        // As in search, the word with the fewest postings (over all its variants) drives
+        std::vector<std::vector<Variant>> options(words.size());
+        size_t best = 0;
+        size_t bestCount = SIZE_MAX;
+        for (size_t i = 0; i < words.size(); i++)
+        {
+            options[i] = variants(words[i]);
+            if (options[i].empty())
+                return results;
+            size_t count = 0;
+            for (const Variant &variant : options[i])
+                count += variant.keys->size();
+            if (count < bestCount)
+            {
+                best = i;
+                bestCount = count;
+            }
+        }
+
+        // Each of the driving word's variant lists is walked in key order and
+        // checked against the other words' lists with forward-only cursors, as
+        // in search. Variants are closest first, so a key's first match is its
+        // closest, and no key still to come can score below the driving
+        // variant's distance plus the other words' closest: once limit keys
+        // are that close, the search stops.
+        std::vector<PostingLists> probes(words.size());
+        int floor = 0;
+        for (size_t i = 0; i < words.size(); i++)
+            if (i != best)
+            {
+                for (const Variant &variant : options[i])
+                    probes[i].push_back({variant.keys, 0});
+                floor += options[i][0].distance;
+            }
+        std::vector<size_t> withDistance; // Results found so far by total distance
+        auto enoughWithin = [&](int distance)
+        {
+            size_t count = 0;
+            for (int d = 0; d <= distance && d < (int)withDistance.size(); d++)
+                count += withDistance[d];
+            return count >= limit;
+        };
+        std::unordered_set<uint64_t> taken;
+        for (const Variant &variant : options[best])
+        {
+            if (enoughWithin(variant.distance + floor))
+                break;
+            for (auto &lists : probes)
+                for (auto &probe : lists)
+                    probe.cursor = 0;
+            for (uint64_t key : *variant.keys)
+            {
+                if (taken.count(key))
+                    continue;
+                int distance = variant.distance;
+                for (size_t i = 0; i < words.size() && distance >= 0; i++)
+                {
+                    if (i == best)
+                        continue;
+                    size_t v = 0;
+                    while (v < probes[i].size() && !advanceTo(probes[i][v], key))
+                        v++;
+                    distance = v == probes[i].size() ? -1 : distance + options[i][v].distance;
+                }
+                if (distance < 0)
+                    continue;
+                taken.insert(key);
+                results.push_back({key, distance});
+                if (withDistance.size() <= (size_t)distance)
+                    withDistance.resize(distance + 1);
+                withDistance[distance]++;
+                if (enoughWithin(variant.distance + floor))
+                    break;
+            }
+        }
+
+        size_t keep = std::min(limit, results.size());
+        std::partial_sort(results.begin(), results.begin() + keep, results.end(), [](const FuzzyMatch &a, const FuzzyMatch &b)
+                          { return a.distance != b.distance ? a.distance < b.distance : a.key < b.key; });
+        results.resize(keep);
+        return results;
+    }
+};
+
+#endif
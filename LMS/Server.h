@@ -0,0 +1,476 @@
+// Server Mode (Linux)
+// A single LMS process owns the data files and serves counter terminals over
+// a Unix domain socket or a localhost TCP port, so terminals no longer run
+// their own copy and overwrite each other's saves.
+//
+// Protocol: the Batch.h command language. A client sends one command per line
+// and gets exactly one response line back, in order; requests may be pipelined.
+// "quit" closes the connection.
+//
+// Each connection is a terminal with its own login session. Logins are
+// throttled per terminal as well as per user (see Accounts.h). Every client is
+// local, so a terminal is one connection: the peer's user id and a connection
+// number on the Unix socket, its address and port over TCP. Unless the server
+// is started with --no-login, a connection must log in, or resume a session
+// by its token, before anything else.
+//
+// One thread runs an epoll loop over every connection with non-blocking
+// sockets, so hundreds of clients do not need a thread each. Most commands
+// execute inline; each is a few microseconds of in-memory work plus a journal
+// append. The commands that hash a password (login, addaccount, passwd; about
+// 15 ms of PBKDF2 each) or read whole files (analytics rebuild, restore,
+// snapshot, checkpoint) go to a small pool of worker threads instead, so they
+// do not stall the other terminals. The connection that sent one reads
+// no further lines until its reply comes back through an eventfd, so replies
+// stay in order.
+
+#ifndef LMS_SERVER_H
+#define LMS_SERVER_H
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Batch.h"
+
+class Server
+{
+private:
+    static const size_t MAX_LINE = 64 * 1024; // Connections sending longer lines are dropped
+    static const int MAX_EVENTS = 256;
+    static const int WORKERS = 4;
+
+    struct Connection
+    {
+        uint64_t id = 0; // Tells a reused fd's new connection from the old one
+        string in;
+        string out;
+        size_t outPos = 0;
+        bool peerDone = false; // The peer has half-closed; answer what it sent, then close
+        bool closing = false;
+        bool busy = false;     // A command of this connection is on a worker
+        uint32_t events = 0;   // What epoll watches for it
+        BatchSession session;
+    };
+
+    // A command run on a worker, with a copy of its connection's session
+    struct Job
+    {
+        int fd = -1;
+        uint64_t id = 0;
+        string line;
+        BatchSession session;
+        string reply;
+    };
+
+    LMS &library;
+    string endpoint;
+    string unixPath;
+    int listener = -1;
+    int epollFd = -1;
+    bool requireLogin;
+    unordered_map<int, Connection> connections;
+    uint64_t accepted = 0; // Connections so far, numbering Unix socket terminals
+
+    vector<thread> workers;
+    mutex jobLock;
+    condition_variable jobReady;
+    deque<Job> jobs;     // Waiting for a worker
+    vector<Job> done;    // Answered, waiting for the loop; also under jobLock
+    bool workersStopping = false;
+    int wakeFd = -1;     // eventfd the workers signal when they add to done
+
+    static volatile sig_atomic_t &stopFlag()
+    {
+        static volatile sig_atomic_t flag = 0;
+        return flag;
+    }
+
+    static void onSignal(int)
+    {
+        stopFlag() = 1;
+    }
+
+    // endpoint is "unix:<path>" or "tcp:<port>" (bound to 127.0.0.1 only)
+    bool openListener()
+    {
+        if (endpoint.compare(0, 5, "unix:") == 0)
+        {
+            unixPath = endpoint.substr(5);
+            sockaddr_un addr = {};
+            if (unixPath.empty() || unixPath.size() >= sizeof(addr.sun_path))
+                return false;
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, unixPath.c_str(), sizeof(addr.sun_path) - 1);
+
+            listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            unlink(unixPath.c_str());
+            if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) < 0)
+                return false;
+        }
+        else if (endpoint.compare(0, 4, "tcp:") == 0)
+        {
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((uint16_t)atoi(endpoint.c_str() + 4));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int on = 1;
+            if (listener < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+                bind(listener, (sockaddr *)&addr, sizeof(addr)) < 0)
+                return false;
+        }
+        else
+            return false;
+
+        return listen(listener, SOMAXCONN) == 0;
+    }
+
+    void watch(int fd, uint32_t events, int op)
+    {
+        epoll_event ev = {};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, op, fd, &ev);
+    }
+
+    void acceptAll()
+    {
+        while (true)
+        {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            if (unixPath.empty())
+            {
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+            Connection &conn = connections[fd];
+            conn.session.terminal = peerName(fd);
+            conn.id = accepted;
+            conn.session.requireLogin = requireLogin;
+            conn.events = EPOLLIN | EPOLLRDHUP;
+            watch(fd, conn.events, EPOLL_CTL_ADD);
+        }
+    }
+
+    // The terminal name of a new connection: "uid:<user id>/<connection>" on
+    // the Unix socket, "tcp:<address>:<port>" over TCP. Unique among open
+    // connections, as their peers all share one user id or address.
+    string peerName(int fd)
+    {
+        accepted++;
+        if (!unixPath.empty())
+        {
+            ucred cred = {};
+            socklen_t size = sizeof(cred);
+            string user = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &size) == 0 ? to_string(cred.uid) : "?";
+            return "uid:" + user + "/" + to_string(accepted);
+        }
+        sockaddr_in addr = {};
+        socklen_t size = sizeof(addr);
+        char text[INET_ADDRSTRLEN] = "?";
+        if (getpeername(fd, (sockaddr *)&addr, &size) == 0)
+            inet_ntop(AF_INET, &addr.sin_addr, text, sizeof(text));
+        return string("tcp:") + text + ":" + to_string(ntohs(addr.sin_port));
+    }
+
+    void closeConnection(int fd)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    }
+
+    // Commands too slow for the loop thread: they hash a password or read
+    // whole files (the circulation history, history snapshots, every record)
+    static bool runsOnWorker(const string &line)
+    {
+        size_t start = line.find_first_not_of(" \t");
+        size_t end = line.find_first_of(" \t", start);
+        string_view command = string_view(line).substr(start, end - start);
+        if (command == "analytics")
+        {
+            size_t next = line.find_first_not_of(" \t", end);
+            return next != string::npos && line.compare(next, 7, "rebuild") == 0;
+        }
+        return command == "login" || command == "addaccount" || command == "passwd" || command == "restore" ||
+               command == "snapshot" || command == "checkpoint";
+    }
+
+    void work()
+    {
+        while (true)
+        {
+            Job job;
+            {
+                unique_lock<mutex> guard(jobLock);
+                jobReady.wait(guard, [&]
+                              { return workersStopping || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job.reply = executeCommand(library, job.line, job.session);
+            {
+                lock_guard<mutex> guard(jobLock);
+                done.push_back(std::move(job));
+            }
+            uint64_t one = 1;
+            if (write(wakeFd, &one, sizeof(one)) < 0)
+            {
+                // Only fails if the counter is saturated, and then the loop wakes anyway
+            }
+        }
+    }
+
+    // Lets the workers finish the queued jobs, then joins them
+    void stopWorkers()
+    {
+        {
+            lock_guard<mutex> guard(jobLock);
+            workersStopping = true;
+        }
+        jobReady.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+        workers.clear();
+    }
+
+    // Hands the replies of finished jobs to their connections, which then
+    // answer the lines that waited behind them
+    void finishJobs()
+    {
+        uint64_t count;
+        if (read(wakeFd, &count, sizeof(count)) < 0)
+            return;
+        vector<Job> finished;
+        {
+            lock_guard<mutex> guard(jobLock);
+            finished.swap(done);
+        }
+        for (Job &job : finished)
+        {
+            auto it = connections.find(job.fd);
+            if (it == connections.end() || it->second.id != job.id)
+                continue; // Closed while the job ran
+            Connection &conn = it->second;
+            conn.session = job.session;
+            conn.out += job.reply;
+            conn.out += '\n';
+            conn.busy = false;
+            bool alive = answerLines(job.fd, conn) && flush(job.fd, conn);
+            settle(job.fd, conn, alive);
+        }
+    }
+
+    // Reads whatever is available and answers the complete lines (see
+    // answerLines). Returns false if the connection failed.
+    bool readRequests(int fd, Connection &conn)
+    {
+        char buffer[16384];
+        while (true)
+        {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n > 0)
+            {
+                conn.in.append(buffer, n);
+                continue;
+            }
+            if (n == 0)
+            {
+                conn.peerDone = true;
+                break;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+            break;
+        }
+        return answerLines(fd, conn);
+    }
+
+    // Answers every complete line received, up to one that goes to a worker;
+    // the rest wait for its reply. Once the peer has half-closed and every
+    // line it sent is answered, the connection is marked closing, so it closes
+    // after the replies are sent. Returns false if a line is too long.
+    bool answerLines(int fd, Connection &conn)
+    {
+        size_t start = 0;
+        size_t end;
+        while (!conn.closing && !conn.busy && (end = conn.in.find('\n', start)) != string::npos)
+        {
+            string line = conn.in.substr(start, end - start);
+            start = end + 1;
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            size_t first = line.find_first_not_of(" \t");
+            if (first == string::npos || line[first] == '#')
+                continue;
+            if (line == "quit")
+            {
+                conn.closing = true;
+                break;
+            }
+            if (runsOnWorker(line))
+            {
+                conn.busy = true;
+                {
+                    lock_guard<mutex> guard(jobLock);
+                    jobs.push_back({fd, conn.id, line, conn.session, ""});
+                }
+                jobReady.notify_one();
+                break;
+            }
+            conn.out += executeCommand(library, line, conn.session);
+            conn.out += '\n';
+        }
+        conn.in.erase(0, start);
+        if (conn.peerDone && !conn.busy)
+            conn.closing = true;
+        return conn.busy || conn.in.size() <= MAX_LINE;
+    }
+
+    // Sends pending responses; returns false on a write error
+    bool flush(int fd, Connection &conn)
+    {
+        while (conn.outPos < conn.out.size())
+        {
+            ssize_t n = send(fd, conn.out.data() + conn.outPos, conn.out.size() - conn.outPos, MSG_NOSIGNAL);
+            if (n > 0)
+                conn.outPos += n;
+            else if (n < 0 && errno == EINTR)
+                continue;
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            else
+                return false;
+        }
+
+        if (conn.outPos == conn.out.size())
+        {
+            conn.out.clear();
+            conn.outPos = 0;
+        }
+        return true;
+    }
+
+    // Closes the connection if it failed or is done; otherwise watches it for
+    // what it now waits for. A closing connection, or one waiting on a worker,
+    // reads nothing more for now, so it only waits to write.
+    void settle(int fd, Connection &conn, bool alive)
+    {
+        if (!alive || (conn.closing && conn.out.empty()))
+        {
+            closeConnection(fd);
+            return;
+        }
+        uint32_t events = conn.closing || conn.busy ? 0u : (uint32_t)(EPOLLIN | EPOLLRDHUP);
+        if (!conn.out.empty())
+            events |= EPOLLOUT;
+        if (events != conn.events)
+        {
+            conn.events = events;
+            watch(fd, events, EPOLL_CTL_MOD);
+        }
+    }
+
+public:
+    Server(LMS &lms, const string &where, bool loginRequired = true)
+        : library(lms), endpoint(where), requireLogin(loginRequired) {}
+
+    ~Server()
+    {
+        stopWorkers();
+        if (wakeFd >= 0)
+            close(wakeFd);
+        for (auto &entry : connections)
+            close(entry.first);
+        if (epollFd >= 0)
+            close(epollFd);
+        if (listener >= 0)
+            close(listener);
+        if (!unixPath.empty())
+            unlink(unixPath.c_str());
+    }
+
+    // Serves clients until SIGINT or SIGTERM; returns false if the endpoint could not be opened
+    bool run()
+    {
+        if (!openListener())
+            return false;
+
+        struct sigaction action = {};
+        action.sa_handler = onSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        watch(listener, EPOLLIN, EPOLL_CTL_ADD);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        watch(wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+        for (int i = 0; i < WORKERS; i++)
+            workers.emplace_back(&Server::work, this);
+
+        epoll_event events[MAX_EVENTS];
+        while (!stopFlag())
+        {
+            int ready = epoll_wait(epollFd, events, MAX_EVENTS, 500);
+            for (int i = 0; i < ready; i++)
+            {
+                int fd = events[i].data.fd;
+                if (fd == listener)
+                {
+                    acceptAll();
+                    continue;
+                }
+                if (fd == wakeFd)
+                {
+                    finishJobs();
+                    continue;
+                }
+
+                auto it = connections.find(fd);
+                if (it == connections.end())
+                    continue;
+                Connection &conn = it->second;
+
+                // A hang-up is reported even while nothing is watched, so a
+                // connection waiting on a worker is closed rather than polled
+                bool alive = !(events[i].events & EPOLLERR) && !(conn.busy && (events[i].events & EPOLLHUP));
+                if (alive && !conn.closing && !conn.busy && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))
+                    alive = readRequests(fd, conn);
+                // Answer what was received even if the peer has half-closed
+                if (!conn.out.empty() && !flush(fd, conn))
+                    alive = false;
+                settle(fd, conn, alive);
+            }
+        }
+        stopWorkers();
+        return true;
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,232 @@
+// SHA-256 and PBKDF2
+// SHA-256 (FIPS 180-4), HMAC-SHA256 (RFC 2104) and PBKDF2-HMAC-SHA256
+// (RFC 8018), used to store account passwords as salted, stretched hashes
+// (see Accounts.h). PBKDF2 keys the HMAC once and copies the keyed inner and
+// outer states for every iteration, so each iteration costs two compressions.
+
+#ifndef LMS_SHA256_H
+#define LMS_SHA256_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+class Sha256
+{
+public:
+    static const size_t DIGEST_BYTES = 32;
+    static const size_t BLOCK_BYTES = 64;
+    typedef std::array<uint8_t, DIGEST_BYTES> Digest;
+
+private:
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    uint8_t block[BLOCK_BYTES];
+    size_t used = 0;   // Bytes in block
+    uint64_t total = 0; // Bytes hashed
+
+    static uint32_t rotr(uint32_t x, int n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    void compress(const uint8_t *data)
+    {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 | (uint32_t)data[4 * i + 2] << 8 |
+                   data[4 * i + 3];
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+public:
+    Sha256 &update(const void *data, size_t size)
+    {
+        const uint8_t *bytes = (const uint8_t *)data;
+        total += size;
+        if (used)
+        {
+            size_t n = std::min(size, BLOCK_BYTES - used);
+            memcpy(block + used, bytes, n);
+            used += n;
+            bytes += n;
+            size -= n;
+            if (used < BLOCK_BYTES)
+                return *this;
+            compress(block);
+            used = 0;
+        }
+        for (; size >= BLOCK_BYTES; bytes += BLOCK_BYTES, size -= BLOCK_BYTES)
+            compress(bytes);
+        memcpy(block, bytes, size);
+        used = size;
+        return *this;
+    }
+
+    Sha256 &update(std::string_view text)
+    {
+        return update(text.data(), text.size());
+    }
+
+    // Pads and returns the digest; the object is spent afterwards
+    Digest finish()
+    {
+        uint64_t bits = total * 8;
+        uint8_t pad[BLOCK_BYTES + 8] = {0x80};
+        size_t padding = (used < 56 ? 56 : 120) - used;
+        for (int i = 0; i < 8; i++)
+            pad[padding + i] = (uint8_t)(bits >> (56 - 8 * i));
+        update(pad, padding + 8);
+
+        Digest digest;
+        for (int i = 0; i < 8; i++)
+            for (int j = 0; j < 4; j++)
+                digest[4 * i + j] = (uint8_t)(state[i] >> (24 - 8 * j));
+        return digest;
+    }
+
+    static Digest hash(std::string_view text)
+    {
+        return Sha256().update(text).finish();
+    }
+};
+
+// HMAC-SHA256 with the key absorbed once; sign() may be called any number of times
+class HmacSha256
+{
+private:
+    Sha256 inner, outer; // States after the key xor ipad / opad blocks
+
+public:
+    explicit HmacSha256(std::string_view key)
+    {
+        uint8_t padded[Sha256::BLOCK_BYTES] = {};
+        if (key.size() > Sha256::BLOCK_BYTES)
+        {
+            Sha256::Digest digest = Sha256::hash(key);
+            memcpy(padded, digest.data(), digest.size());
+        }
+        else
+            memcpy(padded, key.data(), key.size());
+
+        uint8_t pad[Sha256::BLOCK_BYTES];
+        for (size_t i = 0; i < Sha256::BLOCK_BYTES; i++)
+            pad[i] = padded[i] ^ 0x36;
+        inner.update(pad, sizeof(pad));
+        for (size_t i = 0; i < Sha256::BLOCK_BYTES; i++)
+            pad[i] = padded[i] ^ 0x5c;
+        outer.update(pad, sizeof(pad));
+    }
+
+    Sha256::Digest sign(const void *data, size_t size) const
+    {
+        Sha256::Digest innerDigest = Sha256(inner).update(data, size).finish();
+        return Sha256(outer).update(innerDigest.data(), innerDigest.size()).finish();
+    }
+};
+
+// PBKDF2-HMAC-SHA256 with a single output block (a 32 byte key)
+inline Sha256::Digest pbkdf2Sha256(std::string_view password, std::string_view salt, uint32_t iterations)
+{
+    HmacSha256 mac(password);
+    std::string first(salt);
+    first.append("\0\0\0\1", 4); // Block index 1, big-endian
+    Sha256::Digest u = mac.sign(first.data(), first.size());
+    Sha256::Digest key = u;
+    for (uint32_t i = 1; i < iterations; i++)
+    {
+        u = mac.sign(u.data(), u.size());
+        for (size_t j = 0; j < key.size(); j++)
+            key[j] ^= u[j];
+    }
+    return key;
+}
+
+// Compares two equal-length byte strings in time that does not depend on where they differ
+inline bool constantTimeEqual(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    volatile uint8_t difference = 0;
+    for (size_t i = 0; i < size; i++)
+        difference = difference | (a[i] ^ b[i]);
+    return difference == 0;
+}
+
+inline std::string toHex(const uint8_t *data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string text(size * 2, '0');
+    for (size_t i = 0; i < size; i++)
+    {
+        text[2 * i] = digits[data[i] >> 4];
+        text[2 * i + 1] = digits[data[i] & 15];
+    }
+    return text;
+}
+
+// Decodes lowercase or uppercase hex into out; false if text is not hex of that length
+inline bool fromHex(std::string_view text, uint8_t *out, size_t size)
+{
+    if (text.size() != size * 2)
+        return false;
+    auto nibble = [](char c) -> int
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < size; i++)
+    {
+        int high = nibble(text[2 * i]), low = nibble(text[2 * i + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        out[i] = (uint8_t)(high << 4 | low);
+    }
+    return true;
+}
+
+#endif
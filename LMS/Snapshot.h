@@ -0,0 +1,283 @@
+// Binary Snapshot (lms.snap)
+// Versioned image of books, students and open loans that can be memory-mapped
+// and read in place, so startup does not parse any text.
+//
+// Layout (native byte order, all sections 8-byte aligned):
+//   SnapshotHeader
+//   SnapshotBook[bookCount]
+//   SnapshotStudent[studentCount]
+//   SnapshotLoan[loanCount]
+//   string pool (every name, author, phone and email, back to back, no terminators)
+// Text fields are stored as (offset, length) pairs into the pool. Both are
+// 32-bit, so the pool holds at most 4 GB; a library with more text than that
+// cannot be snapshotted, and SnapshotWriter::save() fails rather than write
+// offsets that wrapped around.
+
+#ifndef LMS_SNAPSHOT_H
+#define LMS_SNAPSHOT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include "DurableFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const char SNAPSHOT_MAGIC[8] = {'L', 'M', 'S', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t bookCount;
+    uint64_t studentCount;
+    uint64_t loanCount;
+    uint64_t poolSize;
+};
+
+struct SnapshotString
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct SnapshotBook
+{
+    uint64_t isbn;
+    int32_t copies;
+    uint32_t reserved;
+    SnapshotString name;
+    SnapshotString author;
+};
+
+struct SnapshotStudent
+{
+    uint32_t reg;
+    uint32_t reserved;
+    SnapshotString firstName;
+    SnapshotString lastName;
+    SnapshotString phone;
+    SnapshotString email;
+};
+
+struct SnapshotLoan
+{
+    uint32_t reg;
+    uint32_t loanSeconds; // dueAt - issuedAt; 0 in snapshots written before loans had due dates
+    uint64_t isbn;
+    int64_t issuedAt;
+};
+
+static_assert(sizeof(SnapshotHeader) == 48 && sizeof(SnapshotBook) == 32 &&
+                  sizeof(SnapshotStudent) == 40 && sizeof(SnapshotLoan) == 24,
+              "snapshot rows must keep their on-disk size");
+
+// Collects rows in memory and writes them out as one snapshot file
+class SnapshotWriter
+{
+private:
+    std::vector<SnapshotBook> books;
+    std::vector<SnapshotStudent> students;
+    std::vector<SnapshotLoan> loans;
+    std::string pool;
+    bool poolFull = false; // Some text did not fit in 32-bit offsets; save() fails
+
+    SnapshotString intern(std::string_view text)
+    {
+        if ((uint64_t)pool.size() + text.size() > UINT32_MAX)
+        {
+            poolFull = true;
+            return {0, 0};
+        }
+        SnapshotString ref = {(uint32_t)pool.size(), (uint32_t)text.size()};
+        pool.append(text.data(), text.size());
+        return ref;
+    }
+
+public:
+    void reserve(size_t bookCount, size_t studentCount, size_t loanCount)
+    {
+        books.reserve(bookCount);
+        students.reserve(studentCount);
+        loans.reserve(loanCount);
+    }
+
+    void addBook(uint64_t isbn, int copies, std::string_view name, std::string_view author)
+    {
+        books.push_back({isbn, copies, 0, intern(name), intern(author)});
+    }
+
+    void addStudent(uint32_t reg, std::string_view firstName, std::string_view lastName, std::string_view phone,
+                    std::string_view email)
+    {
+        students.push_back({reg, 0, intern(firstName), intern(lastName), intern(phone), intern(email)});
+    }
+
+    void addLoan(uint32_t reg, uint64_t isbn, int64_t issuedAt, int64_t dueAt)
+    {
+        loans.push_back({reg, (uint32_t)std::max<int64_t>(dueAt - issuedAt, 1), isbn, issuedAt});
+    }
+
+    // Replaces path durably (see DurableFile.h), so neither readers nor a
+    // crash ever observe a half-written snapshot. False, leaving path as it
+    // was, if the text outgrew the pool's 32-bit offsets.
+    bool save(const std::string &path) const
+    {
+        if (poolFull)
+            return false;
+        SnapshotHeader header = {};
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.bookCount = books.size();
+        header.studentCount = students.size();
+        header.loanCount = loans.size();
+        header.poolSize = pool.size();
+
+        DurableWriter file(path);
+        file.appendBytes(&header, sizeof(header));
+        file.appendBytes(books.data(), books.size() * sizeof(SnapshotBook));
+        file.appendBytes(students.data(), students.size() * sizeof(SnapshotStudent));
+        file.appendBytes(loans.data(), loans.size() * sizeof(SnapshotLoan));
+        file.appendBytes(pool.data(), pool.size());
+        return file.commit();
+    }
+};
+
+// Read-only view of a snapshot file. On POSIX systems the file is mapped, so
+// rows are used in place and only the pages actually touched are read.
+class SnapshotFile
+{
+private:
+    const char *data = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> buffer; // Fallback when mmap is unavailable
+    const SnapshotHeader *header = nullptr;
+
+    template <typename T>
+    const T *section(size_t offset) const
+    {
+        return (const T *)(data + offset);
+    }
+
+    size_t booksOffset() const { return sizeof(SnapshotHeader); }
+    size_t studentsOffset() const { return booksOffset() + header->bookCount * sizeof(SnapshotBook); }
+    size_t loansOffset() const { return studentsOffset() + header->studentCount * sizeof(SnapshotStudent); }
+    size_t poolOffset() const { return loansOffset() + header->loanCount * sizeof(SnapshotLoan); }
+
+public:
+    SnapshotFile() = default;
+    SnapshotFile(const SnapshotFile &) = delete;
+    SnapshotFile &operator=(const SnapshotFile &) = delete;
+
+    ~SnapshotFile()
+    {
+#ifndef _WIN32
+        if (mapped)
+            munmap((void *)data, length);
+#endif
+    }
+
+    // Maps the file and checks its header and section bounds
+    bool open(const std::string &path)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                data = (const char *)addr;
+                length = info.st_size;
+                mapped = true;
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (file)
+        {
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            data = buffer.data();
+            length = buffer.size();
+        }
+#endif
+        if (!data || length < sizeof(SnapshotHeader))
+            return false;
+
+        header = section<SnapshotHeader>(0);
+        if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != SNAPSHOT_VERSION || header->byteOrder != SNAPSHOT_BYTE_ORDER)
+            return false;
+
+        // Guard against truncated files and absurd counts before trusting any offset
+        uint64_t rows = header->bookCount * sizeof(SnapshotBook) + header->studentCount * sizeof(SnapshotStudent) +
+                        header->loanCount * sizeof(SnapshotLoan);
+        if (header->bookCount > length || header->studentCount > length || header->loanCount > length ||
+            sizeof(SnapshotHeader) + rows + header->poolSize != length)
+            return false;
+        return true;
+    }
+
+    size_t bookCount() const { return header->bookCount; }
+    size_t studentCount() const { return header->studentCount; }
+    size_t loanCount() const { return header->loanCount; }
+
+    const SnapshotBook *books() const { return section<SnapshotBook>(booksOffset()); }
+    const SnapshotStudent *students() const { return section<SnapshotStudent>(studentsOffset()); }
+    const SnapshotLoan *loans() const { return section<SnapshotLoan>(loansOffset()); }
+
+    const char *pool() const { return data + poolOffset(); }
+    size_t poolSize() const { return header->poolSize; }
+
+    // Copies a pooled string out; returns an empty string for out-of-range references
+    std::string text(SnapshotString ref) const
+    {
+        if ((uint64_t)ref.offset + ref.length > header->poolSize)
+            return std::string();
+        return std::string(view(ref));
+    }
+
+    // Like text, without copying; valid while the snapshot stays open
+    std::string_view view(SnapshotString ref) const
+    {
+        if ((uint64_t)ref.offset + ref.length > header->poolSize)
+            return std::string_view();
+        return std::string_view(pool() + ref.offset, ref.length);
+    }
+};
+
+// Returns the modification time of a file, or 0 if it does not exist
+inline time_t fileModifiedTime(const std::string &path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+// Returns the size of a file in bytes, or 0 if it does not exist
+inline uint64_t fileSize(const std::string &path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? (uint64_t)info.st_size : 0;
+}
+
+#endif
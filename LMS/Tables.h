@@ -0,0 +1,408 @@
+// Record Storage
+// Books and students are stored column by column (struct of arrays) instead of
+// as vectors of objects with several std::string members each:
+//   - ISBNs, registration and phone numbers are fixed-width integers,
+//   - names, authors and emails live in one shared StringPool arena, interned,
+//     so a repeated author or surname is stored once,
+//   - copy counts sit in one contiguous int array.
+// A row is 28 bytes for a book and 36 for a student, plus its share of the
+// arena, with no per-row heap allocations. Scans over one field (copies,
+// ISBNs) touch only that field's array.
+//
+// A reference packs a 40-bit offset and a 24-bit length into 8 bytes, so the
+// pool holds up to 1 TB of text (a paged file easily outgrows 4 GB) and one
+// string is at most 16 MB. intern() throws std::length_error past either limit
+// rather than hand out a reference that wraps around.
+//
+// With a page cache budget (StringPool::usePagedFile) the text lives in a
+// paged scratch file instead of the arena (see PageCache.h), and strings are
+// no longer interned, as the interning table would itself be resident.
+// Rows are addressed by position. Removing one moves the last row into its
+// slot, so callers keeping position indexes fix up a single entry.
+
+#ifndef LMS_TABLES_H
+#define LMS_TABLES_H
+
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "PageCache.h"
+
+// Reference to a string in a StringPool
+struct PooledString
+{
+    static const uint64_t MAX_OFFSET = (1ull << 40) - 1;
+    static const uint64_t MAX_LENGTH = (1ull << 24) - 1;
+
+    uint64_t offset : 40;
+    uint64_t length : 24;
+};
+
+class StringPool
+{
+private:
+    std::vector<char> arena;
+    size_t garbage = 0; // Bytes of released references; an upper bound on the dead bytes
+
+    // Every distinct string in the arena, hashed by content into an
+    // open-addressing table of packed references (no allocation per entry)
+    static const uint64_t EMPTY_SLOT = UINT64_MAX;
+    std::vector<uint64_t> slots;
+    size_t distinct = 0;
+
+    // Set in paged mode, where the arena stays empty
+    std::unique_ptr<PagedFile> paged;
+
+    // A paged view is a copy in one of VIEW_SLOTS buffers per thread, valid
+    // until the same thread has taken VIEW_SLOTS more views (callers hold at
+    // most a few at once, e.g. two rows' titles while sorting)
+    static const size_t VIEW_SLOTS = 8;
+
+    std::string_view pagedView(PooledString ref) const
+    {
+        thread_local std::string buffers[VIEW_SLOTS];
+        thread_local size_t next = 0;
+        std::string &buffer = buffers[next++ % VIEW_SLOTS];
+        paged->read(ref.offset, ref.length, buffer);
+        return buffer;
+    }
+
+    static uint64_t pack(PooledString ref)
+    {
+        return (uint64_t)ref.offset << 24 | ref.length;
+    }
+
+    static PooledString unpack(uint64_t slot)
+    {
+        return {slot >> 24, slot & PooledString::MAX_LENGTH};
+    }
+
+    // The reference for text appended at offset; throws if it would not fit
+    static PooledString place(uint64_t offset, std::string_view text)
+    {
+        if (text.size() > PooledString::MAX_LENGTH || offset + text.size() > PooledString::MAX_OFFSET)
+            throw std::length_error("StringPool: string or pool too large for a 40-bit reference");
+        return {offset, text.size()};
+    }
+
+    // Slot holding text, or the empty slot where it would go
+    size_t findSlot(std::string_view text) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = std::hash<std::string_view>()(text) & mask;
+        while (slots[i] != EMPTY_SLOT && view(unpack(slots[i])) != text)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    // Doubles the table (or creates it) and re-inserts every reference
+    void grow()
+    {
+        std::vector<uint64_t> old(slots.empty() ? 1024 : slots.size() * 2, EMPTY_SLOT);
+        old.swap(slots);
+        for (uint64_t slot : old)
+            if (slot != EMPTY_SLOT)
+                slots[findSlot(view(unpack(slot)))] = slot;
+    }
+
+public:
+    StringPool() = default;
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    // Moves the pool's text to a paged file at path, cached in at most
+    // budgetBytes of memory. Only for an empty pool; false if the file
+    // cannot be created, and the text then stays in memory.
+    bool usePagedFile(const std::string &path, size_t budgetBytes)
+    {
+        std::unique_ptr<PagedFile> file(new PagedFile());
+        if (!arena.empty() || !file->open(path, budgetBytes))
+            return false;
+        paged = std::move(file);
+        return true;
+    }
+
+    // The paged file, or nullptr when the text is in memory
+    const PagedFile *pagedFile() const
+    {
+        return paged.get();
+    }
+
+    // Returns the reference of an equal string already in the pool, or adds it
+    // (in paged mode always adds it)
+    PooledString intern(std::string_view text)
+    {
+        if (paged)
+        {
+            PooledString ref = place(paged->size(), text);
+            paged->append(text);
+            return ref;
+        }
+        if ((distinct + 1) * 10 > slots.size() * 7)
+            grow();
+        size_t i = findSlot(text);
+        if (slots[i] != EMPTY_SLOT)
+            return unpack(slots[i]);
+
+        PooledString ref = place(arena.size(), text);
+        arena.insert(arena.end(), text.begin(), text.end());
+        slots[i] = pack(ref);
+        distinct++;
+        return ref;
+    }
+
+    std::string_view view(PooledString ref) const
+    {
+        if (paged)
+            return pagedView(ref);
+        return std::string_view(arena.data() + ref.offset, ref.length);
+    }
+
+    // Starts a compaction: empties the pool and hands back the old arena. Every
+    // live reference must then be re-interned (see BookTable::repool). Not
+    // for paged mode, whose dead text is dropped at the next start instead.
+    std::vector<char> takeArena()
+    {
+        std::vector<char> old;
+        old.swap(arena);
+        slots.clear();
+        distinct = 0;
+        garbage = 0;
+        return old;
+    }
+
+    PooledString reintern(const std::vector<char> &oldArena, PooledString ref)
+    {
+        return intern(std::string_view(oldArena.data() + ref.offset, ref.length));
+    }
+
+    // Notes that a row referencing this string went away. Interned strings may
+    // still be shared, so this only tracks how much could be reclaimed.
+    void release(PooledString ref)
+    {
+        garbage += ref.length;
+    }
+
+    size_t bytes() const
+    {
+        return paged ? (size_t)paged->size() : arena.size();
+    }
+
+    size_t releasedBytes() const
+    {
+        return garbage;
+    }
+
+    // Heap use: the arena plus the interning table, or the page cache
+    size_t memoryUsage() const
+    {
+        if (paged)
+            return paged->memoryUsage();
+        return arena.capacity() + slots.capacity() * sizeof(uint64_t);
+    }
+
+    void reserve(size_t bytes)
+    {
+        if (!paged)
+            arena.reserve(bytes);
+    }
+
+    void clear()
+    {
+        slots.clear();
+        distinct = 0;
+        arena.clear();
+        garbage = 0;
+        if (paged)
+            paged->clear();
+    }
+};
+
+class BookTable
+{
+private:
+    std::vector<uint64_t> isbns;
+    std::vector<int32_t> copyCounts;
+    std::vector<PooledString> names;
+    std::vector<PooledString> authors;
+
+public:
+    size_t size() const
+    {
+        return isbns.size();
+    }
+
+    void reserve(size_t count)
+    {
+        isbns.reserve(count);
+        copyCounts.reserve(count);
+        names.reserve(count);
+        authors.reserve(count);
+    }
+
+    // Appends a row and returns its position
+    size_t add(StringPool &pool, uint64_t isbn, int copies, std::string_view name, std::string_view author)
+    {
+        isbns.push_back(isbn);
+        copyCounts.push_back(copies);
+        names.push_back(pool.intern(name));
+        authors.push_back(pool.intern(author));
+        return isbns.size() - 1;
+    }
+
+    // Removes the row at pos by moving the last row into its place
+    void removeAt(StringPool &pool, size_t pos)
+    {
+        pool.release(names[pos]);
+        pool.release(authors[pos]);
+        isbns[pos] = isbns.back();
+        copyCounts[pos] = copyCounts.back();
+        names[pos] = names.back();
+        authors[pos] = authors.back();
+        isbns.pop_back();
+        copyCounts.pop_back();
+        names.pop_back();
+        authors.pop_back();
+    }
+
+    uint64_t isbn(size_t pos) const
+    {
+        return isbns[pos];
+    }
+
+    int &copies(size_t pos)
+    {
+        return copyCounts[pos];
+    }
+
+    int copies(size_t pos) const
+    {
+        return copyCounts[pos];
+    }
+
+    PooledString nameRef(size_t pos) const
+    {
+        return names[pos];
+    }
+
+    PooledString authorRef(size_t pos) const
+    {
+        return authors[pos];
+    }
+
+    // Re-interns every string reference after StringPool::takeArena
+    void repool(StringPool &pool, const std::vector<char> &oldArena)
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            names[i] = pool.reintern(oldArena, names[i]);
+            authors[i] = pool.reintern(oldArena, authors[i]);
+        }
+    }
+
+    size_t memoryUsage() const
+    {
+        return isbns.capacity() * sizeof(uint64_t) + copyCounts.capacity() * sizeof(int32_t) +
+               (names.capacity() + authors.capacity()) * sizeof(PooledString);
+    }
+
+    void clear()
+    {
+        isbns.clear();
+        copyCounts.clear();
+        names.clear();
+        authors.clear();
+    }
+};
+
+class StudentTable
+{
+private:
+    std::vector<uint32_t> regs;
+    std::vector<uint64_t> phones;
+    std::vector<PooledString> firstNames;
+    std::vector<PooledString> lastNames;
+    std::vector<PooledString> emails;
+
+public:
+    size_t size() const
+    {
+        return regs.size();
+    }
+
+    void reserve(size_t count)
+    {
+        regs.reserve(count);
+        phones.reserve(count);
+        firstNames.reserve(count);
+        lastNames.reserve(count);
+        emails.reserve(count);
+    }
+
+    size_t add(StringPool &pool, uint32_t reg, uint64_t phone, std::string_view firstName, std::string_view lastName,
+               std::string_view email)
+    {
+        regs.push_back(reg);
+        phones.push_back(phone);
+        firstNames.push_back(pool.intern(firstName));
+        lastNames.push_back(pool.intern(lastName));
+        emails.push_back(pool.intern(email));
+        return regs.size() - 1;
+    }
+
+    uint32_t reg(size_t pos) const
+    {
+        return regs[pos];
+    }
+
+    uint64_t phone(size_t pos) const
+    {
+        return phones[pos];
+    }
+
+    PooledString firstNameRef(size_t pos) const
+    {
+        return firstNames[pos];
+    }
+
+    PooledString lastNameRef(size_t pos) const
+    {
+        return lastNames[pos];
+    }
+
+    PooledString emailRef(size_t pos) const
+    {
+        return emails[pos];
+    }
+
+    void repool(StringPool &pool, const std::vector<char> &oldArena)
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            firstNames[i] = pool.reintern(oldArena, firstNames[i]);
+            lastNames[i] = pool.reintern(oldArena, lastNames[i]);
+            emails[i] = pool.reintern(oldArena, emails[i]);
+        }
+    }
+
+    size_t memoryUsage() const
+    {
+        return regs.capacity() * sizeof(uint32_t) + phones.capacity() * sizeof(uint64_t) +
+               (firstNames.capacity() + lastNames.capacity() + emails.capacity()) * sizeof(PooledString);
+    }
+
+    void clear()
+    {
+        regs.clear();
+        phones.clear();
+        firstNames.clear();
+        lastNames.clear();
+        emails.clear();
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+// Input Validation
+// Hand-written scanners for every field the system accepts. Character classes
+// are 256-entry lookup tables built at compile time, so a check is one table
+// load per character with no regex compilation or backtracking.
+//
+// Email: [a-zA-Z0-9._%+-]+ followed by @gmail.com, @outlook.com or @lpu.in
+// Phone: 10 digits, starts with 6-9
+// Reg. No: 8 digits
+// ISBN: 13 digits; isValidIsbn13Checksum also verifies the ISBN-13 check digit
+// Book name: [a-zA-Z0-9 .,-]+   Author: [a-zA-Z .,-]+
+
+#ifndef LMS_VALIDATION_H
+#define LMS_VALIDATION_H
+
+#include <string>
+#include <cstring>
+
+class CharClass
+{
+private:
+    bool table[256] = {};
+
+public:
+    // ranges lists pairs of inclusive bounds ("azAZ09"), extra lists single characters
+    constexpr CharClass(const char *ranges, const char *extra)
+    {
+        for (int i = 0; ranges[i] && ranges[i + 1]; i += 2)
+            for (int c = (unsigned char)ranges[i]; c <= (unsigned char)ranges[i + 1]; c++)
+                table[c] = true;
+        for (int i = 0; extra[i]; i++)
+            table[(unsigned char)extra[i]] = true;
+    }
+
+    constexpr bool contains(char c) const
+    {
+        return table[(unsigned char)c];
+    }
+
+    // True if text is non-empty and every character belongs to the class
+    bool matchesAll(const char *text, size_t length) const
+    {
+        if (length == 0)
+            return false;
+        for (size_t i = 0; i < length; i++)
+            if (!table[(unsigned char)text[i]])
+                return false;
+        return true;
+    }
+};
+
+constexpr CharClass DIGITS("09", "");
+constexpr CharClass EMAIL_LOCAL("azAZ09", "._%+-");
+constexpr CharClass BOOK_NAME_CHARS("azAZ09", " .,-");
+constexpr CharClass AUTHOR_CHARS("azAZ", " .,-");
+
+inline bool isAllDigits(const std::string &text, size_t length)
+{
+    return text.length() == length && DIGITS.matchesAll(text.data(), length);
+}
+
+inline bool isValidRegNumber(const std::string &reg)
+{
+    return isAllDigits(reg, 8);
+}
+
+inline bool isValidPhone(const std::string &phone)
+{
+    return isAllDigits(phone, 10) && phone[0] >= '6';
+}
+
+inline bool isValidIsbn(const std::string &isbn)
+{
+    return isAllDigits(isbn, 13);
+}
+
+// ISBN-13 check digit: digits are weighted 1,3,1,3,... and the weighted sum must be a multiple of 10
+inline bool isValidIsbn13Checksum(const std::string &isbn)
+{
+    if (!isValidIsbn(isbn))
+        return false;
+
+    int sum = 0;
+    for (int i = 0; i < 13; i++)
+        sum += (isbn[i] - '0') * (i % 2 == 0 ? 1 : 3);
+    return sum % 10 == 0;
+}
+
+inline bool isValidEmail(const std::string &email)
+{
+    static const char *const DOMAINS[] = {"gmail.com", "outlook.com", "lpu.in"};
+
+    size_t at = email.find('@');
+    if (at == std::string::npos || !EMAIL_LOCAL.matchesAll(email.data(), at))
+        return false;
+
+    const char *domain = email.data() + at + 1;
+    size_t domainLength = email.length() - at - 1;
+    for (const char *allowed : DOMAINS)
+        if (domainLength == strlen(allowed) && memcmp(domain, allowed, domainLength) == 0)
+            return true;
+    return false;
+}
+
+inline bool isValidBookName(const std::string &name)
+{
+    return BOOK_NAME_CHARS.matchesAll(name.data(), name.length());
+}
+
+inline bool isValidAuthorName(const std::string &author)
+{
+    return AUTHOR_CHARS.matchesAll(author.data(), author.length());
+}
+
+#endif
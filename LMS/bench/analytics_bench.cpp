@@ -0,0 +1,161 @@
+// Analytics Benchmark
+// Writes a synthetic circulation history (default ten million issues and
+// returns over five years, 64 MB log files like circulation_log.txt.N) with
+// Zipf-like title popularity, then times Analytics::rebuild over it with
+// 1, 2, 4, ... threads up to the core count, and the cost of recording one
+// issue and return on the live path. Every rebuild is checked against totals
+// kept while generating: issues, returns, the most borrowed title's count and
+// its time on loan.
+//
+// Build: cmake --build <build dir> --target analytics_bench
+// Usage: ./analytics_bench [events, default 10000000] [directory, default /tmp] [threads, default 1,2,4,..,cores]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Analytics.h"
+#include "DurableFile.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+const size_t TITLES = 200000;
+const uint32_t STUDENTS = 50000;
+const uint64_t FILE_BYTES = 64 * 1024 * 1024;
+
+void appendIso(DurableWriter &out, time_t at)
+{
+    tm t;
+    gmtime_r(&at, &t);
+    out.appendNumber(t.tm_year + 1900, 4).append('-').appendNumber(t.tm_mon + 1, 2).append('-');
+    out.appendNumber(t.tm_mday, 2).append('T').appendNumber(t.tm_hour, 2).append(':');
+    out.appendNumber(t.tm_min, 2).append(':').appendNumber(t.tm_sec, 2).append(".000Z");
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t events = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    string dir = argc > 2 ? argv[2] : "/tmp";
+    vector<unsigned> threadCounts;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    if (argc > 3)
+    {
+        stringstream list(argv[3]);
+        string item;
+        while (getline(list, item, ','))
+            threadCounts.push_back((unsigned)atoi(item.c_str()));
+    }
+    else
+    {
+        for (unsigned t = 1; t < cores; t *= 2)
+            threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    // Zipf-like popularity: title i is picked with probability ~ 1/(i+1)
+    vector<double> weights(TITLES);
+    for (size_t i = 0; i < TITLES; i++)
+        weights[i] = 1.0 / (double)(i + 1);
+    discrete_distribution<size_t> pickTitle(weights.begin(), weights.end());
+    uniform_int_distribution<uint32_t> pickStudent(0, STUDENTS - 1);
+    uniform_int_distribution<int> loanSeconds(3600, 21 * 86400);
+    mt19937_64 random(42);
+
+    time_t now = time(0), start = now - 5 * 365 * 86400LL;
+    uint64_t loans = events / 2;
+    vector<uint64_t> titleIssues(TITLES);
+    vector<int64_t> titleBusy(TITLES);
+    vector<Analytics::HistoryFile> files;
+    auto generateStart = Clock::now();
+    {
+        // Oldest file first, the way AuditLog's rotated files are numbered
+        vector<string> paths;
+        DurableWriter *out = nullptr;
+        auto openNext = [&]
+        {
+            paths.push_back(dir + "/analytics_bench_log." + to_string(paths.size()));
+            delete out;
+            out = new DurableWriter(paths.back());
+        };
+        openNext();
+        for (uint64_t i = 0; i < loans; i++)
+        {
+            size_t title = pickTitle(random);
+            uint32_t reg = 10000000 + pickStudent(random);
+            uint64_t isbn = 9780000000000ull + title;
+            time_t issuedAt = start + (time_t)((now - 30 * 86400 - start) * (double)i / loans);
+            time_t returnedAt = issuedAt + loanSeconds(random);
+            titleIssues[title]++;
+            titleBusy[title] += returnedAt - issuedAt;
+            for (int returned = 0; returned < 2; returned++)
+            {
+                appendIso(*out, returned ? returnedAt : issuedAt);
+                out->append(returned ? " RETURN " : " ISSUE ").appendNumber(reg, 8).append(' ').appendNumber(isbn, 13).append('\n');
+            }
+            if (out->size() >= FILE_BYTES)
+            {
+                files.push_back({paths.back(), out->size()});
+                out->commit();
+                openNext();
+            }
+        }
+        files.push_back({paths.back(), out->size()});
+        out->commit();
+        delete out;
+    }
+    uint64_t bytes = 0;
+    for (const auto &file : files)
+        bytes += file.size;
+    printf("history: %llu events, %zu files, %.0f MB, written in %.1f s\n\n", (unsigned long long)loans * 2,
+           files.size(), bytes / 1048576.0, chrono::duration<double>(Clock::now() - generateStart).count());
+
+    size_t top = max_element(titleIssues.begin(), titleIssues.end()) - titleIssues.begin();
+    printf("%-8s %12s %14s %10s %9s  %s\n", "threads", "seconds", "events/sec", "MB/s", "speedup", "check");
+    double single = 0;
+    for (unsigned threads : threadCounts)
+    {
+        auto analytics = make_unique<Analytics>();
+        Analytics::RebuildStats stats;
+        analytics->rebuild(files, threads, now, &stats);
+        if (!single)
+            single = stats.seconds;
+
+        uint64_t isbn = 9780000000000ull + top;
+        vector<Analytics::Counter> heaviest = analytics->topTitleCounters(1);
+        bool ok = stats.events == loans * 2 && analytics->issues() == loans && analytics->returns() == loans &&
+                  !heaviest.empty() && heaviest[0].key == isbn && heaviest[0].count == titleIssues[top] &&
+                  analytics->busySeconds(isbn, 0, now) == titleBusy[top];
+        printf("%-8u %12.3f %14.0f %10.1f %8.2fx  %s\n", stats.threads, stats.seconds, stats.events / stats.seconds,
+               stats.bytes / 1048576.0 / stats.seconds, single / stats.seconds, ok ? "ok" : "MISMATCH");
+    }
+
+    // The live path: what issueBook/returnBook pay per call
+    {
+        auto analytics = make_unique<Analytics>();
+        const int CALLS = 2000000;
+        vector<pair<uint32_t, uint64_t>> sample(CALLS);
+        for (auto &call : sample)
+            call = {10000000 + pickStudent(random), 9780000000000ull + pickTitle(random)};
+        auto begin = Clock::now();
+        for (const auto &call : sample)
+        {
+            analytics->recordIssue(call.first, call.second, now);
+            analytics->recordReturn(call.second, now + 86400);
+        }
+        double seconds = chrono::duration<double>(Clock::now() - begin).count();
+        printf("\nrecordIssue + recordReturn: %.0f ns per loan\n", seconds * 1e9 / CALLS);
+    }
+
+    for (const auto &file : files)
+        remove(file.path.c_str());
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Concurrency Stress
+// Hammers one LMS instance with random issue/return requests from N threads.
+// Most requests go to a small set of single-copy "hot" titles and a small
+// student pool, so the copy counter and the 3-book limit are raced constantly.
+// After each run it checks that:
+//   - no title has negative copies,
+//   - copies on the shelf + copies on loan equal the starting stock,
+//   - no student holds more than 3 books (also checked after every issue),
+//   - every successful issue can be returned exactly once.
+// Exits non-zero if any check fails.
+//
+// Build: g++ -O2 -std=c++17 -pthread -I.. concurrency_stress.cpp -o concurrency_stress
+// Usage: ./concurrency_stress [max threads, default: hardware threads] [operations per thread, default 100000]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <thread>
+#include "LMS.h"
+
+const int TITLES = 2000;
+const int HOT_TITLES = 16;
+const int STUDENTS = 400;
+const int COPIES = 2;
+
+string isbnFor(int i)
+{
+    return to_string(9780000000000ull + i);
+}
+
+string regFor(int i)
+{
+    return to_string(20000000 + i);
+}
+
+// Fills dir with a fresh catalog: hot titles have one copy, the rest COPIES each
+void writeDataFiles(const string &dir)
+{
+    ofstream books(dir + "/books.txt");
+    for (int i = 0; i < TITLES; i++)
+        books << "Title " << i << ",Author " << i % 50 << "," << isbnFor(i) << " " << (i < HOT_TITLES ? 1 : COPIES) << "\n";
+
+    ofstream students(dir + "/students.txt");
+    for (int i = 0; i < STUDENTS; i++)
+        students << "First" << i << " Last" << i << " " << regFor(i) << " 9" << 100000000 + i << " s" << i << "@lpu.in\n";
+
+    ofstream(dir + "/issued_books.txt");
+    ofstream(dir + "/journal.log");
+}
+
+void removeDataFiles(const string &dir)
+{
+    for (const char *name : {"books.txt", "students.txt", "issued_books.txt", "journal.log", "login_log.txt",
+                             "circulation_log.txt"})
+        remove((dir + "/" + name).c_str());
+    remove(dir.c_str());
+}
+
+struct RunResult
+{
+    double opsPerSecond;
+    size_t issued;
+    size_t returned;
+    bool ok;
+};
+
+RunResult run(int threads, int opsPerThread)
+{
+    char pattern[] = "/tmp/lms-stress-XXXXXX";
+    string dir = mkdtemp(pattern);
+    writeDataFiles(dir);
+
+    RunResult result = {0, 0, 0, true};
+    {
+        LMS library(dir);
+        atomic<size_t> issued{0}, returned{0}, limitViolations{0}, lostLoans{0};
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]()
+                                 {
+                mt19937 rng(1234 + t);
+                vector<pair<string, string>> held; // Loans this thread made and has not returned yet
+                for (int i = 0; i < opsPerThread; i++)
+                {
+                    if (held.empty() || rng() % 2 == 0)
+                    {
+                        string reg = regFor(rng() % STUDENTS);
+                        string isbn = isbnFor(rng() % 4 == 0 ? rng() % TITLES : rng() % HOT_TITLES);
+                        if (library.issueBook(reg, isbn) == Status::Ok)
+                        {
+                            issued++;
+                            held.push_back({reg, isbn});
+                            if (library.issuedCount(reg) > 3)
+                                limitViolations++;
+                        }
+                    }
+                    else
+                    {
+                        size_t pick = rng() % held.size();
+                        if (library.returnBook(held[pick].first, held[pick].second) == Status::Ok)
+                            returned++;
+                        else
+                            lostLoans++;
+                        held[pick] = held.back();
+                        held.pop_back();
+                    }
+                } });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        result.opsPerSecond = (double)threads * opsPerThread / seconds;
+        result.issued = issued;
+        result.returned = returned;
+
+        if (lostLoans > 0)
+        {
+            printf("  FAIL: %zu loans could not be returned\n", (size_t)lostLoans);
+            result.ok = false;
+        }
+        if (limitViolations > 0)
+        {
+            printf("  FAIL: a student exceeded 3 books %zu times\n", (size_t)limitViolations);
+            result.ok = false;
+        }
+        for (int i = 0; i < TITLES; i++)
+        {
+            optional<Record> book = library.getBook(isbnFor(i));
+            int stock = i < HOT_TITLES ? 1 : COPIES;
+            if (!book || book->copies < 0 || book->copies + library.onLoanCount(isbnFor(i)) != stock)
+            {
+                printf("  FAIL: %s has %d copies on the shelf and %d on loan, expected %d in total\n",
+                       isbnFor(i).c_str(), book ? book->copies : -1, library.onLoanCount(isbnFor(i)), stock);
+                result.ok = false;
+            }
+        }
+        for (int i = 0; i < STUDENTS; i++)
+        {
+            if (library.issuedCount(regFor(i)) > 3)
+            {
+                printf("  FAIL: student %s holds %d books\n", regFor(i).c_str(), library.issuedCount(regFor(i)));
+                result.ok = false;
+            }
+        }
+    }
+    removeDataFiles(dir);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxThreads = argc > 1 ? atoi(argv[1]) : max(1u, thread::hardware_concurrency());
+    int opsPerThread = argc > 2 ? atoi(argv[2]) : 100000;
+
+    bool ok = true;
+    printf("%8s %14s %10s %10s  %s\n", "threads", "ops/sec", "issued", "returned", "invariants");
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        RunResult result = run(threads, opsPerThread);
+        printf("%8d %14.0f %10zu %10zu  %s\n", threads, result.opsPerSecond, result.issued, result.returned,
+               result.ok ? "ok" : "FAILED");
+        ok = ok && result.ok;
+        if (threads < maxThreads && threads * 2 > maxThreads)
+            threads = maxThreads / 2; // Finish with exactly maxThreads
+    }
+    return ok ? 0 : 1;
+}
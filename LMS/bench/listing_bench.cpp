@@ -0,0 +1,97 @@
+// Listing Benchmark
+// Loads a synthetic catalog of N books (default 500000) and measures:
+//   - printing every row with the old setw chain and endl versus TextTable,
+//     both written to a file (or /dev/null) so terminal speed does not count,
+//   - paging through listBooks in each sort order: the first page (which
+//     builds the cached order) and the pages after it.
+//
+// Build: g++ -O2 -std=c++17 -I.. listing_bench.cpp -o listing_bench
+// Usage: ./listing_bench [books, default 500000] [output file, default /dev/null]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include "LMS.h"
+
+typedef chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start)
+{
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500000;
+    string outputPath = argc > 2 ? argv[2] : "/dev/null";
+
+    char pattern[] = "/tmp/lms-listing-XXXXXX";
+    string dir = mkdtemp(pattern);
+    {
+        mt19937 rng(5);
+        ofstream books(dir + "/books.txt");
+        for (size_t i = 0; i < count; i++)
+            books << "Title " << rng() % 1000000 << ",Author " << rng() % 5000 << "," << 9780000000000ull + i << " "
+                  << rng() % 10 << "\n";
+    }
+
+    {
+        LMS library(dir);
+        vector<Record> rows;
+        library.listBooks(BookOrder::Catalog, false, "", count, rows);
+
+        // Whole catalog, old way: one setw chain and one flush per row
+        {
+            ofstream out(outputPath);
+            auto start = Clock::now();
+            for (const auto &book : rows)
+                out << left << setw(30) << book.bookName << setw(25) << book.author << setw(20) << book.isbn << setw(10)
+                    << book.copies << endl;
+            printf("%-34s %10.1f ms\n", "print all, setw + endl", secondsSince(start) * 1000);
+        }
+        {
+            ofstream out(outputPath);
+            auto start = Clock::now();
+            TextTable table;
+            for (const auto &book : rows)
+                table.cell(book.bookName, 30).cell(book.author, 25).cell(book.isbn, 20).cell(book.copies).endRow();
+            table.flush(out);
+            printf("%-34s %10.1f ms\n", "print all, TextTable", secondsSince(start) * 1000);
+        }
+
+        const size_t PAGE = 25;
+        const int PAGES = 1000;
+        const char *names[] = {"catalog", "title", "author", "copies"};
+        printf("\n%-10s %18s %22s\n", "order", "first page (ms)", "next pages (us/page)");
+        for (int order = 0; order < 4; order++)
+        {
+            auto start = Clock::now();
+            library.listBooks((BookOrder)order, false, "", PAGE, rows);
+            double first = secondsSince(start) * 1000;
+
+            start = Clock::now();
+            int pages = 0;
+            for (; pages < PAGES && rows.size() == PAGE; pages++)
+                library.listBooks((BookOrder)order, false, rows.back().isbn, PAGE, rows);
+            printf("%-10s %18.1f %22.2f\n", names[order], first, secondsSince(start) * 1e6 / max(pages, 1));
+        }
+
+        // An issue changes a shelf count, so only the copies order is rebuilt
+        library.addStudent("Bench", "Reader", "20000000", "9000000000", "bench@lpu.in");
+        library.issueBook("20000000", "9780000000000");
+        auto start = Clock::now();
+        library.listBooks(BookOrder::Title, false, "", PAGE, rows);
+        double title = secondsSince(start) * 1000;
+        start = Clock::now();
+        library.listBooks(BookOrder::Copies, false, "", PAGE, rows);
+        printf("\nafter an issue: title page %.3f ms, copies page %.1f ms\n", title, secondsSince(start) * 1000);
+    }
+
+    for (const char *name : {"books.txt", "students.txt", "issued_books.txt", "journal.log", "login_log.txt",
+                             "circulation_log.txt"})
+        remove((dir + "/" + name).c_str());
+    remove(dir.c_str());
+    return 0;
+}
@@ -0,0 +1,356 @@
+// Transaction Benchmark
+// Generates a synthetic library (books.txt, students.txt, issued_books.txt)
+// at a chosen scale and times the operations of one LMS instance against it:
+//   - load_books, load_students: the constructor on a directory holding only
+//     that file; load_all: all three files (text path)
+//   - issue, return, add_book, delete_book: per-call latency over random cycles
+//   - search, list_first_page, list_next_page
+//   - import_students: a CSV of --students new students (every reg. number,
+//     phone and email checked for uniqueness), including the save at the end
+//   - save_text (checkpoint), save_snapshot, load_snapshot
+// Results are printed to stdout as one JSON object, so runs can be stored and
+// compared; progress goes to stderr.
+//
+// Build: cmake --build <build dir> --target lms_bench
+// Usage: ./lms_bench [--books N] [--students N] [--loans N] [--ops N]
+//                    [--dir path] [--keep] [--generate-only]
+//   --books      catalog size, default 100000 (10k to 10M are sensible)
+//   --students   default books / 10, --loans default students / 2 (at most 3 per student)
+//   --ops        issue/return cycles, default 100000; add/delete uses ops / 10
+//   --dir        where to put the data (default: a new directory under /tmp)
+//   --keep       leave the data behind; --generate-only writes it and exits
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include "LMS.h"
+
+typedef chrono::steady_clock Clock;
+
+struct Result
+{
+    string name;
+    size_t ops = 0;
+    double seconds = 0;
+    vector<double> latencies; // Microseconds; empty for one-shot phases
+};
+
+vector<Result> results;
+
+double secondsSince(Clock::time_point start)
+{
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Times fn() once as a phase of its own
+template <class Fn>
+void phase(const string &name, Fn fn)
+{
+    fprintf(stderr, "%-16s ", name.c_str());
+    auto start = Clock::now();
+    fn();
+    Result result;
+    result.name = name;
+    result.ops = 1;
+    result.seconds = secondsSince(start);
+    fprintf(stderr, "%10.3f s\n", result.seconds);
+    results.push_back(result);
+}
+
+// Collects per-call latencies for an operation timed many times
+struct Recorder
+{
+    Result result;
+
+    explicit Recorder(const string &name, size_t expected)
+    {
+        result.name = name;
+        result.latencies.reserve(expected);
+    }
+
+    template <class Fn>
+    auto time(Fn fn)
+    {
+        auto start = Clock::now();
+        auto value = fn();
+        double us = chrono::duration<double, micro>(Clock::now() - start).count();
+        result.latencies.push_back(us);
+        result.seconds += us / 1e6;
+        result.ops++;
+        return value;
+    }
+
+    void finish()
+    {
+        fprintf(stderr, "%-16s %10zu ops %12.0f ops/s\n", result.name.c_str(), result.ops,
+                result.ops / max(result.seconds, 1e-9));
+        results.push_back(std::move(result));
+    }
+};
+
+double percentile(const vector<double> &sorted, double p)
+{
+    return sorted.empty() ? 0 : sorted[min(sorted.size() - 1, (size_t)(sorted.size() * p))];
+}
+
+void printJson(size_t books, size_t students, size_t loans, size_t ops)
+{
+    printf("{\n  \"benchmark\": \"lms_bench\",\n");
+    printf("  \"books\": %zu, \"students\": %zu, \"loans\": %zu, \"ops\": %zu,\n", books, students, loans, ops);
+    printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        Result &r = results[i];
+        sort(r.latencies.begin(), r.latencies.end());
+        printf("    {\"name\": \"%s\", \"ops\": %zu, \"seconds\": %.6f, \"ops_per_sec\": %.1f", r.name.c_str(), r.ops,
+               r.seconds, r.ops / max(r.seconds, 1e-9));
+        if (!r.latencies.empty())
+            printf(", \"p50_us\": %.2f, \"p90_us\": %.2f, \"p99_us\": %.2f, \"p999_us\": %.2f, \"max_us\": %.2f",
+                   percentile(r.latencies, 0.5), percentile(r.latencies, 0.9), percentile(r.latencies, 0.99),
+                   percentile(r.latencies, 0.999), r.latencies.back());
+        printf("}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+// ISBN-13 with a valid check digit; prefix is the first 12 digits
+string isbnWithCheckDigit(uint64_t prefix)
+{
+    string isbn = unpackKey(prefix, 12);
+    int sum = 0;
+    for (int i = 0; i < 12; i++)
+        sum += (isbn[i] - '0') * (i % 2 == 0 ? 1 : 3);
+    return isbn + char('0' + (10 - sum % 10) % 10);
+}
+
+uint64_t bookKey(size_t i)
+{
+    return 9780000000000ull + i;
+}
+
+uint32_t studentKey(size_t i)
+{
+    return 10000000 + (uint32_t)i;
+}
+
+void generate(const string &dir, size_t books, size_t students, size_t loans)
+{
+    static const char *words[] = {"History", "Garden", "River", "Night", "Code", "Empire", "Stone", "Winter", "Light",
+                                  "Ocean", "Machine", "Silent", "Golden", "Storm", "City", "Forest"};
+    mt19937 rng(2024);
+    string buffer;
+    buffer.reserve(1 << 20);
+    auto flushTo = [&](FILE *file, bool force)
+    {
+        if (force || buffer.size() > (1 << 20) - 256)
+        {
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            buffer.clear();
+        }
+    };
+
+    FILE *file = fopen((dir + "/books.txt").c_str(), "wb");
+    for (size_t i = 0; i < books; i++)
+    {
+        buffer += words[rng() % 16];
+        buffer += ' ';
+        buffer += words[rng() % 16];
+        buffer += ' ';
+        buffer += to_string(rng() % 100000);
+        buffer += ",Author ";
+        buffer += to_string(rng() % 50000);
+        buffer += ',';
+        buffer += to_string(bookKey(i));
+        buffer += ' ';
+        buffer += to_string(1 + rng() % 10);
+        buffer += '\n';
+        flushTo(file, false);
+    }
+    flushTo(file, true);
+    fclose(file);
+
+    file = fopen((dir + "/students.txt").c_str(), "wb");
+    for (size_t i = 0; i < students; i++)
+    {
+        buffer += "First" + to_string(rng() % 2000) + " Last" + to_string(rng() % 5000) + " " + to_string(studentKey(i)) +
+                  " " + to_string(9000000000ull + i) + " s" + to_string(i) + "@lpu.in\n";
+        flushTo(file, false);
+    }
+    flushTo(file, true);
+    fclose(file);
+
+    // Loan i goes to student i % students, so nobody holds more than 3 books
+    file = fopen((dir + "/issued_books.txt").c_str(), "wb");
+    long long now = time(0);
+    for (size_t i = 0; i < loans; i++)
+    {
+        buffer += to_string(studentKey(i % students)) + " " + to_string(bookKey((i * 7919) % books)) + " " +
+                  to_string(now - (long long)(rng() % (30 * 86400))) + "\n";
+        flushTo(file, false);
+    }
+    flushTo(file, true);
+    fclose(file);
+}
+
+// A directory holding a link to a single data file, for timing one loader alone
+string singleFileDir(const string &dir, const string &name)
+{
+    string sub = dir + "/only_" + name;
+    filesystem::create_directory(sub);
+    filesystem::create_symlink(filesystem::absolute(dir + "/" + name), sub + "/" + name);
+    return sub;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t books = 100000, students = 0, loans = SIZE_MAX, ops = 100000;
+    string dir;
+    bool keep = false, generateOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--books" && hasValue)
+            books = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--students" && hasValue)
+            students = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--loans" && hasValue)
+            loans = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--ops" && hasValue)
+            ops = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--dir" && hasValue)
+            dir = argv[++i];
+        else if (arg == "--keep")
+            keep = true;
+        else if (arg == "--generate-only")
+            generateOnly = keep = true;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--books N] [--students N] [--loans N] [--ops N] [--dir path] [--keep] "
+                            "[--generate-only]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    books = max<size_t>(books, 1);
+    students = max<size_t>(students ? students : books / 10, 1);
+    loans = min(loans == SIZE_MAX ? students / 2 : loans, min(students * 3, books));
+    if (dir.empty())
+    {
+        char pattern[] = "/tmp/lms-bench-XXXXXX";
+        dir = mkdtemp(pattern);
+    }
+    else
+        filesystem::create_directories(dir);
+    fprintf(stderr, "data in %s: %zu books, %zu students, %zu loans\n", dir.c_str(), books, students, loans);
+
+    phase("generate", [&]()
+          { generate(dir, books, students, loans); });
+    if (generateOnly)
+        return 0;
+
+    // Each loader on its own; the destructors' checkpoints are not timed
+    {
+        string booksDir = singleFileDir(dir, "books.txt");
+        string studentsDir = singleFileDir(dir, "students.txt");
+        unique_ptr<LMS> library;
+        phase("load_books", [&]()
+              { library.reset(new LMS(booksDir)); });
+        library.reset();
+        phase("load_students", [&]()
+              { library.reset(new LMS(studentsDir)); });
+        library.reset();
+        filesystem::remove_all(booksDir);
+        filesystem::remove_all(studentsDir);
+    }
+
+    unique_ptr<LMS> library;
+    phase("load_all", [&]()
+          { library.reset(new LMS(dir)); });
+
+    mt19937 rng(7);
+    {
+        Recorder issue("issue", ops), giveBack("return", ops);
+        for (size_t i = 0; i < ops; i++)
+        {
+            string reg = to_string(studentKey(rng() % students));
+            string isbn = to_string(bookKey(rng() % books));
+            if (issue.time([&]()
+                           { return library->issueBook(reg, isbn); }) == Status::Ok)
+                giveBack.time([&]()
+                              { return library->returnBook(reg, isbn); });
+        }
+        issue.finish();
+        giveBack.finish();
+    }
+    {
+        size_t cycles = max<size_t>(ops / 10, 1);
+        Recorder add("add_book", cycles), remove("delete_book", cycles);
+        for (size_t i = 0; i < cycles; i++)
+        {
+            string isbn = isbnWithCheckDigit(979000000000ull + i);
+            add.time([&]()
+                     { return library->addBook("Benchmark Title " + to_string(i), "Bench Author", isbn, 2); });
+            remove.time([&]()
+                        { return library->deleteBook(isbn, 2); });
+        }
+        add.finish();
+        remove.finish();
+    }
+    {
+        const char *queries[] = {"river", "golden sto", "author 42", "night c", "history garden ", "ocean 123"};
+        Recorder search("search", 1000);
+        for (int i = 0; i < 1000; i++)
+            search.time([&]()
+                        { return library->searchBooks(queries[i % 6]).size(); });
+        search.finish();
+    }
+    {
+        vector<Record> page;
+        Recorder first("list_first_page", 1), next("list_next_page", 1000);
+        first.time([&]()
+                   { return library->listBooks(BookOrder::Title, false, "", 25, page); });
+        for (int i = 0; i < 1000 && page.size() == 25; i++)
+        {
+            string cursor = page.back().isbn;
+            next.time([&]()
+                      { return library->listBooks(BookOrder::Title, false, cursor, 25, page); });
+        }
+        first.finish();
+        next.finish();
+    }
+    {
+        string csv = dir + "/new_students.csv";
+        FILE *file = fopen(csv.c_str(), "wb");
+        fprintf(file, "first_name,last_name,reg_number,phone,email\n");
+        for (size_t i = 0; i < students; i++)
+            fprintf(file, "New%zu,Student,%u,%llu,n%zu@gmail.com\n", i % 1000, 50000000 + (uint32_t)i,
+                    8000000000ull + i, i);
+        fclose(file);
+        LMS::ImportReport report;
+        phase("import_students", [&]()
+              { report = library->importStudents(csv); });
+        if (report.added != students)
+            fprintf(stderr, "import_students: only %zu of %zu rows added\n", report.added, students);
+    }
+    phase("save_text", [&]()
+          { library->checkpoint(); });
+    library.reset();
+
+    // Binary snapshot: written by a checkpoint in snapshot mode, then mapped at startup
+    library.reset(new LMS(dir, true));
+    phase("save_snapshot", [&]()
+          { library->checkpoint(); });
+    library.reset();
+    phase("load_snapshot", [&]()
+          { library.reset(new LMS(dir, true)); });
+    library.reset();
+
+    printJson(books, students, loans, ops);
+    if (!keep)
+        filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,238 @@
+// Load Generator for Server Mode (Linux)
+// Opens many client connections to a running "LMS --serve" process and keeps
+// one request outstanding on each (closed loop): issue a random book to a
+// random student, then return it, and repeat. Every request's round-trip time
+// is recorded and latency percentiles are reported at the end.
+//
+// ISBNs and registration numbers are taken from the server's books.txt and
+// students.txt, so most requests hit real records.
+//
+// The server requires a login unless it was started with --no-login: given a
+// user and password, the first connection logs in and the others resume its
+// session, before the clock starts.
+//
+// Build: g++ -O2 -std=c++17 loadgen.cpp -o loadgen
+// Usage: ./loadgen <unix:path | tcp:port> [connections=100] [requests=200000] [data dir=.] [user password]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+struct Client
+{
+    int fd = -1;
+    string reg;
+    string isbn;
+    bool issuing = true; // Next request is an issue (true) or the matching return
+    Clock::time_point sentAt;
+    string in;
+};
+
+int connectTo(const string &endpoint)
+{
+    int fd;
+    if (endpoint.compare(0, 5, "unix:") == 0)
+    {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, endpoint.c_str() + 5, sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+            return -1;
+    }
+    else
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)atoi(endpoint.c_str() + 4));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+            return -1;
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+// Reads the third-from-last token of each books.txt line (the ISBN sits before the copies)
+vector<string> readIsbns(const string &dir)
+{
+    vector<string> isbns;
+    ifstream file(dir + "/books.txt");
+    string line;
+    while (getline(file, line))
+    {
+        size_t space = line.rfind(' ');
+        size_t comma = space == string::npos ? string::npos : line.rfind(',', space);
+        if (comma != string::npos)
+            isbns.push_back(line.substr(comma + 1, space - comma - 1));
+    }
+    return isbns;
+}
+
+// Sends one command on a blocking socket and returns its response line, without the newline
+string exchange(int fd, const string &command)
+{
+    string line = command + "\n";
+    if (write(fd, line.data(), line.size()) != (ssize_t)line.size())
+        return "";
+    string response;
+    char c;
+    while (read(fd, &c, 1) == 1 && c != '\n')
+        response += c;
+    return response;
+}
+
+vector<string> readRegNumbers(const string &dir)
+{
+    vector<string> regs;
+    ifstream file(dir + "/students.txt");
+    string first, last, reg, phone, email;
+    while (file >> first >> last >> reg >> phone >> email)
+        regs.push_back(reg);
+    return regs;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <unix:path | tcp:port> [connections] [requests] [data dir] [user password]\n",
+                argv[0]);
+        return 1;
+    }
+    string endpoint = argv[1];
+    int connections = argc > 2 ? atoi(argv[2]) : 100;
+    long requests = argc > 3 ? atol(argv[3]) : 200000;
+    string dir = argc > 4 ? argv[4] : ".";
+    string user = argc > 6 ? argv[5] : "", password = argc > 6 ? argv[6] : "";
+
+    vector<string> isbns = readIsbns(dir);
+    vector<string> regs = readRegNumbers(dir);
+    if (isbns.empty() || regs.empty())
+    {
+        fprintf(stderr, "No books or students found in %s\n", dir.c_str());
+        return 1;
+    }
+
+    mt19937 rng(7);
+    int epollFd = epoll_create1(0);
+    vector<Client> clients(connections);
+    string token;
+    for (int i = 0; i < connections; i++)
+    {
+        clients[i].fd = connectTo(endpoint);
+        if (clients[i].fd < 0)
+        {
+            fprintf(stderr, "Could not connect to %s\n", endpoint.c_str());
+            return 1;
+        }
+        if (!user.empty())
+        {
+            // "OK <token> <role>" from the login, then "OK <user> <role>" from each resume
+            string response = exchange(clients[i].fd, i == 0 ? "login " + user + " " + password : "resume " + token);
+            if (response.compare(0, 3, "OK ") != 0)
+            {
+                fprintf(stderr, "Login as %s failed: %s\n", user.c_str(), response.c_str());
+                return 1;
+            }
+            if (i == 0)
+                token = response.substr(3, response.find(' ', 3) - 3);
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].fd, &ev);
+    }
+
+    vector<double> latencies;
+    latencies.reserve(requests);
+    long sent = 0;
+    size_t ok = 0;
+
+    auto send = [&](Client &client)
+    {
+        if (client.issuing)
+        {
+            client.reg = regs[rng() % regs.size()];
+            client.isbn = isbns[rng() % isbns.size()];
+        }
+        string line = (client.issuing ? "issue " : "return ") + client.reg + " " + client.isbn + "\n";
+        client.sentAt = Clock::now();
+        write(client.fd, line.data(), line.size());
+        sent++;
+    };
+
+    auto start = Clock::now();
+    for (auto &client : clients)
+        if (sent < requests)
+            send(client);
+
+    epoll_event events[256];
+    while (latencies.size() < (size_t)sent)
+    {
+        int ready = epoll_wait(epollFd, events, 256, 5000);
+        if (ready <= 0)
+        {
+            fprintf(stderr, "Timed out waiting for responses\n");
+            return 1;
+        }
+        for (int i = 0; i < ready; i++)
+        {
+            Client &client = clients[events[i].data.u32];
+            char buffer[4096];
+            ssize_t n = read(client.fd, buffer, sizeof(buffer));
+            if (n <= 0)
+            {
+                fprintf(stderr, "Server closed the connection\n");
+                return 1;
+            }
+            client.in.append(buffer, n);
+
+            size_t newline;
+            while ((newline = client.in.find('\n')) != string::npos)
+            {
+                latencies.push_back(chrono::duration<double, micro>(Clock::now() - client.sentAt).count());
+                bool success = client.in.compare(0, 2, "OK") == 0;
+                ok += success;
+                client.in.erase(0, newline + 1);
+
+                // Only follow a successful issue with its return; otherwise pick a new pair
+                client.issuing = !(client.issuing && success);
+                if (sent < requests)
+                    send(client);
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    { return latencies[min(latencies.size() - 1, (size_t)(p / 100.0 * latencies.size()))]; };
+
+    printf("%zu requests over %d connections in %.3f s: %.0f requests/sec, %zu OK\n", latencies.size(), connections,
+           seconds, latencies.size() / seconds, ok);
+    printf("latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", percentile(50), percentile(90),
+           percentile(99), percentile(99.9), latencies.back());
+
+    for (auto &client : clients)
+        close(client.fd);
+    return 0;
+}
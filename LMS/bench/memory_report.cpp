@@ -0,0 +1,131 @@
+// Memory Report
+// Builds the same synthetic books and students twice, once as the old
+// vector<Record> / vector<Student> layout (a std::string per field) and once as
+// BookTable / StudentTable over a shared StringPool (see Tables.h), and reports
+// for each:
+//   - live heap bytes per 100k records, counted by replacing operator new,
+//   - heap allocations made while loading,
+//   - the time of a pass summing every shelf count (a one-field scan).
+// Authors, first and last names repeat the way they do in a real catalog, so
+// interning has something to share; titles and emails are mostly unique.
+//
+// Build: g++ -O2 -std=c++17 -I.. memory_report.cpp -o memory_report
+// Usage: ./memory_report [records, default 1000000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <random>
+#include "LMS.h"
+
+static size_t liveBytes = 0;
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw bad_alloc();
+    liveBytes += malloc_usable_size(p);
+    allocations++;
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p)
+        liveBytes -= malloc_usable_size(p);
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    if (p)
+        liveBytes -= malloc_usable_size(p);
+    free(p);
+}
+
+typedef chrono::steady_clock Clock;
+
+struct Sample
+{
+    size_t bytes;
+    size_t allocations;
+    double scanMs;
+};
+
+void report(const char *name, const Sample &sample, size_t count)
+{
+    printf("%-28s %14.2f MB %14zu %12.2f ms\n", name, sample.bytes * 100000.0 / count / 1e6, sample.allocations,
+           sample.scanMs);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+    // The text is generated once up front so both layouts load identical rows
+    mt19937 rng(12);
+    vector<string> titles(count), authors(count), firstNames(count), lastNames(count), emails(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        titles[i] = "Title " + to_string(rng() % 10000000) + " Volume " + to_string(rng() % 20);
+        authors[i] = "Author " + to_string(rng() % 20000);
+        firstNames[i] = "First" + to_string(rng() % 2000);
+        lastNames[i] = "Last" + to_string(rng() % 5000);
+        emails[i] = "student" + to_string(i) + "@lpu.in";
+    }
+
+    Sample before, after;
+    volatile long long sink = 0;
+    {
+        size_t baseBytes = liveBytes, baseAllocations = allocations;
+        vector<Record> books;
+        vector<Student> students;
+        for (size_t i = 0; i < count; i++)
+        {
+            books.push_back(Record(titles[i], authors[i], unpackKey(9780000000000ull + i, 13), rng() % 10));
+            students.push_back(Student(firstNames[i], lastNames[i], unpackKey(10000000 + i, 8),
+                                       unpackKey(9000000000ull + i, 10), emails[i]));
+        }
+        before.bytes = liveBytes - baseBytes;
+        before.allocations = allocations - baseAllocations;
+
+        auto start = Clock::now();
+        long long total = 0;
+        for (const auto &book : books)
+            total += book.copies;
+        before.scanMs = chrono::duration<double, milli>(Clock::now() - start).count();
+        sink = sink + total;
+    }
+    {
+        size_t baseBytes = liveBytes, baseAllocations = allocations;
+        StringPool strings;
+        BookTable books;
+        StudentTable students;
+        for (size_t i = 0; i < count; i++)
+        {
+            books.add(strings, 9780000000000ull + i, rng() % 10, titles[i], authors[i]);
+            students.add(strings, 10000000 + i, 9000000000ull + i, firstNames[i], lastNames[i], emails[i]);
+        }
+        after.bytes = liveBytes - baseBytes;
+        after.allocations = allocations - baseAllocations;
+
+        auto start = Clock::now();
+        long long total = 0;
+        for (size_t i = 0; i < books.size(); i++)
+            total += books.copies(i);
+        after.scanMs = chrono::duration<double, milli>(Clock::now() - start).count();
+        sink = sink + total;
+
+        printf("%zu books + %zu students; string pool %.1f MB, of which %.1f MB arena\n\n", count, count,
+               strings.memoryUsage() / 1e6, strings.bytes() / 1e6);
+    }
+
+    printf("%-28s %17s %14s %15s\n", "layout", "per 100k records", "allocations", "copies scan");
+    report("vector<Record/Student>", before, count);
+    report("tables + string pool", after, count);
+    return 0;
+}
@@ -0,0 +1,178 @@
+// Page Cache Benchmark
+// Generates a synthetic library (default one million titles and 100k
+// students) and opens it once with all record text in memory and then with
+// the text paged to disk behind shrinking page cache budgets (see
+// PageCache.h). For each it reports the resident bytes of the rows and their
+// text (LMS::storageBytes; the indexes are the same in every mode), the time
+// to load, and per-call latency of:
+//   - issue and return over random cycles, including the checkpoints they
+//     trigger every few thousand calls (which read every title and name),
+//   - find: getBook on titles picked with Zipf-like popularity, the way
+//     lookups at a counter favour popular titles,
+// with the page cache hit rate over each phase.
+//
+// Build: cmake --build <build dir> --target page_cache_bench
+// Usage: ./page_cache_bench [books, default 1000000] [cycles, default 20000] [budgets in MB, default 0,64,16,4,1,0.25]
+//   (budget 0 keeps the text in memory)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+#include "LMS.h"
+
+typedef chrono::steady_clock Clock;
+
+struct Latencies
+{
+    vector<double> micros;
+
+    template <class Fn>
+    void time(Fn fn)
+    {
+        auto start = Clock::now();
+        fn();
+        micros.push_back(chrono::duration<double, micro>(Clock::now() - start).count());
+    }
+
+    double at(double p)
+    {
+        sort(micros.begin(), micros.end());
+        return micros.empty() ? 0 : micros[min(micros.size() - 1, (size_t)(micros.size() * p))];
+    }
+};
+
+struct CacheCounts
+{
+    uint64_t hits = 0, misses = 0;
+
+    static CacheCounts of(const LMS &library)
+    {
+        CacheCounts counts;
+        if (const PagedFile *paged = library.pageCache())
+        {
+            counts.hits = paged->hits();
+            counts.misses = paged->misses();
+        }
+        return counts;
+    }
+
+    // Hit rate since before, as a percentage (100 with the text in memory)
+    double rateSince(const CacheCounts &before) const
+    {
+        uint64_t h = hits - before.hits, m = misses - before.misses;
+        return h + m ? 100.0 * h / (h + m) : 100.0;
+    }
+};
+
+uint64_t bookKey(size_t i)
+{
+    return 9780000000000ull + i;
+}
+
+uint32_t studentKey(size_t i)
+{
+    return 10000000 + (uint32_t)i;
+}
+
+void generate(const string &dir, size_t books, size_t students)
+{
+    static const char *words[] = {"History", "Garden", "River", "Night", "Code", "Empire", "Stone", "Winter", "Light",
+                                  "Ocean", "Machine", "Silent", "Golden", "Storm", "City", "Forest"};
+    mt19937 rng(2024);
+    DurableWriter bookFile(dir + "/books.txt");
+    for (size_t i = 0; i < books; i++)
+    {
+        bookFile.append(words[rng() % 16]).append(' ').append(words[rng() % 16]).append(' ');
+        bookFile.appendNumber(rng() % 100000).append(",Author ").appendNumber(rng() % 50000).append(',');
+        bookFile.appendNumber(bookKey(i), 13).append(' ').appendNumber(1 + rng() % 10).append('\n');
+    }
+    bookFile.commit();
+    DurableWriter studentFile(dir + "/students.txt");
+    for (size_t i = 0; i < students; i++)
+    {
+        studentFile.append("First").appendNumber(rng() % 2000).append(" Last").appendNumber(rng() % 5000).append(' ');
+        studentFile.appendNumber(studentKey(i), 8).append(' ').appendNumber(9000000000ull + i, 10).append(" s");
+        studentFile.appendNumber(i).append("@lpu.in\n");
+    }
+    studentFile.commit();
+}
+
+int main(int argc, char *argv[])
+{
+    size_t books = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t cycles = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000;
+    vector<double> budgets = {0, 64, 16, 4, 1, 0.25};
+    if (argc > 3)
+    {
+        budgets.clear();
+        stringstream list(argv[3]);
+        string item;
+        while (getline(list, item, ','))
+            budgets.push_back(atof(item.c_str()));
+    }
+    books = max<size_t>(books, 1);
+    size_t students = max<size_t>(books / 10, 1);
+
+    char pattern[] = "/tmp/lms-page-cache-XXXXXX";
+    string dir = mkdtemp(pattern);
+    generate(dir, books, students);
+    printf("%zu books, %zu students in %s\n\n", books, students, dir.c_str());
+
+    // Zipf-like: title r is looked up with probability roughly proportional to 1/(r+1)
+    mt19937 rng(7);
+    auto popularTitle = [&]()
+    { return (size_t)exp(uniform_real_distribution<double>(0, log((double)books))(rng)) - 1; };
+
+    printf("%-10s %10s %8s | %-30s %7s | %-26s %7s\n", "budget", "resident", "load", "issue+return p50/p99/max (us)",
+           "hits", "find p50/p99/max (us)", "hits");
+    for (double megabytes : budgets)
+    {
+        size_t budget = (size_t)(megabytes * 1024 * 1024);
+        auto loadStart = Clock::now();
+        unique_ptr<LMS> library(new LMS(dir, false, false, budget));
+        double loadSeconds = chrono::duration<double>(Clock::now() - loadStart).count();
+
+        Latencies circulation;
+        CacheCounts before = CacheCounts::of(*library);
+        for (size_t i = 0; i < cycles; i++)
+        {
+            string reg = to_string(studentKey(rng() % students));
+            string isbn = to_string(bookKey(rng() % books));
+            Status status = Status::Ok;
+            circulation.time([&]()
+                             { status = library->issueBook(reg, isbn); });
+            if (status == Status::Ok)
+                circulation.time([&]()
+                                 { library->returnBook(reg, isbn); });
+        }
+        double circulationHits = CacheCounts::of(*library).rateSince(before);
+
+        Latencies find;
+        before = CacheCounts::of(*library);
+        for (size_t i = 0; i < cycles; i++)
+        {
+            string isbn = to_string(bookKey(popularTitle()));
+            find.time([&]()
+                      { library->getBook(isbn); });
+        }
+        double findHits = CacheCounts::of(*library).rateSince(before);
+
+        char label[32], resident[32], first[64], second[64];
+        snprintf(label, sizeof(label), megabytes ? "%g MB" : "in memory", megabytes);
+        snprintf(resident, sizeof(resident), "%.1f MB", library->storageBytes() / 1048576.0);
+        snprintf(first, sizeof(first), "%.1f / %.1f / %.0f", circulation.at(0.5), circulation.at(0.99), circulation.at(1));
+        snprintf(second, sizeof(second), "%.1f / %.1f / %.0f", find.at(0.5), find.at(0.99), find.at(1));
+        printf("%-10s %10s %7.2fs | %-30s %6.1f%% | %-26s %6.1f%%\n", label, resident, loadSeconds, first, circulationHits,
+               second, findHits);
+        fflush(stdout);
+    }
+
+    filesystem::remove_all(dir);
+    return 0;
+}
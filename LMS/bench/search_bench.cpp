@@ -0,0 +1,291 @@
+// Search Benchmark
+// Builds a SearchIndex over N synthetic titles (default one million) drawn
+// from a Zipf-like vocabulary, so common words have long posting lists the
+// way "the" and "of" do in a real catalog. Then it times single-word,
+// prefix and multi-word queries (the last word of a query is a prefix unless
+// followed by a space) against a linear scan of the same data, and
+// misspelt queries (words of real titles with a typo) through fuzzySearch
+// against a scan that computes the edit distance to every title's words.
+// Every indexed result is checked against the scan.
+//
+// Build: g++ -O2 -std=c++17 -I.. search_bench.cpp -o search_bench
+// Usage: ./search_bench [titles, default 1000000] [queries per kind, default 2000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SearchIndex.h"
+
+using namespace std;
+
+struct Book
+{
+    string bookName;
+    string author;
+};
+
+const int VOCABULARY = 50000;
+
+string wordFor(int i)
+{
+    static const char *syllables[] = {"ka", "lo", "mi", "ren", "sa", "tor", "vel", "dun", "ar", "is", "pe", "qu"};
+    string word;
+    do
+    {
+        word += syllables[i % 12];
+        i /= 12;
+    } while (i > 0);
+    return word;
+}
+
+// True if the book contains every query word, the last one as a prefix if lastIsPrefix (the reference answer)
+bool scanMatches(const Book &book, const vector<string> &query, bool lastIsPrefix)
+{
+    vector<string> words = SearchIndex::tokenize(book.bookName + " " + book.author);
+    for (size_t i = 0; i < query.size(); i++)
+    {
+        bool found = false;
+        for (const auto &w : words)
+            if (lastIsPrefix && i + 1 == query.size() ? w.compare(0, query[i].size(), query[i]) == 0 : w == query[i])
+            {
+                found = true;
+                break;
+            }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+// Plain optimal string alignment distance, the reference for fuzzySearch
+int editDistance(const string &a, const string &b)
+{
+    vector<vector<int>> d(a.size() + 1, vector<int>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); i++)
+        for (size_t j = 0; j <= b.size(); j++)
+        {
+            if (i == 0 || j == 0)
+            {
+                d[i][j] = (int)(i + j);
+                continue;
+            }
+            d[i][j] = min({d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + (a[i - 1] != b[j - 1])});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                d[i][j] = min(d[i][j], d[i - 2][j - 2] + 1);
+        }
+    return d[a.size()][b.size()];
+}
+
+// Total edits from the query words to the book's closest words, or -1 if a
+// query word has no word within its allowance (see SearchIndex::fuzzySearch)
+int scanDistance(const Book &book, const vector<string> &query)
+{
+    vector<string> words = SearchIndex::tokenize(book.bookName + " " + book.author);
+    int total = 0;
+    for (const auto &q : query)
+    {
+        int allowed = q.size() <= 3 ? 0 : q.size() <= 7 ? 1 : 2;
+        int best = allowed + 1;
+        for (const auto &w : words)
+            if ((int)w.size() - (int)q.size() <= allowed && (int)q.size() - (int)w.size() <= allowed)
+                best = min(best, editDistance(q, w));
+        if (best > allowed)
+            return -1;
+        total += best;
+    }
+    return total;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t titles = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    int queries = argc > 2 ? atoi(argv[2]) : 2000;
+
+    mt19937 rng(42);
+    // Zipf-like: word rank r is drawn with probability roughly proportional to 1/r
+    auto randomWord = [&]()
+    { return wordFor((int)(exp(uniform_real_distribution<double>(0, log((double)VOCABULARY))(rng))) - 1); };
+
+    vector<Book> books(titles);
+    unordered_map<uint64_t, size_t> byKey;
+    for (size_t i = 0; i < titles; i++)
+    {
+        int words = 2 + rng() % 4;
+        for (int w = 0; w < words; w++)
+            books[i].bookName += (w ? " " : "") + randomWord();
+        books[i].author = randomWord() + " " + randomWord();
+        byKey[9780000000000ull + i] = i;
+    }
+
+    auto start = chrono::steady_clock::now();
+    SearchIndex index;
+    for (size_t i = 0; i < titles; i++)
+        index.add(9780000000000ull + i, books[i].bookName, books[i].author);
+    double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%zu titles, %zu distinct words, index built in %.2f s\n\n", titles, index.termCount(), buildSeconds);
+
+    auto lookup = [&](uint64_t key, string_view &name, string_view &author)
+    {
+        auto it = byKey.find(key);
+        if (it == byKey.end())
+            return false;
+        name = books[it->second].bookName;
+        author = books[it->second].author;
+        return true;
+    };
+
+    struct Kind
+    {
+        const char *name;
+        function<string()> make;
+    };
+    vector<Kind> kinds = {
+        {"one word", [&]() { return randomWord(); }},
+        {"prefix (3 chars)", [&]() { return randomWord().substr(0, 3); }},
+        {"two words", [&]() { return randomWord() + " " + randomWord() + " "; }},
+        {"word + prefix", [&]() { return randomWord() + " " + randomWord(); }},
+        {"title + author", [&]()
+         {
+             const Book &book = books[rng() % titles];
+             return SearchIndex::tokenize(book.bookName)[0] + " " + SearchIndex::tokenize(book.author)[0].substr(0, 4);
+         }},
+    };
+
+    bool ok = true;
+    printf("%-18s %12s %12s %12s %12s %14s\n", "query", "mean (us)", "p99 (us)", "max (us)", "avg hits", "scan (ms)");
+    for (auto &kind : kinds)
+    {
+        vector<double> times;
+        size_t hits = 0;
+        double scanTotal = 0;
+        int scanned = 0;
+        for (int q = 0; q < queries; q++)
+        {
+            string query = kind.make();
+            auto t0 = chrono::steady_clock::now();
+            vector<uint64_t> results = index.search(query, 20, lookup);
+            double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+            times.push_back(us);
+            hits += results.size();
+
+            vector<string> words = SearchIndex::tokenize(query);
+            bool lastIsPrefix = query.back() != ' ';
+            for (uint64_t key : results)
+                if (!scanMatches(books[byKey[key]], words, lastIsPrefix))
+                    ok = false;
+
+            // A full scan is slow, so only a few queries are compared against it
+            if (q < 5)
+            {
+                auto s0 = chrono::steady_clock::now();
+                size_t expected = 0;
+                for (const auto &book : books)
+                    expected += scanMatches(book, words, lastIsPrefix);
+                scanTotal += chrono::duration<double, milli>(chrono::steady_clock::now() - s0).count();
+                scanned++;
+                if (results.size() != min<size_t>(expected, 20))
+                    ok = false;
+            }
+        }
+        sort(times.begin(), times.end());
+        double total = 0;
+        for (double us : times)
+            total += us;
+        printf("%-18s %12.1f %12.1f %12.1f %12.1f %14.1f\n", kind.name, total / queries, times[times.size() * 99 / 100],
+               times.back(), (double)hits / queries, scanTotal / scanned);
+    }
+
+    // One typo (a changed, missing, extra or swapped letter) in a word of 4 or more letters
+    auto misspell = [&](string word)
+    {
+        if (word.size() < 4)
+            return word;
+        size_t at = 1 + rng() % (word.size() - 2);
+        switch (rng() % 4)
+        {
+        case 0:
+            word[at] = (char)('a' + rng() % 26);
+            break;
+        case 1:
+            word.erase(at, 1);
+            break;
+        case 2:
+            word.insert(word.begin() + at, (char)('a' + rng() % 26));
+            break;
+        default:
+            swap(word[at], word[at + 1]);
+        }
+        return word;
+    };
+    vector<Kind> fuzzyKinds = {
+        {"typo, one word", [&]() { return misspell(SearchIndex::tokenize(books[rng() % titles].bookName)[0]); }},
+        {"typos, title+author", [&]()
+         {
+             const Book &book = books[rng() % titles];
+             return misspell(SearchIndex::tokenize(book.bookName)[0]) + " " + misspell(SearchIndex::tokenize(book.author)[0]);
+         }},
+    };
+    printf("\n%-20s %10s %12s %12s %12s %14s\n", "fuzzy query", "mean (us)", "p99 (us)", "max (us)", "avg hits", "scan (ms)");
+    for (auto &kind : fuzzyKinds)
+    {
+        vector<double> times;
+        size_t hits = 0;
+        double scanTotal = 0;
+        int scanned = 0;
+        for (int q = 0; q < queries; q++)
+        {
+            string query = kind.make();
+            auto t0 = chrono::steady_clock::now();
+            vector<SearchIndex::FuzzyMatch> results = index.fuzzySearch(query, 20);
+            double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+            times.push_back(us);
+            hits += results.size();
+
+            vector<string> words = SearchIndex::tokenize(query);
+            sort(words.begin(), words.end());
+            words.erase(unique(words.begin(), words.end()), words.end());
+            for (const auto &match : results)
+                if (scanDistance(books[byKey[match.key]], words) != match.distance)
+                    ok = false;
+
+            // The scan computes an edit distance per word of every title, so it is slower still
+            if (q < 3)
+            {
+                auto s0 = chrono::steady_clock::now();
+                vector<int> expected;
+                for (const auto &book : books)
+                    if (int distance = scanDistance(book, words); distance >= 0)
+                        expected.push_back(distance);
+                scanTotal += chrono::duration<double, milli>(chrono::steady_clock::now() - s0).count();
+                scanned++;
+                sort(expected.begin(), expected.end());
+                expected.resize(min<size_t>(expected.size(), 20));
+                for (size_t i = 0; i < expected.size() && i < results.size(); i++)
+                    if (results[i].distance != expected[i])
+                        ok = false;
+                if (results.size() != expected.size())
+                    ok = false;
+            }
+        }
+        sort(times.begin(), times.end());
+        double total = 0;
+        for (double us : times)
+            total += us;
+        printf("%-20s %10.1f %12.1f %12.1f %12.1f %14.1f\n", kind.name, total / queries, times[times.size() * 99 / 100],
+               times.back(), (double)hits / queries, scanTotal / scanned);
+    }
+
+    if (!ok)
+    {
+        printf("\nFAIL: indexed results disagree with the linear scan\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Validation Microbenchmark
+// Compares three ways of validating registration input:
+//   regex-per-call  - std::regex constructed for every check (the old addStudent/addBook path)
+//   regex-compiled  - std::regex compiled once and reused
+//   scanner         - the lookup-table scanners in Validation.h
+// All three must agree on every input; the program exits non-zero if they do not.
+//
+// Build: g++ -O2 -std=c++17 -I.. validation_bench.cpp -o validation_bench
+// Usage: ./validation_bench [inputs per field, default 20000]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <regex>
+#include <chrono>
+#include <random>
+#include <functional>
+#include "Validation.h"
+
+using namespace std;
+
+const char *EMAIL_PATTERN = "^[a-zA-Z0-9._%+-]+@(gmail\\.com|outlook\\.com|lpu\\.in)$";
+const char *BOOK_PATTERN = "^[a-zA-Z0-9 .,-]+$";
+const char *AUTHOR_PATTERN = "^[a-zA-Z .,-]+$";
+
+string randomText(mt19937 &rng, const string &alphabet, int minLength, int maxLength)
+{
+    uniform_int_distribution<int> length(minLength, maxLength);
+    uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    string text;
+    for (int i = length(rng); i > 0; i--)
+        text += alphabet[pick(rng)];
+    return text;
+}
+
+// Roughly 80% valid inputs, the rest with one character from outside the allowed set
+vector<string> makeEmails(mt19937 &rng, int count)
+{
+    const string local = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._%+-";
+    const string domains[] = {"@gmail.com", "@outlook.com", "@lpu.in", "@yahoo.com"};
+    vector<string> emails;
+    for (int i = 0; i < count; i++)
+    {
+        string email = randomText(rng, local, 3, 20) + domains[rng() % 4];
+        if (rng() % 10 == 0)
+            email[0] = '#';
+        emails.push_back(email);
+    }
+    return emails;
+}
+
+vector<string> makeNames(mt19937 &rng, int count, const string &alphabet)
+{
+    vector<string> names;
+    for (int i = 0; i < count; i++)
+    {
+        string name = randomText(rng, alphabet, 5, 40);
+        if (rng() % 5 == 0)
+            name[name.size() / 2] = '!';
+        names.push_back(name);
+    }
+    return names;
+}
+
+struct Result
+{
+    double nsPerCheck;
+    size_t accepted;
+};
+
+Result run(const vector<string> &inputs, const function<bool(const string &)> &check)
+{
+    auto start = chrono::steady_clock::now();
+    size_t accepted = 0;
+    for (const auto &input : inputs)
+        accepted += check(input);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return {ns / inputs.size(), accepted};
+}
+
+bool compare(const string &field, const vector<string> &inputs, const char *pattern,
+             bool (*scanner)(const string &))
+{
+    regex compiled(pattern);
+    Result perCall = run(inputs, [&](const string &s) { return regex_match(s, regex(pattern)); });
+    Result once = run(inputs, [&](const string &s) { return regex_match(s, compiled); });
+    Result scan = run(inputs, scanner);
+
+    cout << left << setw(10) << field << right << fixed << setprecision(1)
+         << setw(18) << perCall.nsPerCheck << setw(18) << once.nsPerCheck << setw(14) << scan.nsPerCheck
+         << setw(12) << perCall.nsPerCheck / scan.nsPerCheck << "x\n";
+
+    if (perCall.accepted != scan.accepted || once.accepted != scan.accepted)
+    {
+        cerr << "Mismatch on " << field << ": regex accepted " << perCall.accepted
+             << ", scanner accepted " << scan.accepted << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? stoi(argv[1]) : 20000;
+    mt19937 rng(42);
+
+    auto emails = makeEmails(rng, count);
+    auto books = makeNames(rng, count, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,-");
+    auto authors = makeNames(rng, count, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ .,-");
+
+    cout << count << " inputs per field, ns per check\n";
+    cout << left << setw(10) << "Field" << right << setw(18) << "regex-per-call" << setw(18) << "regex-compiled"
+         << setw(14) << "scanner" << setw(13) << "speedup\n";
+
+    bool ok = compare("email", emails, EMAIL_PATTERN, isValidEmail);
+    ok = compare("book", books, BOOK_PATTERN, isValidBookName) && ok;
+    ok = compare("author", authors, AUTHOR_PATTERN, isValidAuthorName) && ok;
+    return ok ? 0 : 1;
+}